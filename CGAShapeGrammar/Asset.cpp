@@ -1,14 +1,111 @@
 #include "Asset.h"
+#include <algorithm>
+#include <limits>
+#include <map>
 
 namespace cga {
 
 Asset::Asset() {
+	hasTexCoords = false;
 }
 
 Asset::Asset(const std::vector<std::vector<glm::vec3> >& points, const std::vector<std::vector<glm::vec3> >& normals, const std::vector<std::vector<glm::vec2> >& texCoords) {
 	this->points = points;
 	this->normals = normals;
 	this->texCoords = texCoords;
+	this->hasTexCoords = !texCoords.empty();
+	this->bbox = glutils::BoundingBox(points);
 }
 
-}
\ No newline at end of file
+/**
+ * Triangulate the polygons into the mesh that is shared by all the instances of this asset.
+ */
+void Asset::buildMesh() {
+	std::vector<Vertex> vertices;
+	for (int i = 0; i < points.size(); ++i) {
+		if (points[i].size() < 3) continue;
+
+		const glm::vec2* tcs = (i < texCoords.size() && texCoords[i].size() == points[i].size()) ? &texCoords[i][0] : NULL;
+		glutils::drawTransformedPolygon(&points[i][0], points[i].size(), glm::vec4(1, 1, 1, 1), tcs, vertices);
+	}
+
+	mesh = boost::shared_ptr<const glutils::Mesh>(new glutils::Mesh(vertices));
+}
+
+/**
+ * Generate the simplified variants of this asset.
+ * The grid resolution is halved for each level, e.g., 16, 8, 4 for the resolution 16 and three levels.
+ */
+void Asset::generateLODs(int numLevels, int resolution) {
+	lods.clear();
+	for (int i = 0; i < numLevels && resolution >= 1; ++i, resolution /= 2) {
+		boost::shared_ptr<Asset> lod = simplify(resolution);
+		lod->buildMesh();
+		lods.push_back(lod);
+	}
+}
+
+/**
+ * Simplify the asset by vertex clustering.
+ * All the vertices in the same cell of the resolution^3 grid are merged into their average,
+ * and the polygons that degenerate to less than three vertices are removed.
+ */
+boost::shared_ptr<Asset> Asset::simplify(int resolution) const {
+	boost::shared_ptr<Asset> lod(new Asset());
+
+	glm::vec3 minPt(std::numeric_limits<float>::max());
+	glm::vec3 maxPt(-std::numeric_limits<float>::max());
+	for (int i = 0; i < points.size(); ++i) {
+		for (int k = 0; k < points[i].size(); ++k) {
+			minPt = glm::min(minPt, points[i][k]);
+			maxPt = glm::max(maxPt, points[i][k]);
+		}
+	}
+	glm::vec3 cellSize = (maxPt - minPt) / (float)resolution;
+
+	// assign each vertex to a cell
+	std::vector<std::vector<int> > cells(points.size());
+	std::map<int, std::pair<glm::vec3, int> > clusters;
+	for (int i = 0; i < points.size(); ++i) {
+		cells[i].resize(points[i].size());
+		for (int k = 0; k < points[i].size(); ++k) {
+			int c[3];
+			for (int d = 0; d < 3; ++d) {
+				c[d] = cellSize[d] > 0 ? std::min(resolution - 1, (int)((points[i][k][d] - minPt[d]) / cellSize[d])) : 0;
+			}
+			cells[i][k] = (c[2] * resolution + c[1]) * resolution + c[0];
+
+			std::pair<glm::vec3, int>& cluster = clusters[cells[i][k]];
+			cluster.first += points[i][k];
+			cluster.second++;
+		}
+	}
+
+	// build the simplified polygons
+	for (int i = 0; i < points.size(); ++i) {
+		std::vector<glm::vec3> pts;
+		std::vector<glm::vec3> ns;
+		std::vector<glm::vec2> tcs;
+		std::vector<int> ids;
+		for (int k = 0; k < points[i].size(); ++k) {
+			if (!ids.empty() && (ids.back() == cells[i][k] || ids.front() == cells[i][k])) continue;
+
+			const std::pair<glm::vec3, int>& cluster = clusters[cells[i][k]];
+			ids.push_back(cells[i][k]);
+			pts.push_back(cluster.first / (float)cluster.second);
+			if (i < normals.size() && k < normals[i].size()) ns.push_back(normals[i][k]);
+			if (i < texCoords.size() && k < texCoords[i].size()) tcs.push_back(texCoords[i][k]);
+		}
+
+		if (pts.size() < 3) continue;
+
+		lod->points.push_back(pts);
+		lod->normals.push_back(ns);
+		if (!texCoords.empty()) lod->texCoords.push_back(tcs);
+	}
+	lod->hasTexCoords = hasTexCoords;
+
+	return lod;
+}
+
+}
@@ -3,18 +3,34 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <vector>
+#include <boost/shared_ptr.hpp>
+#include "GLUtils.h"
 
 namespace cga {
 
+/**
+ * An inserted OBJ model. The polygons are empty if the asset is loaded from AssetCache, which stores only the meshes.
+ */
 class Asset {
 public:
 	std::vector<std::vector<glm::vec3> > points;
 	std::vector<std::vector<glm::vec3> > normals;
 	std::vector<std::vector<glm::vec2> > texCoords;
+	glutils::BoundingBox bbox;
+	bool hasTexCoords;
+
+	/** simplified variants, lods[i] is used for the level i + 1 */
+	std::vector<boost::shared_ptr<const Asset> > lods;
+
+	/** triangulated mesh shared by all the instances of this asset */
+	boost::shared_ptr<const glutils::Mesh> mesh;
 
 public:
 	Asset();
 	Asset(const std::vector<std::vector<glm::vec3> >& points, const std::vector<std::vector<glm::vec3> >& normals, const std::vector<std::vector<glm::vec2> >& texCoords);
+	void buildMesh();
+	void generateLODs(int numLevels, int resolution);
+	boost::shared_ptr<Asset> simplify(int resolution) const;
 };
 
 }
@@ -0,0 +1,217 @@
+#include "AssetCache.h"
+#include <cstring>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace cga {
+
+namespace {
+
+const char MAGIC[4] = { 'C', 'G', 'A', 'A' };
+const unsigned int VERSION = 3;
+
+/**
+ * Header of a cache file, which is followed by
+ *   MeshInfo meshes[numMeshes] (the mesh of the asset followed by those of its LODs)
+ *   Vertex vertices[the sum of the numbers of the vertices of the meshes]
+ */
+struct Header {
+	char magic[4];
+	unsigned int version;
+	long long sourceSize;
+	unsigned long long sourceHash;
+	unsigned int vertexSize;
+	unsigned int numLevels;
+	unsigned int lodResolution;
+	unsigned int hasTexCoords;
+	float bbox[6];
+	unsigned int numMeshes;
+	unsigned int reserved;
+};
+
+struct MeshInfo {
+	unsigned int numVertices;
+	float bbox[6];
+};
+
+void putBoundingBox(const glutils::BoundingBox& bbox, float* values) {
+	values[0] = bbox.minPt.x;
+	values[1] = bbox.minPt.y;
+	values[2] = bbox.minPt.z;
+	values[3] = bbox.maxPt.x;
+	values[4] = bbox.maxPt.y;
+	values[5] = bbox.maxPt.z;
+}
+
+glutils::BoundingBox getBoundingBox(const float* values) {
+	glutils::BoundingBox bbox;
+	bbox.minPt = glm::vec3(values[0], values[1], values[2]);
+	bbox.maxPt = glm::vec3(values[3], values[4], values[5]);
+	return bbox;
+}
+
+/**
+ * Hash the contents of the file, or return false if it cannot be read.
+ */
+bool hashFile(const QString& filename, unsigned long long& result) {
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly)) return false;
+
+	if (file.size() == 0) {
+		result = AssetCache::hash(NULL, 0);
+		return true;
+	}
+
+	uchar* data = file.map(0, file.size());
+	if (data != NULL) {
+		result = AssetCache::hash((const char*)data, file.size());
+	}
+	else {
+		QByteArray contents = file.readAll();
+		result = AssetCache::hash(contents.constData(), contents.size());
+	}
+	return true;
+}
+
+}
+
+bool AssetCache::enabled = false;
+std::string AssetCache::directory;
+
+/**
+ * Load the asset with its mesh and the meshes of its LODs from the cache, which are copied from the mapped file
+ * in a single block each. The polygons are not restored, since nothing uses them once the meshes are built.
+ * The entry is looked up by the hash of the contents of the source, which is cheap compared with parsing the text.
+ * Return false if the cache is disabled, or the entry does not exist, is broken, or has the LODs of other settings.
+ */
+bool AssetCache::load(const std::string& filename, int numLevels, int lodResolution, Asset& asset) {
+	if (!enabled) return false;
+
+	QFileInfo source(filename.c_str());
+	unsigned long long sourceHash;
+	if (!source.exists() || !hashFile(source.filePath(), sourceHash)) return false;
+
+	QFile file(cachePath(sourceHash).c_str());
+	if (!file.open(QIODevice::ReadOnly) || file.size() < sizeof(Header)) return false;
+
+	uchar* data = file.map(0, file.size());
+	if (data == NULL) return false;
+
+	const Header& header = *(const Header*)data;
+	if (memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION || header.vertexSize != sizeof(Vertex)) return false;
+	if (header.sourceSize != source.size() || header.sourceHash != sourceHash) return false;
+	if (header.numLevels != numLevels || header.lodResolution != lodResolution || header.numMeshes == 0) return false;
+	if (sizeof(Header) + sizeof(MeshInfo) * (long long)header.numMeshes > file.size()) return false;
+
+	const MeshInfo* meshes = (const MeshInfo*)(data + sizeof(Header));
+	const Vertex* vertices = (const Vertex*)(meshes + header.numMeshes);
+	long long numVertices = 0;
+	for (int i = 0; i < header.numMeshes; ++i) {
+		numVertices += meshes[i].numVertices;
+	}
+	if (sizeof(Header) + sizeof(MeshInfo) * (long long)header.numMeshes + sizeof(Vertex) * numVertices != file.size()) return false;
+
+	std::vector<boost::shared_ptr<Asset> > assets(header.numMeshes);
+	for (int i = 0; i < header.numMeshes; ++i) {
+		boost::shared_ptr<glutils::Mesh> mesh(new glutils::Mesh());
+		mesh->vertices.assign(vertices, vertices + meshes[i].numVertices);
+		mesh->bbox = getBoundingBox(meshes[i].bbox);
+		vertices += meshes[i].numVertices;
+
+		assets[i] = boost::shared_ptr<Asset>(new Asset());
+		assets[i]->mesh = mesh;
+		assets[i]->bbox = mesh->bbox;
+		assets[i]->hasTexCoords = header.hasTexCoords != 0;
+	}
+
+	asset = *assets[0];
+	asset.bbox = getBoundingBox(header.bbox);
+	asset.lods.assign(assets.begin() + 1, assets.end());
+
+	return true;
+}
+
+/**
+ * Save the asset loaded from the file to the cache together with its mesh and the meshes of its LODs,
+ * which have been generated by generateLODs(numLevels, lodResolution).
+ * The file is written to a temporary file and renamed, so that the processes sharing the cache never see a partial entry.
+ * Return false if the asset cannot be stored, e.g., its meshes are not built.
+ */
+bool AssetCache::save(const std::string& filename, int numLevels, int lodResolution, const Asset& asset) {
+	if (!enabled) return false;
+
+	QFileInfo source(filename.c_str());
+	if (!source.exists()) return false;
+
+	std::vector<boost::shared_ptr<const glutils::Mesh> > meshes(1, asset.mesh);
+	for (int i = 0; i < asset.lods.size(); ++i) {
+		meshes.push_back(asset.lods[i]->mesh);
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, 4);
+	header.version = VERSION;
+	header.sourceSize = source.size();
+	if (!hashFile(source.filePath(), header.sourceHash)) return false;
+	header.vertexSize = sizeof(Vertex);
+	header.numLevels = numLevels;
+	header.lodResolution = lodResolution;
+	header.hasTexCoords = asset.hasTexCoords ? 1 : 0;
+	putBoundingBox(asset.bbox, header.bbox);
+	header.numMeshes = meshes.size();
+	header.reserved = 0;
+
+	std::vector<MeshInfo> infos(meshes.size());
+	for (int i = 0; i < meshes.size(); ++i) {
+		if (meshes[i].get() == NULL) return false;
+
+		infos[i].numVertices = meshes[i]->vertices.size();
+		putBoundingBox(meshes[i]->bbox, infos[i].bbox);
+	}
+
+	QDir().mkpath(cacheDirectory().c_str());
+	QSaveFile file(cachePath(header.sourceHash).c_str());
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	file.write((const char*)&header, sizeof(Header));
+	file.write((const char*)&infos[0], sizeof(MeshInfo) * infos.size());
+	for (int i = 0; i < meshes.size(); ++i) {
+		if (!meshes[i]->vertices.empty()) file.write((const char*)&meshes[i]->vertices[0], sizeof(Vertex) * meshes[i]->vertices.size());
+	}
+
+	return file.commit();
+}
+
+/**
+ * Return the directory of the entries with the trailing separator.
+ */
+std::string AssetCache::cacheDirectory() {
+	if (!directory.empty()) return directory;
+
+	return (QCoreApplication::applicationDirPath() + "/cache/").toStdString();
+}
+
+/**
+ * Return the path of the cache file for the source whose contents have the hash.
+ */
+std::string AssetCache::cachePath(unsigned long long sourceHash) {
+	return cacheDirectory() + QString("%1").arg(sourceHash, 16, 16, QChar('0')).toStdString() + ".asset";
+}
+
+/**
+ * 64-bit FNV-1a hash.
+ */
+unsigned long long AssetCache::hash(const char* data, long long size) {
+	unsigned long long h = 14695981039346656037ULL;
+	for (long long i = 0; i < size; ++i) {
+		h ^= (unsigned char)data[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include "Asset.h"
+
+namespace cga {
+
+/**
+ * On-disk cache of the parsed OBJ assets.
+ * Each asset is stored as the vertices of its mesh and the meshes of its LODs in a flat binary file,
+ * named after the hash of the contents of the source OBJ file, so that an entry stays valid when the source is
+ * touched, moved, or copied, and a modified source never matches a stale entry.
+ * The cache file is memory-mapped and the meshes are copied out of it, so that neither the text is parsed
+ * nor the meshes are built again. Entries are never modified once written, so the processes can share them.
+ * The cache is disabled by default. If the directory is empty, the entries are stored in the "cache" directory
+ * next to the executable, so that they do not depend on the working directory.
+ */
+class AssetCache {
+protected:
+	AssetCache() {}
+
+public:
+	static bool enabled;
+	static std::string directory;
+
+public:
+	static bool load(const std::string& filename, int numLevels, int lodResolution, Asset& asset);
+	static bool save(const std::string& filename, int numLevels, int lodResolution, const Asset& asset);
+	static std::string cacheDirectory();
+	static std::string cachePath(unsigned long long sourceHash);
+	static unsigned long long hash(const char* data, long long size);
+};
+
+}
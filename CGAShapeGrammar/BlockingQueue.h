@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * FIFO queue of a bounded capacity shared by any number of producers and consumers.
+ * push() blocks while the queue is full, so that a fast producer cannot run ahead of the consumers
+ * without bound, and pop() blocks while the queue is empty until it is closed.
+ */
+template<class T>
+class BlockingQueue {
+private:
+	std::deque<T> items;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	int capacity;
+	bool closed;
+
+public:
+	BlockingQueue(int capacity) : capacity(capacity), closed(false) {}
+
+	/**
+	 * Add the item, and return false without adding it if the queue is closed.
+	 */
+	bool push(const T& item) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+			if (closed) return false;
+			items.push_back(item);
+		}
+		notEmpty.notify_one();
+		return true;
+	}
+
+	/**
+	 * Take the oldest item, and return false if the queue is closed and empty.
+	 */
+	bool pop(T& item) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+			if (items.empty()) return false;
+			item = items.front();
+			items.pop_front();
+		}
+		notFull.notify_one();
+		return true;
+	}
+
+	/**
+	 * Stop accepting the items. The consumers take the remaining ones, and then, pop() returns false.
+	 */
+	void close() {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			closed = true;
+		}
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+};
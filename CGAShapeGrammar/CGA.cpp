@@ -1,6 +1,8 @@
 ﻿#include "CGA.h"
 #include "GLUtils.h"
 #include "OBJLoader.h"
+#include "ThreadPool.h"
+#include "GeometryCache.h"
 #include <map>
 #include <iostream>
 #include <random>
@@ -11,6 +13,7 @@
 namespace cga {
 
 CGA::CGA() {
+	geometryCached = false;
 }
 
 /**
@@ -61,6 +64,27 @@ void CGA::setParamValues(Grammar& grammar, const std::vector<float>& params) {
 	}
 }
 
+/**
+ * Load the assets and decode the textures used by the grammar concurrently before the derivation,
+ * so that the derivation does not wait for the disk. The textures are decoded only if renderManager is given,
+ * and they are uploaded to GPU when they are used for the first time.
+ * The workers are started at the first call and reused by the later ones.
+ */
+void CGA::preload(const Grammar& grammar, RenderManager* renderManager) {
+	std::set<std::string> geometryPaths;
+	std::set<std::string> texturePaths;
+	grammar.getResources(geometryPaths, texturePaths);
+
+	if (preloadPool.get() == NULL) {
+		preloadPool = boost::shared_ptr<ThreadPool>(new ThreadPool());
+	}
+	Shape::preloadAssets(geometryPaths, *preloadPool);
+	if (renderManager != NULL) {
+		renderManager->preloadTextures(texturePaths, *preloadPool);
+	}
+	preloadPool->wait();
+}
+
 /**
  * Execute a derivation of the grammar
  */
@@ -123,13 +147,87 @@ void CGA::derive(const std::map<std::string, Grammar>& grammars, bool suppressWa
 	}
 }
 
+/**
+ * Derive the shapes, and pass the geometry of the terminal shapes to the sink as soon as they are emitted.
+ * The terminal shapes and their faces are released after each rule application, and the successors
+ * of a shape are derived before its siblings, so that the memory is bounded by the depth of
+ * the derivation instead of the size of the scene. CGA::shapes is empty afterward.
+ * Note that the face culling is applied only among the faces of the same rule application.
+ */
+void CGA::derive(const Grammar& grammar, GeometrySink& sink, bool suppressWarning) {
+	shapes.clear();
+
+	std::vector<boost::shared_ptr<glutils::Face> > faces;
+	while (!stack.empty()) {
+		boost::shared_ptr<Shape> shape = stack.front();
+		stack.pop_front();
+
+		if (grammar.contain(shape->_name)) {
+			int numShapes = stack.size();
+			grammar.getRule(shape->_name).apply(shape, grammar, stack, shapes);
+
+			// move the successors to the front of the stack
+			std::list<boost::shared_ptr<Shape> >::iterator it = stack.end();
+			std::advance(it, numShapes - (int)stack.size());
+			stack.splice(stack.begin(), stack, it, stack.end());
+		} else {
+			if (!suppressWarning && shape->_name.back() != '!' && shape->_name.back() != '.') {
+				std::cout << "Warning: " << "no rule is found for " << shape->_name << "." << std::endl;
+			}
+			shapes.push_back(shape);
+		}
+
+		if (!shapes.empty()) {
+			generateGeometry(faces);
+			sink.write(faces);
+			faces.clear();
+			shapes.clear();
+		}
+	}
+}
+
 /**
  * Generate a geometry and add it to the render manager.
+ * If the LOD policy is enabled, sub-pixel shapes are skipped and the other shapes are tessellated according to their projected sizes.
  */
 void CGA::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+	int first = faces.size();
+
 	for (int i = 0; i < shapes.size(); ++i) {
+		int lod = lodPolicy.level(shapes[i]->_pivot * shapes[i]->_modelMat, shapes[i]->_scope);
+		if (lod == LODPolicy::LOD_CULLED) continue;
+
+		shapes[i]->_lod = lod;
 		shapes[i]->generateGeometry(faces, 1.0f);
 	}
+
+	if (faceCulling.enabled) {
+		faceCulling.apply(faces, first);
+	}
+}
+
+/**
+ * Derive the grammar from the shapes in the stack, and append the geometry to the faces.
+ * If the same derivation has been done before, the geometry is loaded from GeometryCache without the derivation,
+ * in which case the stack is cleared and CGA::shapes is left empty.
+ */
+void CGA::generate(const Grammar& grammar, std::vector<boost::shared_ptr<glutils::Face> >& faces, bool suppressWarning) {
+	unsigned long long key;
+	bool cacheable = GeometryCache::key(grammar, stack, lodPolicy, faceCulling, key);
+	geometryCached = cacheable && GeometryCache::load(key, faces);
+	if (geometryCached) {
+		stack.clear();
+		shapes.clear();
+		return;
+	}
+
+	int first = faces.size();
+	derive(grammar, suppressWarning);
+	generateGeometry(faces);
+
+	if (cacheable) {
+		GeometryCache::save(key, faces, first);
+	}
 }
 
 }
@@ -7,6 +7,9 @@
 #include "Vertex.h"
 #include "Grammar.h"
 #include "Shape.h"
+#include "LODPolicy.h"
+#include "FaceCulling.h"
+#include "GeometrySink.h"
 
 namespace cga {
 
@@ -27,6 +30,12 @@ public:
 	glm::mat4 modelMat;
 	std::list<boost::shared_ptr<Shape> > stack;
 	std::vector<boost::shared_ptr<Shape> > shapes;
+	LODPolicy lodPolicy;
+	FaceCulling faceCulling;
+	/** workers that load the resources for preload() */
+	boost::shared_ptr<ThreadPool> preloadPool;
+	/** true if the last generate() loaded the geometry from GeometryCache, in which case faceCulling has no statistics */
+	bool geometryCached;
 
 public:
 	CGA();
@@ -34,9 +43,12 @@ public:
 	static std::vector<float> randomParamValues(Grammar& grammar);
 	static std::vector<std::pair<float, float> > getParamRanges(const Grammar& grammar);
 	static void setParamValues(Grammar& grammar, const std::vector<float>& params);
+	void preload(const Grammar& grammar, RenderManager* renderManager = NULL);
 	void derive(const Grammar& grammar, bool suppressWarning = false);
 	void derive(const std::map<std::string, Grammar>& grammars, bool suppressWarning = false);
+	void derive(const Grammar& grammar, GeometrySink& sink, bool suppressWarning = false);
 	void generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	void generate(const Grammar& grammar, std::vector<boost::shared_ptr<glutils::Face> >& faces, bool suppressWarning = false);
 };
 
 }
@@ -4,6 +4,8 @@
 #include "Polygon.h"
 #include "Pyramid.h"
 #include "Hemisphere.h"
+#include "LODPolicy.h"
+#include "UnitMeshCache.h"
 
 namespace cga {
 
@@ -123,12 +125,15 @@ void Circle::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fa
 	std::vector<Vertex> vertices;
 
 	glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5f, _scope.y * 0.5f, 0));
+	glm::vec3 scale(_scope.x * 0.5f, _scope.y * 0.5f, 1);
+	boost::shared_ptr<const UnitMesh> mesh = UnitMeshCache::circle(LODPolicy::slices(CIRCLE_SLICES, _lod, 6));
+
 	if (!_texture.empty() && _textureEnabled) {
-		glutils::drawCircle(_scope.x * 0.5f, _scope.y * 0.5f, _texWidth, _texHeight, mat, vertices, CIRCLE_SLICES);
+		mesh->instantiate(mat, scale, glm::vec4(1, 1, 1, 1), glm::vec2(_scope.x * 0.5f / _texWidth, _scope.y * 0.5f / _texHeight), glm::vec2(0, 0), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
 	}
 	else {
-		glutils::drawCircle(_scope.x * 0.5f, _scope.y * 0.5f, glm::vec4(_color, opacity), mat, vertices, CIRCLE_SLICES);
+		mesh->instantiate(mat, scale, glm::vec4(_color, opacity), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 }
@@ -204,6 +204,8 @@ void CornerCutPrism::split(int splitAxis, const std::vector<float>& sizes, const
 void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	// top
 	{
 		std::vector<Vertex> vertices;
@@ -230,13 +232,13 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 		points.push_back(glm::vec2(_scope.x, _scope.y));
 		points.push_back(glm::vec2(0, _scope.y));
 
-		glutils::drawPolygon(points, glm::vec4(_color, opacity), _pivot * _modelMat, vertices);
+		glutils::drawPolygon(points, glm::vec4(_color, opacity), shapeMat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
 	}
 
 	// base
 	if (_scope.z >= 0) {
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y, 0)), M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y, 0)), M_PI, glm::vec3(1, 0, 0));
 		std::vector<Vertex> vertices;
 
 		std::vector<glm::vec2> points;
@@ -272,7 +274,7 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3((_scope.x - _cut_length) * 0.5f, 0, _scope.z * 0.5f)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3((_scope.x - _cut_length) * 0.5f, 0, _scope.z * 0.5f)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x - _cut_length, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -284,7 +286,7 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -312,15 +314,15 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 				glm::vec3 n3(cosf(theta2), sinf(theta2), 0.0f);
 				glm::vec3 n4(cosf(theta1), sinf(theta1), 0.0f);
 
-				p1 = glm::vec3(_pivot * _modelMat * glm::vec4(p1, 1));
-				p2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, 1));
-				p3 = glm::vec3(_pivot * _modelMat * glm::vec4(p3, 1));
-				p4 = glm::vec3(_pivot * _modelMat * glm::vec4(p4, 1));
+				p1 = glm::vec3(shapeMat * glm::vec4(p1, 1));
+				p2 = glm::vec3(shapeMat * glm::vec4(p2, 1));
+				p3 = glm::vec3(shapeMat * glm::vec4(p3, 1));
+				p4 = glm::vec3(shapeMat * glm::vec4(p4, 1));
 
-				n1 = glm::vec3(_pivot * _modelMat * glm::vec4(p1, 0));
-				n2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, 0));
-				n3 = glm::vec3(_pivot * _modelMat * glm::vec4(p3, 0));
-				n4 = glm::vec3(_pivot * _modelMat * glm::vec4(p4, 0));
+				n1 = glm::vec3(shapeMat * glm::vec4(p1, 0));
+				n2 = glm::vec3(shapeMat * glm::vec4(p2, 0));
+				n3 = glm::vec3(shapeMat * glm::vec4(p3, 0));
+				n4 = glm::vec3(shapeMat * glm::vec4(p4, 0));
 
 				vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity)));
 				vertices.push_back(Vertex(p2, n2, glm::vec4(_color, opacity)));
@@ -346,15 +348,15 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 				glm::vec3 n3(-cosf(theta2), -sinf(theta2), 0.0f);
 				glm::vec3 n4(-cosf(theta1), -sinf(theta1), 0.0f);
 
-				p1 = glm::vec3(_pivot * _modelMat * glm::vec4(p1, 1));
-				p2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, 1));
-				p3 = glm::vec3(_pivot * _modelMat * glm::vec4(p3, 1));
-				p4 = glm::vec3(_pivot * _modelMat * glm::vec4(p4, 1));
+				p1 = glm::vec3(shapeMat * glm::vec4(p1, 1));
+				p2 = glm::vec3(shapeMat * glm::vec4(p2, 1));
+				p3 = glm::vec3(shapeMat * glm::vec4(p3, 1));
+				p4 = glm::vec3(shapeMat * glm::vec4(p4, 1));
 
-				n1 = glm::vec3(_pivot * _modelMat * glm::vec4(p1, 0));
-				n2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, 0));
-				n3 = glm::vec3(_pivot * _modelMat * glm::vec4(p3, 0));
-				n4 = glm::vec3(_pivot * _modelMat * glm::vec4(p4, 0));
+				n1 = glm::vec3(shapeMat * glm::vec4(p1, 0));
+				n2 = glm::vec3(shapeMat * glm::vec4(p2, 0));
+				n3 = glm::vec3(shapeMat * glm::vec4(p3, 0));
+				n4 = glm::vec3(shapeMat * glm::vec4(p4, 0));
 
 				vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity)));
 				vertices.push_back(Vertex(p2, n2, glm::vec4(_color, opacity)));
@@ -366,7 +368,7 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 			}
 		}
 		else {
-			glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x - _cut_length * 0.5f, _cut_length * 0.5, _scope.z * 0.5)), M_PI * 0.25f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+			glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x - _cut_length * 0.5f, _cut_length * 0.5, _scope.z * 0.5)), M_PI * 0.25f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 			glutils::drawQuad(_cut_length * sqrt(2.0f), _scope.z, glm::vec4(_color, opacity), mat, vertices);
 			faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 		}
@@ -380,7 +382,7 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 			rot_angle = -rot_angle;
 		}
 
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, (_scope.y + _cut_length) * 0.5f, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, (_scope.y + _cut_length) * 0.5f, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y - _cut_length, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -392,7 +394,7 @@ void CornerCutPrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y * 0.5f, _scope.z * 0.5f)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y * 0.5f, _scope.z * 0.5f)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
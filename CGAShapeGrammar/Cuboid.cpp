@@ -229,18 +229,20 @@ void Cuboid::split(int splitAxis, const std::vector<float>& sizes, const std::ve
 void Cuboid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	int num = 0;
 	
 	// top
 	if (_scope.x >= 0) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, _scope.z));
 		glutils::drawQuad(_scope.x, _scope.y, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 	else {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, _scope.z)), M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, _scope.z)), M_PI, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x, _scope.y, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -248,7 +250,7 @@ void Cuboid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fa
 	// base
 	if (_scope.z >= 0) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, 0));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, 0));
 		glutils::drawQuad(_scope.x, _scope.y, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -260,7 +262,7 @@ void Cuboid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fa
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -272,7 +274,7 @@ void Cuboid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fa
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, 0, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), glm::vec3(0, -_scope.y, 0)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, 0, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), glm::vec3(0, -_scope.y, 0)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -284,7 +286,7 @@ void Cuboid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fa
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -296,7 +298,7 @@ void Cuboid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fa
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(glm::rotate(_modelMat, -M_PI * 0.5f, glm::vec3(0, 0, 1)), glm::vec3(-_scope.y * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(glm::rotate(shapeMat, -M_PI * 0.5f, glm::vec3(0, 0, 1)), glm::vec3(-_scope.y * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -4,6 +4,8 @@
 #include "Rectangle.h"
 #include "CylinderSide.h"
 #include "GLUtils.h"
+#include "LODPolicy.h"
+#include "UnitMeshCache.h"
 
 namespace cga {
 
@@ -49,11 +51,15 @@ void Cylinder::comp(const std::map<std::string, std::string>& name_map, std::vec
 void Cylinder::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	int slices = LODPolicy::slices(CIRCLE_SLICES, _lod, 6);
+	boost::shared_ptr<const UnitMesh> circle = UnitMeshCache::circle(slices);
+	glm::vec3 scale(_scope.x * 0.5f, _scope.y * 0.5f, 1);
+
 	// top
 	{
 		std::vector<Vertex> vertices;
 		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, _scope.z));
-		glutils::drawCircle(_scope.x * 0.5f, _scope.y * 0.5f, glm::vec4(_color, opacity), mat, vertices, CIRCLE_SLICES);
+		circle->instantiate(mat, scale, glm::vec4(_color, opacity), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 
@@ -61,7 +67,7 @@ void Cylinder::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >&
 	if (_scope.z >= 0) {
 		std::vector<Vertex> vertices;
 		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, 0));
-		glutils::drawCircle(_scope.x * 0.5f, _scope.y * 0.5f, glm::vec4(_color, opacity), mat, vertices, CIRCLE_SLICES);
+		circle->instantiate(mat, scale, glm::vec4(_color, opacity), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 
@@ -69,7 +75,7 @@ void Cylinder::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >&
 	{
 		std::vector<Vertex> vertices;
 		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y * 0.5, 0));
-		glutils::drawCylinderZ(_scope.x * 0.5f, _scope.y * 0.5f, _scope.x * 0.5f, _scope.y * 0.5f, _scope.z, glm::vec4(_color, opacity), mat, vertices, CIRCLE_SLICES);
+		UnitMeshCache::cylinderZ(slices, _scope.z < 0)->instantiate(mat, glm::vec3(_scope.x * 0.5f, _scope.y * 0.5f, _scope.z), glm::vec4(_color, opacity), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 }
@@ -13,6 +13,8 @@
 #include "SemiCircle.h"
 #include "UShape.h"
 #include "CGA.h"
+#include "LODPolicy.h"
+#include "UnitMeshCache.h"
 
 namespace cga {
 
@@ -160,61 +162,18 @@ void CylinderSide::split(int splitAxis, const std::vector<float>& sizes, const s
 void CylinderSide::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
-	int slices = _angle / M_PI / 2.0f * CIRCLE_SLICES;
+	int slices = LODPolicy::slices(_angle / M_PI / 2.0f * CIRCLE_SLICES, _lod, 1);
 	if (slices <= 0) slices = 1;
 
 	std::vector<Vertex> vertices;
-
-	for (int i = 0; i < slices; ++i) {
-		float theta1 = (float)i / slices * _angle;
-		float theta2 = (float)(i + 1) / slices * _angle;
-
-		glm::vec3 p1(_radius_x * sinf(theta1), 0, _radius_y * cosf(theta1) - _radius_y);
-		glm::vec3 p2(_radius_x * sinf(theta2), 0, _radius_y * cosf(theta2) - _radius_y);
-		glm::vec3 p3(_radius_x * sinf(theta2), _scope.y, _radius_y * cosf(theta2) - _radius_y);
-		glm::vec3 p4(_radius_x * sinf(theta1), _scope.y, _radius_y * cosf(theta1) - _radius_y);
-
-		p1 = glm::vec3(_pivot * _modelMat * glm::vec4(p1, 1));
-		p2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, 1));
-		p3 = glm::vec3(_pivot * _modelMat * glm::vec4(p3, 1));
-		p4 = glm::vec3(_pivot * _modelMat * glm::vec4(p4, 1));
-
-		glm::vec3 n1(sinf(theta1), 0, cosf(theta1));
-		glm::vec3 n2(sinf(theta2), 0, cosf(theta2));
-		glm::vec3 n3(sinf(theta2), 0, cosf(theta2));
-		glm::vec3 n4(sinf(theta1), 0, cosf(theta1));
-
-		n1 = glm::vec3(_pivot * _modelMat * glm::vec4(n1, 0));
-		n2 = glm::vec3(_pivot * _modelMat * glm::vec4(n2, 0));
-		n3 = glm::vec3(_pivot * _modelMat * glm::vec4(n3, 0));
-		n4 = glm::vec3(_pivot * _modelMat * glm::vec4(n4, 0));
-
-		if (!_texture.empty() && _texCoords.size() >= 4) {
-			glm::vec2 t1(_texCoords[0].x + (_texCoords[1].x - _texCoords[0].x) * (float)i / slices, _texCoords[0].y);
-			glm::vec2 t2(_texCoords[0].x + (_texCoords[1].x - _texCoords[0].x) * (float)(i + 1) / slices, _texCoords[0].y);
-			glm::vec2 t3(_texCoords[0].x + (_texCoords[1].x - _texCoords[0].x) * (float)(i + 1) / slices, _texCoords[2].y);
-			glm::vec2 t4(_texCoords[0].x + (_texCoords[1].x - _texCoords[0].x) * (float)i / slices, _texCoords[2].y);
-
-			vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity), t1));
-			vertices.push_back(Vertex(p2, n2, glm::vec4(_color, opacity), t2));
-			vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity), t3));
-			vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity), t1));
-			vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity), t3));
-			vertices.push_back(Vertex(p4, n4, glm::vec4(_color, opacity), t4));
-		}
-		else {
-			vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity)));
-			vertices.push_back(Vertex(p2, n2, glm::vec4(_color, opacity)));
-			vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity)));
-			vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity)));
-			vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity)));
-			vertices.push_back(Vertex(p4, n4, glm::vec4(_color, opacity)));
-		}
-	}
+	boost::shared_ptr<const UnitMesh> mesh = UnitMeshCache::cylinderSide(slices, _angle);
+	glm::vec3 scale(_radius_x, _scope.y, _radius_y);
 
 	if (!_texture.empty() && _texCoords.size() >= 4) {
+		mesh->instantiate(_pivot * _modelMat, scale, glm::vec4(_color, opacity), glm::vec2(_texCoords[1].x - _texCoords[0].x, _texCoords[2].y - _texCoords[0].y), _texCoords[0], vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
 	} else {
+		mesh->instantiate(_pivot * _modelMat, scale, glm::vec4(_color, opacity), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 }
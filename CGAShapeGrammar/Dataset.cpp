@@ -0,0 +1,323 @@
+#include "Dataset.h"
+#include "AssetCache.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <opencv2/highgui/highgui.hpp>
+#include <QDir>
+#include <QSaveFile>
+#include <QString>
+
+namespace {
+
+const char MAGIC[4] = { 'C', 'G', 'A', 'D' };
+const unsigned int VERSION = 1;
+
+struct Header {
+	char magic[4];
+	unsigned int version;
+	unsigned int shardIndex;
+	unsigned int firstIndex;
+	unsigned int recordsPerShard;
+	unsigned int numRecords;
+	unsigned long long checksum;
+	unsigned long long dataSize;
+};
+
+struct TableEntry {
+	unsigned long long offset;
+	unsigned long long size;
+};
+
+struct RecordHeader {
+	int index;
+	int cols;
+	int rows;
+	int type;
+	unsigned int imageSize;
+	unsigned int numParams;
+};
+
+}
+
+std::string Dataset::shardPath(const std::string& directory, int shardIndex) {
+	return directory + "/" + QString("shard_%1.bin").arg(shardIndex, 4, 10, QChar('0')).toStdString();
+}
+
+std::string Dataset::manifestPath(const std::string& directory) {
+	return directory + "/manifest.txt";
+}
+
+/**
+ * Read the manifest, which has the line of "recordsPerShard <n>" followed by the line of
+ * "shard <shard index> <number of records> <checksum>" for each written shard.
+ * Return false if the manifest does not exist.
+ */
+bool Dataset::readManifest(const std::string& directory, int& recordsPerShard, std::map<int, ShardInfo>& shards) {
+	std::ifstream file(manifestPath(directory).c_str());
+	if (!file) return false;
+
+	std::string keyword;
+	if (!(file >> keyword >> recordsPerShard) || keyword != "recordsPerShard" || recordsPerShard <= 0) {
+		throw "The dataset manifest is broken: " + manifestPath(directory);
+	}
+
+	int shardIndex;
+	ShardInfo info;
+	while (file >> keyword >> shardIndex >> info.numRecords >> std::hex >> info.checksum >> std::dec) {
+		if (keyword == "shard") shards[shardIndex] = info;
+	}
+	return true;
+}
+
+DatasetWriter::DatasetWriter(const std::string& directory, int recordsPerShard, int compressionLevel) : directory(directory), recordsPerShard(recordsPerShard), compressionLevel(compressionLevel) {
+	QDir().mkpath(directory.c_str());
+
+	// resume the previous run
+	int previousRecordsPerShard;
+	if (Dataset::readManifest(directory, previousRecordsPerShard, shards) && previousRecordsPerShard != recordsPerShard) {
+		throw "The dataset has a different number of records per shard: " + directory;
+	}
+	for (auto it = shards.begin(); it != shards.end(); ) {
+		if (!QFile::exists(Dataset::shardPath(directory, it->first).c_str())) {
+			it = shards.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+DatasetWriter::~DatasetWriter() {
+	close();
+}
+
+/**
+ * Encode the image to PNG outside the lock, and add the record to its shard.
+ * The shard is written as soon as all of its records are added.
+ */
+bool DatasetWriter::write(int index, const cv::Mat& image, const std::vector<float>& paramValues) {
+	std::vector<int> params;
+	params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+	params.push_back(compressionLevel);
+	std::vector<unsigned char> data;
+	if (!cv::imencode(".png", image, data, params)) return false;
+
+	RecordHeader header;
+	header.index = index;
+	header.cols = image.cols;
+	header.rows = image.rows;
+	header.type = image.type();
+	header.imageSize = data.size();
+	header.numParams = paramValues.size();
+
+	std::string record((const char*)&header, sizeof(RecordHeader));
+	if (!data.empty()) record.append((const char*)&data[0], data.size());
+	if (!paramValues.empty()) record.append((const char*)&paramValues[0], sizeof(float) * paramValues.size());
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	int shardIndex = index / recordsPerShard;
+	Shard& shard = pendingShards[shardIndex];
+	shard.records[index] = record;
+	if (shard.records.size() < recordsPerShard) return true;
+
+	bool result = writeShard(shardIndex, shard);
+	pendingShards.erase(shardIndex);
+	return writeManifest() && result;
+}
+
+/**
+ * Return true if the sample is in a complete shard of the previous run, so that it does not have to be generated.
+ */
+bool DatasetWriter::isWritten(int index) {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	std::map<int, Dataset::ShardInfo>::iterator it = shards.find(index / recordsPerShard);
+	return it != shards.end() && it->second.numRecords == recordsPerShard;
+}
+
+/**
+ * Write the incomplete shards with the records added so far. They are written again when the job is restarted.
+ */
+void DatasetWriter::close() {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (pendingShards.empty()) return;
+
+	for (auto it = pendingShards.begin(); it != pendingShards.end(); ++it) {
+		writeShard(it->first, it->second);
+	}
+	pendingShards.clear();
+	writeManifest();
+}
+
+bool DatasetWriter::writeShard(int shardIndex, const Shard& shard) {
+	int firstIndex = shardIndex * recordsPerShard;
+
+	// the table followed by the records in the order of the indices
+	std::vector<TableEntry> table(recordsPerShard);
+	memset(&table[0], 0, sizeof(TableEntry) * table.size());
+	std::string body((const char*)&table[0], sizeof(TableEntry) * table.size());
+	for (auto it = shard.records.begin(); it != shard.records.end(); ++it) {
+		TableEntry& entry = table[it->first - firstIndex];
+		entry.offset = body.size() - sizeof(TableEntry) * table.size();
+		entry.size = it->second.size();
+		body.append(it->second);
+	}
+	memcpy(&body[0], &table[0], sizeof(TableEntry) * table.size());
+
+	Header header;
+	memcpy(header.magic, MAGIC, 4);
+	header.version = VERSION;
+	header.shardIndex = shardIndex;
+	header.firstIndex = firstIndex;
+	header.recordsPerShard = recordsPerShard;
+	header.numRecords = shard.records.size();
+	header.checksum = cga::AssetCache::hash(body.data(), body.size());
+	header.dataSize = body.size() - sizeof(TableEntry) * table.size();
+
+	QSaveFile file(Dataset::shardPath(directory, shardIndex).c_str());
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	file.write((const char*)&header, sizeof(Header));
+	file.write(body.data(), body.size());
+	if (!file.commit()) return false;
+
+	Dataset::ShardInfo info;
+	info.numRecords = header.numRecords;
+	info.checksum = header.checksum;
+	shards[shardIndex] = info;
+	return true;
+}
+
+bool DatasetWriter::writeManifest() {
+	std::ostringstream out;
+	out << "recordsPerShard " << recordsPerShard << "\n";
+	for (auto it = shards.begin(); it != shards.end(); ++it) {
+		out << "shard " << it->first << " " << it->second.numRecords << " " << std::hex << it->second.checksum << std::dec << "\n";
+	}
+
+	QSaveFile file(Dataset::manifestPath(directory).c_str());
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	std::string text = out.str();
+	file.write(text.data(), text.size());
+	return file.commit();
+}
+
+DatasetReader::DatasetReader(const std::string& directory) : directory(directory) {
+	if (!Dataset::readManifest(directory, recordsPerShard, shards)) {
+		throw "No dataset is found: " + directory;
+	}
+}
+
+/**
+ * Return the number of the samples in the dataset.
+ */
+int DatasetReader::size() const {
+	int result = 0;
+	for (auto it = shards.begin(); it != shards.end(); ++it) {
+		result += it->second.numRecords;
+	}
+	return result;
+}
+
+bool DatasetReader::contains(int index) {
+	const unsigned char* record;
+	unsigned long long recordSize;
+	return findRecord(index, record, recordSize);
+}
+
+/**
+ * Read the image and the parameter values of the sample.
+ * Return false if the sample does not exist or is broken.
+ */
+bool DatasetReader::read(int index, cv::Mat& image, std::vector<float>& paramValues) {
+	const unsigned char* record;
+	unsigned long long recordSize;
+	if (!findRecord(index, record, recordSize) || recordSize < sizeof(RecordHeader)) return false;
+
+	RecordHeader header;
+	memcpy(&header, record, sizeof(RecordHeader));
+	if (header.index != index || sizeof(RecordHeader) + header.imageSize + sizeof(float) * (unsigned long long)header.numParams != recordSize) return false;
+
+	cv::Mat data(1, header.imageSize, CV_8U, (void*)(record + sizeof(RecordHeader)));
+	image = cv::imdecode(data, CV_LOAD_IMAGE_UNCHANGED);
+	if (image.empty()) return false;
+
+	paramValues.resize(header.numParams);
+	if (header.numParams > 0) {
+		memcpy(&paramValues[0], record + sizeof(RecordHeader) + header.imageSize, sizeof(float) * header.numParams);
+	}
+	return true;
+}
+
+/**
+ * Return true if the checksum of the shard matches both its header and the manifest.
+ */
+bool DatasetReader::verify(int shardIndex) {
+	std::map<int, Dataset::ShardInfo>::iterator it = shards.find(shardIndex);
+	if (it == shards.end()) return false;
+
+	long long size;
+	const unsigned char* data = mapShard(shardIndex, size);
+	if (data == NULL) return false;
+
+	const Header& header = *(const Header*)data;
+	return header.numRecords == it->second.numRecords && header.checksum == it->second.checksum
+		&& cga::AssetCache::hash((const char*)data + sizeof(Header), size - sizeof(Header)) == header.checksum;
+}
+
+bool DatasetReader::verify() {
+	for (auto it = shards.begin(); it != shards.end(); ++it) {
+		if (!verify(it->first)) return false;
+	}
+	return true;
+}
+
+/**
+ * Memory-map the shard, and return NULL if it does not exist or its header is invalid.
+ */
+const unsigned char* DatasetReader::mapShard(int shardIndex, long long& size) {
+	std::map<int, MappedShard>::iterator it = mappedShards.find(shardIndex);
+	if (it == mappedShards.end()) {
+		MappedShard shard;
+		shard.file = boost::shared_ptr<QFile>(new QFile(Dataset::shardPath(directory, shardIndex).c_str()));
+		shard.data = NULL;
+		shard.size = 0;
+		if (shard.file->open(QIODevice::ReadOnly) && shard.file->size() >= sizeof(Header)) {
+			shard.size = shard.file->size();
+			shard.data = shard.file->map(0, shard.size);
+		}
+
+		// a broken shard is remembered as NULL
+		if (shard.data != NULL) {
+			const Header& header = *(const Header*)shard.data;
+			if (memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION || header.shardIndex != shardIndex || header.recordsPerShard != recordsPerShard
+				|| sizeof(Header) + sizeof(TableEntry) * (unsigned long long)recordsPerShard + header.dataSize != shard.size) {
+				shard.data = NULL;
+			}
+		}
+		it = mappedShards.insert(std::make_pair(shardIndex, shard)).first;
+	}
+
+	size = it->second.size;
+	return it->second.data;
+}
+
+bool DatasetReader::findRecord(int index, const unsigned char*& record, unsigned long long& recordSize) {
+	if (index < 0 || shards.find(index / recordsPerShard) == shards.end()) return false;
+
+	long long size;
+	const unsigned char* data = mapShard(index / recordsPerShard, size);
+	if (data == NULL) return false;
+
+	const Header& header = *(const Header*)data;
+	TableEntry entry;
+	memcpy(&entry, data + sizeof(Header) + sizeof(TableEntry) * (index - header.firstIndex), sizeof(TableEntry));
+	if (entry.size == 0 || entry.offset + entry.size > header.dataSize) return false;
+
+	record = data + sizeof(Header) + sizeof(TableEntry) * recordsPerShard + entry.offset;
+	recordSize = entry.size;
+	return true;
+}
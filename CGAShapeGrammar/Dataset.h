@@ -0,0 +1,98 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <opencv2/core/core.hpp>
+#include <QFile>
+#include "ImageSink.h"
+
+/**
+ * Dataset of the rendered images and their parameter values packed into shards.
+ * The i-th shard, shard_0000.bin, ..., holds the samples of the indices from i * recordsPerShard, and consists of
+ *   header:  "CGAD", version, shard index, first index, recordsPerShard, number of records, checksum, data size
+ *   table:   offset and size of the record of each index in the data, where the size is 0 if it is missing
+ *   data:    records of index, width, height, OpenCV type, PNG size, number of parameters, PNG, float32 parameters
+ * The checksum is the hash of the table and the data.
+ * manifest.txt lists the written shards, so that a restarted job skips the samples of the completed shards.
+ */
+class Dataset {
+protected:
+	Dataset() {}
+
+public:
+	struct ShardInfo {
+		int numRecords;
+		unsigned long long checksum;
+	};
+
+public:
+	static std::string shardPath(const std::string& directory, int shardIndex);
+	static std::string manifestPath(const std::string& directory);
+	static bool readManifest(const std::string& directory, int& recordsPerShard, std::map<int, ShardInfo>& shards);
+};
+
+/**
+ * Sink that writes the samples into the shards of the dataset in the directory.
+ * The records of a shard are kept in memory until all of them are written, and then the shard is written at once
+ * and added to the manifest, so that a crash never leaves a broken shard. The shards of a previous run that are
+ * listed as complete in the manifest are kept, and the others are written again.
+ */
+class DatasetWriter : public ImageSink {
+private:
+	struct Shard {
+		std::map<int, std::string> records;
+	};
+
+	std::string directory;
+	int recordsPerShard;
+	int compressionLevel;
+	std::mutex mutex;
+	std::map<int, Shard> pendingShards;
+	std::map<int, Dataset::ShardInfo> shards;
+
+public:
+	DatasetWriter(const std::string& directory, int recordsPerShard = 1000, int compressionLevel = 3);
+	~DatasetWriter();
+
+	bool write(int index, const cv::Mat& image, const std::vector<float>& paramValues);
+	bool isWritten(int index);
+	void close();
+
+private:
+	bool writeShard(int shardIndex, const Shard& shard);
+	bool writeManifest();
+};
+
+/**
+ * Random access to the samples of the dataset in the directory.
+ * The shards are memory-mapped when they are accessed first. A reader must not be shared by multiple threads.
+ */
+class DatasetReader {
+private:
+	struct MappedShard {
+		boost::shared_ptr<QFile> file;
+		const unsigned char* data;
+		long long size;
+	};
+
+	std::string directory;
+	int recordsPerShard;
+	std::map<int, Dataset::ShardInfo> shards;
+	std::map<int, MappedShard> mappedShards;
+
+public:
+	DatasetReader(const std::string& directory);
+
+	int size() const;
+	bool contains(int index);
+	bool read(int index, cv::Mat& image, std::vector<float>& paramValues);
+	bool verify(int shardIndex);
+	bool verify();
+
+private:
+	const unsigned char* mapShard(int shardIndex, long long& size);
+	bool findRecord(int index, const unsigned char*& record, unsigned long long& recordSize);
+};
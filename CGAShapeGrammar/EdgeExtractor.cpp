@@ -0,0 +1,306 @@
+#include "EdgeExtractor.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+/** the vertices closer than this are welded, so that the edges of the adjacent faces are shared */
+const float WELD_DISTANCE = 0.001f;
+
+/** the same threshold of the normal difference as lc_frag_line.glsl */
+const float NORMAL_THRESHOLD = 0.3f;
+
+/** the same threshold of the depth difference as lc_frag_line.glsl, which is multiplied by its depth sensitivity */
+const float DEPTH_THRESHOLD = 0.03f;
+
+/** the edges are sampled at this interval in pixels */
+const float SAMPLE_INTERVAL = 1.0f;
+
+/** the G-buffer is read at this distance in pixels on both sides of an edge */
+const float SIDE_OFFSET = 1.0f;
+
+/** the edges behind the G-buffer by more than this ratio of the depth are hidden */
+const float DEPTH_TOLERANCE = 0.01f;
+
+struct PositionKey {
+	long long x;
+	long long y;
+	long long z;
+
+	PositionKey(const glm::vec3& p) {
+		x = (long long)floor(p.x / WELD_DISTANCE + 0.5f);
+		y = (long long)floor(p.y / WELD_DISTANCE + 0.5f);
+		z = (long long)floor(p.z / WELD_DISTANCE + 0.5f);
+	}
+
+	bool operator==(const PositionKey& other) const {
+		return x == other.x && y == other.y && z == other.z;
+	}
+};
+
+struct PositionKeyHash {
+	size_t operator()(const PositionKey& key) const {
+		unsigned long long h = key.x * 73856093ULL;
+		h ^= key.y * 19349663ULL;
+		h ^= key.z * 83492791ULL;
+		return (size_t)(h ^ (h >> 32));
+	}
+};
+
+/**
+ * Triangles that share an edge.
+ * Only the first two are kept, and an edge shared by more triangles is always a crease.
+ */
+struct EdgeFaces {
+	int count;
+	glm::vec3 normals[2];
+	bool front[2];
+
+	EdgeFaces() : count(0) {}
+};
+
+struct IndexedEdge {
+	int v0;
+	int v1;
+	int type;
+};
+
+/**
+ * Welded vertices of the triangles.
+ */
+class VertexTable {
+public:
+	std::vector<glm::vec3> positions;
+	std::unordered_map<PositionKey, int, PositionKeyHash> ids;
+
+public:
+	int id(const glm::vec3& p) {
+		std::pair<std::unordered_map<PositionKey, int, PositionKeyHash>::iterator, bool> result = ids.insert(std::make_pair(PositionKey(p), (int)positions.size()));
+		if (result.second) positions.push_back(p);
+		return result.first->second;
+	}
+};
+
+/**
+ * Return true if the endpoints of both edges are on a line, where p is the shared endpoint.
+ */
+bool isCollinear(const glm::vec3& a, const glm::vec3& p, const glm::vec3& b) {
+	return glm::dot(glm::normalize(p - a), glm::normalize(b - p)) > 0.9999f;
+}
+
+/**
+ * Clip the segment to [0, max] in a coordinate. t0 and t1 are the parameters of the remaining part.
+ */
+bool clipParameter(float p, float d, float max, float& t0, float& t1) {
+	float q[2] = { p, max - p };
+	float r[2] = { -d, d };
+	for (int i = 0; i < 2; ++i) {
+		if (r[i] == 0) {
+			if (q[i] < 0) return false;
+		}
+		else {
+			float t = q[i] / r[i];
+			if (r[i] < 0) t0 = std::max(t0, t);
+			else t1 = std::min(t1, t);
+		}
+	}
+	return t0 <= t1;
+}
+
+}
+
+/**
+ * Find the boundary, crease, and silhouette edges of the faces seen by the model view projection matrix.
+ * The triangles are oriented by their vertex normals, so that the winding order does not matter, and
+ * the crease edges are the ones whose two normals differ by the same threshold as the line shader.
+ */
+void EdgeExtractor::extractFeatureEdges(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const glm::mat4& mvpMatrix, std::vector<FeatureEdge>& edges) {
+	// the camera in the homogeneous coordinates, which is at infinity for an orthographic projection
+	glm::vec4 eye = glm::inverse(mvpMatrix) * glm::vec4(0, 0, 1, 0);
+	if (eye.w < 0) eye = -eye;
+
+	VertexTable table;
+	std::unordered_map<unsigned long long, EdgeFaces> edgeFaces;
+	std::vector<unsigned long long> edgeOrder;
+
+	std::vector<Vertex> instanceVertices;
+	for (int i = 0; i < faces.size(); ++i) {
+		const std::vector<Vertex>* vertices = &faces[i]->vertices;
+		if (faces[i]->isInstance()) {
+			instanceVertices.clear();
+			faces[i]->instantiate(instanceVertices);
+			vertices = &instanceVertices;
+		}
+
+		for (int k = 0; k + 2 < vertices->size(); k += 3) {
+			const Vertex* v[3] = { &(*vertices)[k], &(*vertices)[k + 1], &(*vertices)[k + 2] };
+			glm::vec3 normal = glm::cross(v[1]->position - v[0]->position, v[2]->position - v[0]->position);
+			if (glm::length(normal) == 0) continue;
+			normal = glm::normalize(normal);
+			if (glm::dot(normal, v[0]->normal + v[1]->normal + v[2]->normal) < 0) normal = -normal;
+			bool front = glm::dot(glm::vec4(normal, -glm::dot(normal, v[0]->position)), eye) > 0;
+
+			int ids[3] = { table.id(v[0]->position), table.id(v[1]->position), table.id(v[2]->position) };
+			if (ids[0] == ids[1] || ids[1] == ids[2] || ids[2] == ids[0]) continue;
+
+			for (int e = 0; e < 3; ++e) {
+				unsigned int a = std::min(ids[e], ids[(e + 1) % 3]);
+				unsigned int b = std::max(ids[e], ids[(e + 1) % 3]);
+				unsigned long long key = ((unsigned long long)a << 32) | b;
+
+				EdgeFaces& shared = edgeFaces[key];
+				if (shared.count == 0) edgeOrder.push_back(key);
+				if (shared.count < 2) {
+					shared.normals[shared.count] = normal;
+					shared.front[shared.count] = front;
+				}
+				shared.count++;
+			}
+		}
+	}
+
+	// classify the edges in the order of the faces, so that the result does not depend on the hash table
+	std::vector<IndexedEdge> featureEdges;
+	std::vector<std::vector<int> > incidentEdges(table.positions.size());
+	for (int i = 0; i < edgeOrder.size(); ++i) {
+		const EdgeFaces& shared = edgeFaces[edgeOrder[i]];
+		IndexedEdge edge;
+		edge.v0 = edgeOrder[i] >> 32;
+		edge.v1 = edgeOrder[i] & 0xffffffff;
+
+		if (shared.count == 1) {
+			edge.type = EDGE_BOUNDARY;
+		}
+		else if (shared.count == 2 && shared.front[0] != shared.front[1]) {
+			edge.type = EDGE_SILHOUETTE;
+		}
+		else if (shared.count > 2 || glm::length(shared.normals[0] - shared.normals[1]) > NORMAL_THRESHOLD) {
+			edge.type = EDGE_CREASE;
+		}
+		else {
+			continue;
+		}
+
+		incidentEdges[edge.v0].push_back(featureEdges.size());
+		incidentEdges[edge.v1].push_back(featureEdges.size());
+		featureEdges.push_back(edge);
+	}
+
+	// join the edges of the same type on a line through the vertices that have no other edges
+	std::vector<bool> used(featureEdges.size(), false);
+	for (int i = 0; i < featureEdges.size(); ++i) {
+		if (used[i]) continue;
+		used[i] = true;
+
+		int ends[2] = { featureEdges[i].v0, featureEdges[i].v1 };
+		for (int side = 0; side < 2; ++side) {
+			int prev = i;
+			while (incidentEdges[ends[side]].size() == 2) {
+				const std::vector<int>& incident = incidentEdges[ends[side]];
+				int next = incident[0] == prev ? incident[1] : incident[0];
+				if (used[next] || featureEdges[next].type != featureEdges[i].type) break;
+
+				int other = featureEdges[next].v0 == ends[side] ? featureEdges[next].v1 : featureEdges[next].v0;
+				if (!isCollinear(table.positions[ends[1 - side]], table.positions[ends[side]], table.positions[other])) break;
+
+				used[next] = true;
+				ends[side] = other;
+				prev = next;
+			}
+		}
+
+		edges.push_back(FeatureEdge(table.positions[ends[0]], table.positions[ends[1]], featureEdges[i].type));
+	}
+}
+
+/**
+ * Project the edges to the image of the G-buffer, and return their visible parts in the top-down image coordinates.
+ * An edge is sampled at every pixel, and a sample is visible if the edge is not behind the surfaces on both sides of it,
+ * and the normal or the depth is discontinuous across it as in lc_frag_line.glsl. The latter also removes the edges
+ * between the coplanar faces that are not welded, e.g., at T-junctions.
+ */
+void EdgeExtractor::extractVisibleEdges(const std::vector<FeatureEdge>& featureEdges, const glm::mat4& mvpMatrix, const glm::mat4& pMatrix, const SoftwareRenderer& renderer, std::vector<std::pair<glm::vec2, glm::vec2> >& edges) {
+	const int width = renderer.width;
+	const int height = renderer.height;
+
+	for (int i = 0; i < featureEdges.size(); ++i) {
+		glm::vec4 clip[2] = { mvpMatrix * glm::vec4(featureEdges[i].p0, 1), mvpMatrix * glm::vec4(featureEdges[i].p1, 1) };
+
+		// clip by the near plane
+		float d0 = clip[0].z + clip[0].w;
+		float d1 = clip[1].z + clip[1].w;
+		if (d0 < 0 && d1 < 0) continue;
+		if (d0 < 0) clip[0] += (clip[1] - clip[0]) * (d0 / (d0 - d1));
+		if (d1 < 0) clip[1] += (clip[0] - clip[1]) * (d1 / (d1 - d0));
+
+		glm::vec2 window[2];
+		float invW[2];
+		for (int k = 0; k < 2; ++k) {
+			invW[k] = 1.0f / clip[k].w;
+			window[k] = glm::vec2((clip[k].x * invW[k] * 0.5f + 0.5f) * width, (clip[k].y * invW[k] * 0.5f + 0.5f) * height);
+		}
+
+		// clip by the image, where 1/w is linear in the window coordinates
+		glm::vec2 dir = window[1] - window[0];
+		float t0 = 0.0f;
+		float t1 = 1.0f;
+		if (!clipParameter(window[0].x, dir.x, (float)width, t0, t1) || !clipParameter(window[0].y, dir.y, (float)height, t0, t1)) continue;
+
+		float length = glm::length(dir) * (t1 - t0);
+		if (length < SAMPLE_INTERVAL) continue;
+		glm::vec2 side = glm::normalize(glm::vec2(-dir.y, dir.x)) * SIDE_OFFSET;
+
+		int numSamples = (int)ceil(length / SAMPLE_INTERVAL) + 1;
+		int runStart = -1;
+		float runStartT = 0.0f;
+		float lastT = 0.0f;
+		for (int s = 0; s <= numSamples; ++s) {
+			bool visible = false;
+			float t = t0 + (t1 - t0) * s / (numSamples - 1);
+			if (s < numSamples) {
+				glm::vec2 p = window[0] + dir * t;
+				float w = 1.0f / (invW[0] + (invW[1] - invW[0]) * t);
+
+				int pixels[2];
+				bool background[2];
+				float eyeDepth[2];
+				float shaderDepth[2];
+				for (int k = 0; k < 2; ++k) {
+					glm::vec2 q = k == 0 ? p + side : p - side;
+					int x = std::min(std::max((int)floor(q.x), 0), width - 1);
+					int y = std::min(std::max((int)floor(q.y), 0), height - 1);
+					pixels[k] = y * width + x;
+
+					float depth = renderer.depth[pixels[k]];
+					background[k] = depth == 1.0f;
+					eyeDepth[k] = background[k] ? std::numeric_limits<float>::max() : pMatrix[3][2] / (depth * 2.0f - 1.0f + pMatrix[2][2]);
+					shaderDepth[k] = pMatrix[3][2] / (depth + pMatrix[2][2]);
+				}
+
+				bool hidden = w > std::max(eyeDepth[0], eyeDepth[1]) * (1.0f + DEPTH_TOLERANCE);
+				bool discontinuous = background[0] != background[1];
+				if (!background[0] && !background[1]) {
+					discontinuous = glm::length(glm::normalize(renderer.normals[pixels[0]]) - glm::normalize(renderer.normals[pixels[1]])) > NORMAL_THRESHOLD || std::abs(shaderDepth[0] - shaderDepth[1]) > DEPTH_THRESHOLD;
+				}
+				visible = !hidden && discontinuous;
+			}
+
+			// output the runs of the visible samples
+			if (visible && runStart < 0) {
+				runStart = s;
+				runStartT = t;
+			}
+			else if (!visible && runStart >= 0) {
+				if (s - runStart >= 2) {
+					glm::vec2 a = window[0] + dir * runStartT;
+					glm::vec2 b = window[0] + dir * lastT;
+					edges.push_back(std::make_pair(glm::vec2(a.x, height - a.y), glm::vec2(b.x, height - b.y)));
+				}
+				runStart = -1;
+			}
+			lastT = t;
+		}
+	}
+}
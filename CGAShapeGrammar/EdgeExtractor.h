@@ -0,0 +1,36 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <glm/glm.hpp>
+#include "GLUtils.h"
+#include "SoftwareRenderer.h"
+
+/**
+ * Extraction of the edges of the line drawings from the geometry instead of the rendered image.
+ * The boundary, crease, and silhouette edges are found from the adjacency of the triangles, and the collinear
+ * ones are joined. They are projected to the image, and the hidden parts are removed by the G-buffer of
+ * the software renderer, so that the result is a set of exact 2D segments that can be stylized directly.
+ */
+class EdgeExtractor {
+protected:
+	EdgeExtractor() {}
+
+public:
+	enum { EDGE_BOUNDARY = 0, EDGE_CREASE, EDGE_SILHOUETTE };
+
+	class FeatureEdge {
+	public:
+		glm::vec3 p0;
+		glm::vec3 p1;
+		int type;
+
+	public:
+		FeatureEdge(const glm::vec3& p0, const glm::vec3& p1, int type) : p0(p0), p1(p1), type(type) {}
+	};
+
+public:
+	static void extractFeatureEdges(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const glm::mat4& mvpMatrix, std::vector<FeatureEdge>& edges);
+	static void extractVisibleEdges(const std::vector<FeatureEdge>& featureEdges, const glm::mat4& mvpMatrix, const glm::mat4& pMatrix, const SoftwareRenderer& renderer, std::vector<std::pair<glm::vec2, glm::vec2> >& edges);
+};
@@ -0,0 +1,270 @@
+#include "FaceCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace cga {
+
+namespace {
+
+/**
+ * Quantized plane, in which a plane and its flipped one have the same key.
+ */
+struct PlaneKey {
+	int nx;
+	int ny;
+	int nz;
+	int d;
+
+	PlaneKey(int nx, int ny, int nz, int d) : nx(nx), ny(ny), nz(nz), d(d) {}
+
+	bool operator<(const PlaneKey& other) const {
+		if (nx != other.nx) return nx < other.nx;
+		if (ny != other.ny) return ny < other.ny;
+		if (nz != other.nz) return nz < other.nz;
+		return d < other.d;
+	}
+};
+
+/**
+ * Triangles of a face that lie on the same side of a plane, projected to the 2D coordinates of the plane.
+ */
+struct PlanarPolygon {
+	int face;
+	int side;
+	std::vector<int> triangles;		// index of the first vertex of each triangle in the face
+	std::vector<glm::vec2> points;	// projected vertices, three per triangle
+	std::vector<glm::vec2> hull;	// counter-clockwise convex hull, or empty if the triangles do not form a convex polygon
+	glm::vec2 minPt;
+	glm::vec2 maxPt;
+};
+
+const float NORMAL_RESOLUTION = 100.0f;
+
+float cross(const glm::vec2& a, const glm::vec2& b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+bool lessXY(const glm::vec2& a, const glm::vec2& b) {
+	return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+/**
+ * Return the counter-clockwise convex hull of the points (Andrew's monotone chain).
+ */
+void convexHull(std::vector<glm::vec2> points, std::vector<glm::vec2>& hull) {
+	std::sort(points.begin(), points.end(), lessXY);
+
+	hull.resize(points.size() * 2);
+	int k = 0;
+	for (int i = 0; i < points.size(); ++i) {
+		while (k >= 2 && cross(hull[k - 1] - hull[k - 2], points[i] - hull[k - 2]) <= 0) k--;
+		hull[k++] = points[i];
+	}
+	for (int i = (int)points.size() - 2, t = k + 1; i >= 0; --i) {
+		while (k >= t && cross(hull[k - 1] - hull[k - 2], points[i] - hull[k - 2]) <= 0) k--;
+		hull[k++] = points[i];
+	}
+	hull.resize(std::max(0, k - 1));
+}
+
+float polygonArea(const std::vector<glm::vec2>& points) {
+	float area = 0.0f;
+	for (int i = 0; i < points.size(); ++i) {
+		area += cross(points[i], points[(i + 1) % points.size()]);
+	}
+	return area * 0.5f;
+}
+
+bool insideConvexPolygon(const glm::vec2& p, const std::vector<glm::vec2>& polygon, float tolerance) {
+	for (int i = 0; i < polygon.size(); ++i) {
+		glm::vec2 edge = polygon[(i + 1) % polygon.size()] - polygon[i];
+		if (cross(edge, p - polygon[i]) < -tolerance * glm::length(edge)) return false;
+	}
+	return true;
+}
+
+bool insideTriangle(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, float tolerance) {
+	std::vector<glm::vec2> triangle(3);
+	triangle[0] = a;
+	triangle[1] = b;
+	triangle[2] = c;
+	if (cross(b - a, c - a) < 0) std::swap(triangle[1], triangle[2]);
+	return insideConvexPolygon(p, triangle, tolerance);
+}
+
+/**
+ * Test if the triangle of polygon p is covered by polygon q.
+ * If q is convex, it is enough that all the vertices are inside q. Otherwise, all the vertices have
+ * to be inside one of the triangles of q, which is conservative.
+ */
+bool covered(const PlanarPolygon& p, int triangle, const PlanarPolygon& q, float tolerance) {
+	const glm::vec2* pts = &p.points[triangle * 3];
+
+	if (!q.hull.empty()) {
+		for (int i = 0; i < 3; ++i) {
+			if (!insideConvexPolygon(pts[i], q.hull, tolerance)) return false;
+		}
+		return true;
+	}
+
+	for (int j = 0; j < q.triangles.size(); ++j) {
+		const glm::vec2* tri = &q.points[j * 3];
+		if (insideTriangle(pts[0], tri[0], tri[1], tri[2], tolerance) && insideTriangle(pts[1], tri[0], tri[1], tri[2], tolerance) && insideTriangle(pts[2], tri[0], tri[1], tri[2], tolerance)) return true;
+	}
+	return false;
+}
+
+}
+
+FaceCulling::FaceCulling() {
+	enabled = false;
+	cullGround = true;
+	groundHeight = 0.0f;
+	tolerance = 0.001f;
+	numTriangles = 0;
+	numCulledTriangles = 0;
+}
+
+/**
+ * Remove the hidden triangles from faces[first], faces[first + 1], ...
+ * The faces whose triangles are all removed are erased from the list.
+ */
+void FaceCulling::apply(std::vector<boost::shared_ptr<glutils::Face> >& faces, int first) {
+	numTriangles = 0;
+	numCulledTriangles = 0;
+
+	std::vector<std::vector<bool> > removed(faces.size());
+	std::map<PlaneKey, std::vector<PlanarPolygon> > planes;
+
+	for (int i = first; i < faces.size(); ++i) {
+		if (faces[i]->isInstance()) continue;
+
+		const std::vector<Vertex>& vertices = faces[i]->vertices;
+		removed[i].resize(vertices.size() / 3, false);
+		numTriangles += vertices.size() / 3;
+
+		// the polygons of this face on each plane
+		std::map<std::pair<PlaneKey, int>, int> polygons;
+
+		for (int k = 0; k + 2 < vertices.size(); k += 3) {
+			const glm::vec3& a = vertices[k].position;
+			const glm::vec3& b = vertices[k + 1].position;
+			const glm::vec3& c = vertices[k + 2].position;
+
+			glm::vec3 n = glm::cross(b - a, c - a);
+			float len = glm::length(n);
+			if (len < tolerance * tolerance) continue;
+			n /= len;
+
+			// downward faces on the ground plane
+			if (cullGround && n.y < -0.999f && fabs(a.y - groundHeight) < tolerance && fabs(b.y - groundHeight) < tolerance && fabs(c.y - groundHeight) < tolerance) {
+				removed[i][k / 3] = true;
+				continue;
+			}
+
+			// flip the normal such that its largest component is positive
+			int axis = 0;
+			if (fabs(n.y) > fabs(n[axis])) axis = 1;
+			if (fabs(n.z) > fabs(n[axis])) axis = 2;
+			int side = n[axis] > 0 ? 1 : -1;
+			glm::vec3 cn = n * (float)side;
+
+			PlaneKey key((int)floor(cn.x * NORMAL_RESOLUTION + 0.5f), (int)floor(cn.y * NORMAL_RESOLUTION + 0.5f), (int)floor(cn.z * NORMAL_RESOLUTION + 0.5f), (int)floor(glm::dot(cn, a) / tolerance + 0.5f));
+
+			std::pair<PlaneKey, int> polygonKey(key, side);
+			if (polygons.find(polygonKey) == polygons.end()) {
+				polygons[polygonKey] = planes[key].size();
+				planes[key].push_back(PlanarPolygon());
+				planes[key].back().face = i;
+				planes[key].back().side = side;
+			}
+			planes[key][polygons[polygonKey]].triangles.push_back(k);
+		}
+	}
+
+	// project the polygons to the 2D coordinates of their planes
+	for (auto it = planes.begin(); it != planes.end(); ++it) {
+		glm::vec3 n = glm::normalize(glm::vec3(it->first.nx, it->first.ny, it->first.nz));
+		glm::vec3 u = glm::normalize(glm::cross(n, fabs(n.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0)));
+		glm::vec3 v = glm::cross(n, u);
+
+		for (int j = 0; j < it->second.size(); ++j) {
+			PlanarPolygon& polygon = it->second[j];
+			const std::vector<Vertex>& vertices = faces[polygon.face]->vertices;
+
+			float area = 0.0f;
+			for (int t = 0; t < polygon.triangles.size(); ++t) {
+				for (int l = 0; l < 3; ++l) {
+					const glm::vec3& p = vertices[polygon.triangles[t] + l].position;
+					polygon.points.push_back(glm::vec2(glm::dot(p, u), glm::dot(p, v)));
+				}
+				const glm::vec2* tri = &polygon.points[t * 3];
+				area += fabs(cross(tri[1] - tri[0], tri[2] - tri[0])) * 0.5f;
+			}
+
+			polygon.minPt = polygon.maxPt = polygon.points[0];
+			for (int l = 1; l < polygon.points.size(); ++l) {
+				polygon.minPt = glm::min(polygon.minPt, polygon.points[l]);
+				polygon.maxPt = glm::max(polygon.maxPt, polygon.points[l]);
+			}
+
+			// the triangles form a convex polygon if they exactly fill their convex hull
+			convexHull(polygon.points, polygon.hull);
+			float hullArea = polygonArea(polygon.hull);
+			if (polygon.hull.size() < 3 || fabs(hullArea - area) > hullArea * 0.0001f + tolerance * tolerance) {
+				polygon.hull.clear();
+			}
+		}
+	}
+
+	// remove the triangles covered by the coincident polygons facing the opposite direction
+	for (auto it = planes.begin(); it != planes.end(); ++it) {
+		for (int j = 0; j < it->second.size(); ++j) {
+			PlanarPolygon& p = it->second[j];
+
+			// the neighbor cells are also examined in case the plane lies on the boundary of the cells
+			for (int dd = -1; dd <= 1; ++dd) {
+				PlaneKey key(it->first.nx, it->first.ny, it->first.nz, it->first.d + dd);
+				auto it2 = planes.find(key);
+				if (it2 == planes.end()) continue;
+
+				for (int l = 0; l < it2->second.size(); ++l) {
+					const PlanarPolygon& q = it2->second[l];
+					if (q.side == p.side || q.face == p.face) continue;
+					if (p.maxPt.x < q.minPt.x - tolerance || p.minPt.x > q.maxPt.x + tolerance || p.maxPt.y < q.minPt.y - tolerance || p.minPt.y > q.maxPt.y + tolerance) continue;
+
+					for (int t = 0; t < p.triangles.size(); ++t) {
+						if (removed[p.face][p.triangles[t] / 3]) continue;
+						if (covered(p, t, q, tolerance)) {
+							removed[p.face][p.triangles[t] / 3] = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// rebuild the faces
+	std::vector<boost::shared_ptr<glutils::Face> > results(faces.begin(), faces.begin() + first);
+	for (int i = first; i < faces.size(); ++i) {
+		int count = std::count(removed[i].begin(), removed[i].end(), true);
+		if (count == 0) {
+			results.push_back(faces[i]);
+			continue;
+		}
+
+		numCulledTriangles += count;
+		if (count == removed[i].size()) continue;
+
+		std::vector<Vertex> vertices;
+		for (int k = 0; k < removed[i].size(); ++k) {
+			if (removed[i][k]) continue;
+			vertices.insert(vertices.end(), faces[i]->vertices.begin() + k * 3, faces[i]->vertices.begin() + k * 3 + 3);
+		}
+		results.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(faces[i]->name, faces[i]->grammar_type, vertices, faces[i]->texture)));
+	}
+	faces.swap(results);
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <boost/shared_ptr.hpp>
+#include "GLUtils.h"
+
+namespace cga {
+
+/**
+ * Optional pass applied by CGA::generateGeometry() that removes the triangles which can never be seen.
+ * A triangle is removed if it is fully covered by a coincident face facing the opposite direction,
+ * e.g., the faces where split masses meet, or if it faces downward on the ground plane.
+ * The instances of the shared meshes are not examined.
+ */
+class FaceCulling {
+public:
+	bool enabled;
+	bool cullGround;
+	float groundHeight;
+	float tolerance;
+
+	// statistics of the last call of apply()
+	int numTriangles;
+	int numCulledTriangles;
+
+public:
+	FaceCulling();
+
+	void apply(std::vector<boost::shared_ptr<glutils::Face> >& faces, int first = 0);
+};
+
+}
@@ -0,0 +1,100 @@
+#include "FrameReadback.h"
+#include <cstring>
+
+FrameReadback::FrameReadback() : width(0), height(0), first(0), count(0) {
+}
+
+/**
+ * Create numBuffers pixel buffer objects for the frames of the given size.
+ * Three buffers let the copy of a frame finish while the next one is rendered without stalling.
+ */
+void FrameReadback::init(int width, int height, int numBuffers) {
+	release();
+
+	this->width = width;
+	this->height = height;
+	buffers.resize(numBuffers);
+	fences.resize(numBuffers, (GLsync)0);
+	ids.resize(numBuffers, 0);
+
+	glGenBuffers(numBuffers, &buffers[0]);
+	for (int i = 0; i < numBuffers; ++i) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/**
+ * Delete the buffers and the fences. The pending frames are discarded.
+ */
+void FrameReadback::release() {
+	for (int i = 0; i < fences.size(); ++i) {
+		if (fences[i] != (GLsync)0) glDeleteSync(fences[i]);
+	}
+	if (!buffers.empty()) glDeleteBuffers(buffers.size(), &buffers[0]);
+
+	buffers.clear();
+	fences.clear();
+	ids.clear();
+	first = 0;
+	count = 0;
+}
+
+/**
+ * Queue the copy of the current read buffer into the next pixel buffer object.
+ * The ring must not be full, i.e., the oldest frame has to be taken first.
+ */
+void FrameReadback::readPixels(int id) {
+	if (isFull()) throw "The frame readback is full.";
+
+	int index = (first + count) % buffers.size();
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[index]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ids[index] = id;
+	count++;
+}
+
+/**
+ * Copy the oldest frame to the image, and return its id. The image is empty if the buffer cannot be mapped.
+ * If wait is false, return false without blocking when the copy has not finished yet.
+ * Return false if there is no pending frame.
+ */
+bool FrameReadback::takeFrame(cv::Mat& image, int& id, bool wait) {
+	if (isEmpty()) return false;
+
+	GLsync fence = fences[first];
+	if (wait) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+	}
+	else {
+		GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+	}
+	glDeleteSync(fence);
+	fences[first] = (GLsync)0;
+
+	// OpenGL returns the rows bottom-up
+	image = cv::Mat(height, width, CV_8UC4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[first]);
+	const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GL_MAP_READ_BIT);
+	if (pixels != NULL) {
+		for (int y = 0; y < height; ++y) {
+			memcpy(image.ptr(height - 1 - y), pixels + y * width * 4, width * 4);
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else {
+		image = cv::Mat();
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	id = ids[first];
+	first = (first + 1) % buffers.size();
+	count--;
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glew.h>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * Asynchronous readback of the frame buffer through a ring of pixel buffer objects.
+ * readPixels() only queues the copy into the next buffer and a fence, so that the next frame can be
+ * rendered while the copy is in flight, and takeFrame() maps the oldest buffer after its fence is signaled.
+ * The images are in the same layout as QGLWidget::grabFrameBuffer(), i.e., top-down 8-bit BGRA.
+ * All the functions must be called while the GL context is current.
+ */
+class FrameReadback {
+private:
+	int width;
+	int height;
+	std::vector<GLuint> buffers;
+	std::vector<GLsync> fences;
+	std::vector<int> ids;
+	int first;		// the oldest pending buffer
+	int count;		// the number of the pending buffers
+
+public:
+	FrameReadback();
+
+	void init(int width, int height, int numBuffers = 3);
+	void release();
+	bool isFull() const { return count == buffers.size(); }
+	bool isEmpty() const { return count == 0; }
+	void readPixels(int id);
+	bool takeFrame(cv::Mat& image, int& id, bool wait);
+};
@@ -0,0 +1,428 @@
+#include "GLBWriter.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+enum { GL_ARRAY_BUFFER_TARGET = 34962, GL_ELEMENT_ARRAY_BUFFER_TARGET = 34963 };
+enum { COMPONENT_FLOAT = 5126, COMPONENT_UNSIGNED_INT = 5125 };
+
+struct MaterialKey {
+	std::string texture;
+	glm::vec4 color;
+	glm::vec4 uvTransform;
+
+	MaterialKey(const std::string& texture, const glm::vec4& color, const glm::vec4& uvTransform) : texture(texture), color(color), uvTransform(uvTransform) {}
+
+	bool operator<(const MaterialKey& other) const {
+		if (texture != other.texture) return texture < other.texture;
+		for (int i = 0; i < 4; ++i) {
+			if (color[i] != other.color[i]) return color[i] < other.color[i];
+		}
+		for (int i = 0; i < 4; ++i) {
+			if (uvTransform[i] != other.uvTransform[i]) return uvTransform[i] < other.uvTransform[i];
+		}
+		return false;
+	}
+};
+
+/**
+ * Vertex attributes that are written to glTF, compared by their bit patterns.
+ */
+struct VertexKey {
+	float v[8];
+
+	VertexKey(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoord) {
+		memcpy(v, &position[0], sizeof(float) * 3);
+		memcpy(v + 3, &normal[0], sizeof(float) * 3);
+		memcpy(v + 6, &texCoord[0], sizeof(float) * 2);
+	}
+	bool operator==(const VertexKey& other) const { return memcmp(v, other.v, sizeof(v)) == 0; }
+};
+
+struct VertexKeyHash {
+	size_t operator()(const VertexKey& key) const {
+		unsigned int bits[8];
+		memcpy(bits, key.v, sizeof(bits));
+		size_t h = 2166136261u;
+		for (int i = 0; i < 8; ++i) {
+			h = (h ^ bits[i]) * 16777619u;
+		}
+		return h;
+	}
+};
+
+/**
+ * Indexed triangles of a primitive.
+ */
+class Primitive {
+public:
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<unsigned int> indices;
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> vertexIds;
+	bool hasTexCoords;
+
+public:
+	Primitive(bool hasTexCoords = false) : hasTexCoords(hasTexCoords) {}
+
+	/**
+	 * Add a corner of a triangle.
+	 * The texture coordinates are flipped vertically because the origin of glTF images is the top left corner.
+	 */
+	void addVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoord) {
+		VertexKey key(position, normal, hasTexCoords ? glm::vec2(texCoord.x, 1.0f - texCoord.y) : glm::vec2(0, 0));
+		std::pair<std::unordered_map<VertexKey, unsigned int, VertexKeyHash>::iterator, bool> result = vertexIds.insert(std::make_pair(key, (unsigned int)positions.size()));
+		if (result.second) {
+			positions.push_back(position);
+			normals.push_back(normal);
+			if (hasTexCoords) texCoords.push_back(glm::vec2(texCoord.x, 1.0f - texCoord.y));
+		}
+		indices.push_back(result.first->second);
+	}
+};
+
+/**
+ * The JSON document and the binary chunk being built.
+ */
+class GLBBuilder {
+public:
+	std::string bin;
+	QJsonArray bufferViews;
+	QJsonArray accessors;
+	QJsonArray meshes;
+	QJsonArray nodes;
+	QJsonArray materials;
+	QJsonArray textures;
+	QJsonArray images;
+	bool embedTextures;
+	bool textureTransformUsed;
+
+	std::map<MaterialKey, int> materialIds;
+	std::map<std::string, int> textureIds;
+
+public:
+	GLBBuilder(bool embedTextures) : embedTextures(embedTextures), textureTransformUsed(false) {}
+
+	int addBufferView(const void* data, int size, int target);
+	int addAccessor(const void* data, int count, int componentType, const char* type, int componentSize, int target);
+	QJsonObject addPrimitive(const Primitive& primitive, int material);
+	int getMaterial(const MaterialKey& key);
+	int getTexture(const std::string& filename);
+	QByteArray toGLB();
+};
+
+int GLBBuilder::addBufferView(const void* data, int size, int target) {
+	// all the accessors use 4-byte components
+	while (bin.size() % 4 != 0) bin.push_back(0);
+
+	QJsonObject view;
+	view["buffer"] = 0;
+	view["byteOffset"] = (int)bin.size();
+	view["byteLength"] = size;
+	if (target != 0) view["target"] = target;
+	bin.append((const char*)data, size);
+
+	bufferViews.append(view);
+	return bufferViews.size() - 1;
+}
+
+int GLBBuilder::addAccessor(const void* data, int count, int componentType, const char* type, int componentSize, int target) {
+	QJsonObject accessor;
+	accessor["bufferView"] = addBufferView(data, count * componentSize, target);
+	accessor["componentType"] = componentType;
+	accessor["count"] = count;
+	accessor["type"] = type;
+
+	accessors.append(accessor);
+	return accessors.size() - 1;
+}
+
+QJsonObject GLBBuilder::addPrimitive(const Primitive& primitive, int material) {
+	QJsonObject attributes;
+
+	int position = addAccessor(&primitive.positions[0], primitive.positions.size(), COMPONENT_FLOAT, "VEC3", sizeof(glm::vec3), GL_ARRAY_BUFFER_TARGET);
+	attributes["POSITION"] = position;
+
+	// POSITION requires the bounds
+	glm::vec3 minPt(std::numeric_limits<float>::max());
+	glm::vec3 maxPt(-std::numeric_limits<float>::max());
+	for (int i = 0; i < primitive.positions.size(); ++i) {
+		minPt = glm::min(minPt, primitive.positions[i]);
+		maxPt = glm::max(maxPt, primitive.positions[i]);
+	}
+	QJsonObject accessor = accessors[position].toObject();
+	accessor["min"] = QJsonArray() << minPt.x << minPt.y << minPt.z;
+	accessor["max"] = QJsonArray() << maxPt.x << maxPt.y << maxPt.z;
+	accessors[position] = accessor;
+
+	attributes["NORMAL"] = addAccessor(&primitive.normals[0], primitive.normals.size(), COMPONENT_FLOAT, "VEC3", sizeof(glm::vec3), GL_ARRAY_BUFFER_TARGET);
+	if (primitive.hasTexCoords) {
+		attributes["TEXCOORD_0"] = addAccessor(&primitive.texCoords[0], primitive.texCoords.size(), COMPONENT_FLOAT, "VEC2", sizeof(glm::vec2), GL_ARRAY_BUFFER_TARGET);
+	}
+
+	QJsonObject result;
+	result["attributes"] = attributes;
+	result["indices"] = addAccessor(&primitive.indices[0], primitive.indices.size(), COMPONENT_UNSIGNED_INT, "SCALAR", sizeof(unsigned int), GL_ELEMENT_ARRAY_BUFFER_TARGET);
+	result["material"] = material;
+	return result;
+}
+
+/**
+ * Return the index of the material, which is created when it is used for the first time.
+ * The uv transformation of the instances is written by KHR_texture_transform.
+ */
+int GLBBuilder::getMaterial(const MaterialKey& key) {
+	std::map<MaterialKey, int>::iterator it = materialIds.find(key);
+	if (it != materialIds.end()) return it->second;
+
+	QJsonObject pbr;
+	pbr["baseColorFactor"] = QJsonArray() << key.color.r << key.color.g << key.color.b << key.color.a;
+	pbr["metallicFactor"] = 0.0;
+	pbr["roughnessFactor"] = 1.0;
+
+	int texture = key.texture.empty() ? -1 : getTexture(key.texture);
+	if (texture >= 0) {
+		QJsonObject textureInfo;
+		textureInfo["index"] = texture;
+		if (key.uvTransform != glm::vec4(1, 1, 0, 0)) {
+			QJsonObject transform;
+			transform["scale"] = QJsonArray() << key.uvTransform.x << key.uvTransform.y;
+			// the offset in v is adjusted to the flipped texture coordinates
+			transform["offset"] = QJsonArray() << key.uvTransform.z << 1.0f - key.uvTransform.y - key.uvTransform.w;
+			QJsonObject extensions;
+			extensions["KHR_texture_transform"] = transform;
+			textureInfo["extensions"] = extensions;
+			textureTransformUsed = true;
+		}
+		pbr["baseColorTexture"] = textureInfo;
+	}
+
+	QJsonObject material;
+	material["pbrMetallicRoughness"] = pbr;
+	material["doubleSided"] = false;
+	if (key.color.a < 1.0f) material["alphaMode"] = QString("BLEND");
+
+	materials.append(material);
+	materialIds[key] = materials.size() - 1;
+	return materials.size() - 1;
+}
+
+/**
+ * Return the index of the texture, or -1 if the image cannot be used.
+ * An embedded image is stored as it is if it is PNG or JPEG, and otherwise it is converted to PNG.
+ */
+int GLBBuilder::getTexture(const std::string& filename) {
+	std::map<std::string, int>::iterator it = textureIds.find(filename);
+	if (it != textureIds.end()) return it->second;
+
+	QString suffix = QFileInfo(filename.c_str()).suffix().toLower();
+	QString mimeType = suffix == "png" ? "image/png" : (suffix == "jpg" || suffix == "jpeg" ? "image/jpeg" : "");
+
+	QJsonObject image;
+	if (embedTextures) {
+		QByteArray data;
+		if (!mimeType.isEmpty()) {
+			QFile file(filename.c_str());
+			if (file.open(QIODevice::ReadOnly)) data = file.readAll();
+		} else {
+			QImage img;
+			if (img.load(filename.c_str())) {
+				QBuffer buffer(&data);
+				buffer.open(QIODevice::WriteOnly);
+				img.save(&buffer, "PNG");
+				mimeType = "image/png";
+			}
+		}
+
+		if (data.isEmpty()) {
+			std::cout << "Warning: texture " << filename << " cannot be read, and it is not exported." << std::endl;
+			textureIds[filename] = -1;
+			return -1;
+		}
+
+		image["bufferView"] = addBufferView(data.constData(), data.size(), 0);
+		image["mimeType"] = mimeType;
+	} else {
+		image["uri"] = QString::fromStdString(filename);
+	}
+	images.append(image);
+
+	QJsonObject texture;
+	texture["source"] = images.size() - 1;
+	texture["sampler"] = 0;
+	textures.append(texture);
+
+	textureIds[filename] = textures.size() - 1;
+	return textures.size() - 1;
+}
+
+/**
+ * Assemble the 12-byte header, the JSON chunk, and the BIN chunk.
+ */
+QByteArray GLBBuilder::toGLB() {
+	QJsonObject asset;
+	asset["version"] = QString("2.0");
+	asset["generator"] = QString("CGAShapeGrammar");
+
+	QJsonArray sceneNodes;
+	for (int i = 0; i < nodes.size(); ++i) {
+		sceneNodes.append(i);
+	}
+	QJsonObject scene;
+	scene["nodes"] = sceneNodes;
+
+	QJsonObject root;
+	root["asset"] = asset;
+	root["scene"] = 0;
+	root["scenes"] = QJsonArray() << scene;
+	root["nodes"] = nodes;
+	if (!meshes.isEmpty()) root["meshes"] = meshes;
+	if (!materials.isEmpty()) root["materials"] = materials;
+	if (!textures.isEmpty()) {
+		QJsonObject sampler;
+		sampler["wrapS"] = 10497;	// REPEAT
+		sampler["wrapT"] = 10497;
+		root["samplers"] = QJsonArray() << sampler;
+		root["textures"] = textures;
+		root["images"] = images;
+	}
+	if (textureTransformUsed) {
+		root["extensionsUsed"] = QJsonArray() << QString("KHR_texture_transform");
+	}
+	if (!bin.empty()) {
+		while (bin.size() % 4 != 0) bin.push_back(0);
+
+		QJsonObject buffer;
+		buffer["byteLength"] = (int)bin.size();
+		root["buffers"] = QJsonArray() << buffer;
+		root["bufferViews"] = bufferViews;
+		root["accessors"] = accessors;
+	}
+
+	QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+	while (json.size() % 4 != 0) json.append(' ');
+
+	unsigned int header[3] = { 0x46546C67, 2, 12 + 8 + (unsigned int)json.size() + (bin.empty() ? 0 : 8 + (unsigned int)bin.size()) };
+	unsigned int jsonChunk[2] = { (unsigned int)json.size(), 0x4E4F534A };
+	unsigned int binChunk[2] = { (unsigned int)bin.size(), 0x004E4942 };
+
+	QByteArray glb;
+	glb.reserve(header[2]);
+	glb.append((const char*)header, sizeof(header));
+	glb.append((const char*)jsonChunk, sizeof(jsonChunk));
+	glb.append(json);
+	if (!bin.empty()) {
+		glb.append((const char*)binChunk, sizeof(binChunk));
+		glb.append(bin.data(), bin.size());
+	}
+	return glb;
+}
+
+glm::vec4 faceColor(const glutils::Face& face, const std::vector<Vertex>& vertices) {
+	return face.isInstance() ? face.color : vertices[0].color;
+}
+
+}
+
+/**
+ * Write the faces to the .glb file.
+ * The textures are embedded in the file if embedTextures is true, and otherwise they are referred by their paths.
+ * Return false if the file cannot be written.
+ */
+bool GLBWriter::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename, bool embedTextures) {
+	GLBBuilder builder(embedTextures);
+
+	// the faces that own their vertices are grouped by material
+	std::map<int, Primitive> primitives;
+
+	// glTF meshes of the instances for each (shared mesh, uvFromPosition, material)
+	std::map<std::pair<std::pair<const glutils::Mesh*, bool>, int>, int> instanceMeshIds;
+
+	for (int i = 0; i < faces.size(); ++i) {
+		const glutils::Face& face = *faces[i];
+		const std::vector<Vertex>& vertices = face.isInstance() ? face.mesh->vertices : face.vertices;
+		if (vertices.size() < 3) continue;
+
+		bool textured = !face.texture.empty();
+		glm::vec4 color = textured ? glm::vec4(1, 1, 1, faceColor(face, vertices).a) : faceColor(face, vertices);
+		glm::vec4 uvTransform = face.isInstance() ? face.uvTransform : glm::vec4(1, 1, 0, 0);
+		int material = builder.getMaterial(MaterialKey(textured ? face.texture : "", color, textured ? uvTransform : glm::vec4(1, 1, 0, 0)));
+
+		if (!face.isInstance()) {
+			if (primitives.find(material) == primitives.end()) {
+				primitives[material] = Primitive(textured);
+			}
+			Primitive& primitive = primitives[material];
+			for (int k = 0; k + 2 < vertices.size(); k += 3) {
+				for (int l = 0; l < 3; ++l) {
+					primitive.addVertex(vertices[k + l].position, vertices[k + l].normal, vertices[k + l].texCoord);
+				}
+			}
+			continue;
+		}
+
+		// the shared mesh is written once, and each instance is a node that refers to it
+		std::pair<std::pair<const glutils::Mesh*, bool>, int> key(std::make_pair(face.mesh.get(), face.uvFromPosition), material);
+		if (instanceMeshIds.find(key) == instanceMeshIds.end()) {
+			Primitive primitive(textured);
+			for (int k = 0; k + 2 < vertices.size(); k += 3) {
+				for (int l = 0; l < 3; ++l) {
+					const Vertex& v = vertices[k + l];
+					primitive.addVertex(v.position, v.normal, face.uvFromPosition ? glm::vec2(v.position) : v.texCoord);
+				}
+			}
+
+			QJsonObject mesh;
+			mesh["primitives"] = QJsonArray() << builder.addPrimitive(primitive, material);
+			builder.meshes.append(mesh);
+			instanceMeshIds[key] = builder.meshes.size() - 1;
+		}
+
+		QJsonArray matrix;
+		for (int c = 0; c < 4; ++c) {
+			for (int r = 0; r < 4; ++r) {
+				matrix.append(face.modelMat[c][r]);
+			}
+		}
+		QJsonObject node;
+		node["mesh"] = instanceMeshIds[key];
+		node["matrix"] = matrix;
+		if (!face.name.empty()) node["name"] = QString::fromStdString(face.name);
+		builder.nodes.append(node);
+	}
+
+	if (!primitives.empty()) {
+		QJsonArray jsonPrimitives;
+		for (std::map<int, Primitive>::iterator it = primitives.begin(); it != primitives.end(); ++it) {
+			jsonPrimitives.append(builder.addPrimitive(it->second, it->first));
+		}
+
+		QJsonObject mesh;
+		mesh["primitives"] = jsonPrimitives;
+		builder.meshes.append(mesh);
+
+		QJsonObject node;
+		node["mesh"] = builder.meshes.size() - 1;
+		node["name"] = QString("building");
+		builder.nodes.append(node);
+	}
+
+	QByteArray glb = builder.toGLB();
+	std::ofstream file(filename, std::ios::binary);
+	file.write(glb.constData(), glb.size());
+	file.close();
+	return file.good();
+}
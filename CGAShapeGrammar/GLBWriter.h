@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+#include "GLUtils.h"
+#include <boost/shared_ptr.hpp>
+
+/**
+ * Writer of binary glTF 2.0 (.glb).
+ * The faces that own their vertices are merged into one mesh that has a primitive per material,
+ * and the instances of a shared mesh are written as nodes that refer to the same glTF mesh.
+ */
+class GLBWriter {
+protected:
+	GLBWriter() {}
+
+public:
+	static bool write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename, bool embedTextures = true);
+};
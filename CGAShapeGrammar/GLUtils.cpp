@@ -1,4 +1,5 @@
 ﻿#include "GLUtils.h"
+#include "VertexTransform.h"
 #include <QGLWidget>
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
@@ -128,10 +129,19 @@ bool BoundingBox::contains(const glm::vec3& point, float threshold) {
 	return true;
 }
 
+Mesh::Mesh(const std::vector<Vertex>& vertices) {
+	this->vertices = vertices;
+
+	for (int i = 0; i < vertices.size(); ++i) {
+		bbox.addPoint(vertices[i].position);
+	}
+}
+
 Face::Face(const std::string& name, const std::string& grammar_type, const std::vector<Vertex>& vertices) {
 	this->name = name;
 	this->grammar_type = grammar_type;
 	this->vertices = vertices;
+	this->uvFromPosition = false;
 
 	for (int i = 0; i < vertices.size(); ++i) {
 		bbox.addPoint(vertices[i].position);
@@ -143,13 +153,58 @@ Face::Face(const std::string& name, const std::string& grammar_type, const std::
 	this->grammar_type = grammar_type;
 	this->vertices = vertices;
 	this->texture = texture;
+	this->uvFromPosition = false;
 
 	for (int i = 0; i < vertices.size(); ++i) {
 		bbox.addPoint(vertices[i].position);
 	}
 }
 
+Face::Face(const std::string& name, const std::string& grammar_type, const boost::shared_ptr<const Mesh>& mesh, const glm::mat4& modelMat, const glm::vec4& color, const std::string& texture) {
+	this->name = name;
+	this->grammar_type = grammar_type;
+	this->mesh = mesh;
+	this->modelMat = modelMat;
+	this->color = color;
+	this->texture = texture;
+	this->uvTransform = glm::vec4(1, 1, 0, 0);
+	this->uvFromPosition = false;
+
+	for (int i = 0; i < 8; ++i) {
+		glm::vec3 p((i & 1) ? mesh->bbox.maxPt.x : mesh->bbox.minPt.x, (i & 2) ? mesh->bbox.maxPt.y : mesh->bbox.minPt.y, (i & 4) ? mesh->bbox.maxPt.z : mesh->bbox.minPt.z);
+		bbox.addPoint(glm::vec3(modelMat * glm::vec4(p, 1)));
+	}
+}
+
+/**
+ * Append the vertices of the face in the world coordinates.
+ * For an instance, the shared mesh is transformed by modelMat, and the normals are transformed
+ * such that they keep facing the same side of the triangles as the positions are transformed.
+ */
+void Face::instantiate(std::vector<Vertex>& vertices) const {
+	if (!mesh) {
+		vertices.insert(vertices.end(), this->vertices.begin(), this->vertices.end());
+		return;
+	}
+
+	glm::mat3 normalMat = glm::transpose(glm::inverse(glm::mat3(modelMat)));
+	if (glm::determinant(glm::mat3(modelMat)) < 0) normalMat = -normalMat;
+
+	vertices.reserve(vertices.size() + mesh->vertices.size());
+	for (int i = 0; i < mesh->vertices.size(); ++i) {
+		const Vertex& v = mesh->vertices[i];
+		glm::vec2 uv = uvFromPosition ? glm::vec2(v.position) : v.texCoord;
+		vertices.push_back(Vertex(glm::vec3(modelMat * glm::vec4(v.position, 1)), glm::normalize(normalMat * v.normal), color, uv * glm::vec2(uvTransform) + glm::vec2(uvTransform.z, uvTransform.w), v.drawEdge));
+	}
+}
+
 void Face::select() {
+	// the selected face is modified, so it cannot share the mesh anymore
+	if (mesh) {
+		instantiate(vertices);
+		mesh.reset();
+	}
+
 	backupColor = vertices[0].color;
 	
 	for (int i = 0; i < vertices.size(); ++i) {
@@ -170,10 +225,17 @@ void Face::unselect() {
 }
 
 Face Face::rotate(float rad, const glm::vec3& axis) {
-	std::vector<Vertex> rotatedVertices(vertices.size());
-
 	glm::mat4 mat(glm::rotate(glm::mat4(), rad, axis));
 
+	if (mesh) {
+		Face face(name, grammar_type, mesh, mat * modelMat, color, texture);
+		face.uvTransform = uvTransform;
+		face.uvFromPosition = uvFromPosition;
+		return face;
+	}
+
+	std::vector<Vertex> rotatedVertices(vertices.size());
+
 	for (int i = 0; i < vertices.size(); ++i) {
 		rotatedVertices[i].position = glm::vec3(mat * glm::vec4(vertices[i].position, 1));
 	}
@@ -181,6 +243,23 @@ Face Face::rotate(float rad, const glm::vec3& axis) {
 	return Face(name, grammar_type, rotatedVertices, texture);
 }
 
+/**
+ * Replace the instances by the faces that own the flattened vertices, for the consumers that do not support instancing.
+ * The other faces are shared with the input.
+ */
+void flattenFaces(const std::vector<boost::shared_ptr<Face> >& faces, std::vector<boost::shared_ptr<Face> >& flattenedFaces) {
+	flattenedFaces.reserve(flattenedFaces.size() + faces.size());
+	for (int i = 0; i < faces.size(); ++i) {
+		if (faces[i]->isInstance()) {
+			std::vector<Vertex> vertices;
+			faces[i]->instantiate(vertices);
+			flattenedFaces.push_back(boost::shared_ptr<Face>(new Face(faces[i]->name, faces[i]->grammar_type, vertices, faces[i]->texture)));
+		} else {
+			flattenedFaces.push_back(faces[i]);
+		}
+	}
+}
+
 /**
  * Test if the point is inside the polygon
  */
@@ -438,148 +517,63 @@ void drawQuad(float w, float h, const glm::vec2& t1, const glm::vec2& t2, const
 	vertices.push_back(Vertex(glm::vec3(p4), glm::vec3(n), glm::vec4(1, 1, 1, 1), t4, 1));
 }
 
-void drawPolygon(const std::vector<glm::vec3>& points, const glm::vec4& color, const std::vector<glm::vec2>& texCoords, const glm::mat4& mat, std::vector<Vertex>& vertices) {
-	glm::vec4 p1(points.back(), 1);
-	p1 = mat * p1;
-	glm::vec2 t1 = texCoords.back();
-	glm::vec4 p2(points[0], 1);
-	p2 = mat * p2;
-	glm::vec2 t2 = texCoords[0];
-
-	glm::vec3 normal;
-	bool normal_computed = false;
-
-	for (int i = 0; i < points.size() - 2; ++i) {
-		glm::vec4 p3(points[i + 1], 1);
-		p3 = mat * p3;
-		glm::vec2 t3 = texCoords[i + 1];
-
-		if (!normal_computed) {
-			normal = glm::normalize(glm::cross(glm::vec3(p2 - p1), glm::vec3(p3 - p1)));
-			normal_computed = true;
-		}
-
-		vertices.push_back(Vertex(glm::vec3(p1), normal, color, t1));
-		if (i < points.size() - 3) {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color, t2, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color, t2));
-		}
-		if (i > 0) {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color, t3, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color, t3));
-		}
-
-		p2 = p3;
-		t2 = t3;
+/**
+ * Generate a triangle fan of a convex polygon whose points are already transformed.
+ * texCoords can be NULL if the polygon is not textured.
+ */
+void drawTransformedPolygon(const glm::vec3* points, int n, const glm::vec4& color, const glm::vec2* texCoords, std::vector<Vertex>& vertices) {
+	if (n < 3) return;
+
+	glm::vec3 normal = glm::normalize(glm::cross(points[0] - points[n - 1], points[1] - points[n - 1]));
+	glm::vec2 t;
+
+	vertices.reserve(vertices.size() + (n - 2) * 3);
+	for (int i = 0; i < n - 2; ++i) {
+		if (texCoords != NULL) t = texCoords[n - 1];
+		vertices.push_back(Vertex(points[n - 1], normal, color, t));
+		if (texCoords != NULL) t = texCoords[i];
+		vertices.push_back(Vertex(points[i], normal, color, t, i < n - 3 ? 1.0f : 0.0f));
+		if (texCoords != NULL) t = texCoords[i + 1];
+		vertices.push_back(Vertex(points[i + 1], normal, color, t, i > 0 ? 1.0f : 0.0f));
 	}
 }
 
-void drawPolygon(const std::vector<glm::vec3>& points, const glm::vec4& color, const glm::mat4& mat, std::vector<Vertex>& vertices) {
-	glm::vec4 p1(points.back(), 1);
-	p1 = mat * p1;
-	glm::vec4 p2(points[0], 1);
-	p2 = mat * p2;
-
-	glm::vec3 normal;
-	bool normal_computed = false;
-
-	for (int i = 0; i < points.size() - 2; ++i) {
-		glm::vec4 p3(points[i + 1], 1);
-		p3 = mat * p3;
+void drawPolygon(const std::vector<glm::vec3>& points, const glm::vec4& color, const std::vector<glm::vec2>& texCoords, const glm::mat4& mat, std::vector<Vertex>& vertices) {
+	if (points.size() < 3) return;
 
-		if (!normal_computed) {
-			normal = glm::normalize(glm::cross(glm::vec3(p2 - p1), glm::vec3(p3 - p1)));
-			normal_computed = true;
-		}
+	std::vector<glm::vec3> pts(points.size());
+	transformPoints(mat, &points[0], &pts[0], points.size());
+	drawTransformedPolygon(&pts[0], pts.size(), color, &texCoords[0], vertices);
+}
 
-		vertices.push_back(Vertex(glm::vec3(p1), normal, color));
-		if (i < points.size() - 3) {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color));
-		}
-		if (i > 0) {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color));
-		}
+void drawPolygon(const std::vector<glm::vec3>& points, const glm::vec4& color, const glm::mat4& mat, std::vector<Vertex>& vertices) {
+	if (points.size() < 3) return;
 
-		p2 = p3;
-	}
+	std::vector<glm::vec3> pts(points.size());
+	transformPoints(mat, &points[0], &pts[0], points.size());
+	drawTransformedPolygon(&pts[0], pts.size(), color, NULL, vertices);
 }
 
 void drawPolygon(const std::vector<glm::vec2>& points, const glm::vec4& color, const glm::mat4& mat, std::vector<Vertex>& vertices) {
-	glm::vec4 p1(points.back(), 0, 1);
-	p1 = mat * p1;
-	glm::vec4 p2(points[0], 0, 1);
-	p2 = mat * p2;
-
-	glm::vec3 normal;
-	bool normal_computed = false;
+	if (points.size() < 3) return;
 
-	for (int i = 0; i < points.size() - 2; ++i) {
-		glm::vec4 p3(points[i + 1], 0, 1);
-		p3 = mat * p3;
-
-		if (!normal_computed) {
-			normal = glm::normalize(glm::cross(glm::vec3(p2 - p1), glm::vec3(p3 - p1)));
-			normal_computed = true;
-		}
-
-		vertices.push_back(Vertex(glm::vec3(p1), normal, color));
-		if (i < points.size() - 3) {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color));
-		}
-		if (i > 0) {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color));
-		}
-
-		p2 = p3;
+	std::vector<glm::vec3> pts(points.size());
+	for (int i = 0; i < points.size(); ++i) {
+		pts[i] = glm::vec3(points[i], 0);
 	}
+	transformPoints(mat, &pts[0], &pts[0], pts.size());
+	drawTransformedPolygon(&pts[0], pts.size(), color, NULL, vertices);
 }
 
 void drawPolygon(const std::vector<glm::vec2>& points, const glm::vec4& color, const std::vector<glm::vec2>& texCoords, const glm::mat4& mat, std::vector<Vertex>& vertices) {
-	glm::vec4 p1(points.back(), 0, 1);
-	p1 = mat * p1;
-	glm::vec2 t1 = texCoords.back();
-	glm::vec4 p2(points[0], 0, 1);
-	p2 = mat * p2;
-	glm::vec2 t2 = texCoords[0];
+	if (points.size() < 3) return;
 
-	glm::vec3 normal;
-	bool normal_computed = false;
-
-	for (int i = 0; i < points.size() - 2; ++i) {
-		glm::vec4 p3(points[i + 1], 0, 1);
-		p3 = mat * p3;
-		glm::vec2 t3 = texCoords[i + 1];
-
-		if (!normal_computed) {
-			normal = glm::normalize(glm::cross(glm::vec3(p2 - p1), glm::vec3(p3 - p1)));
-			normal_computed = true;
-		}
-
-		vertices.push_back(Vertex(glm::vec3(p1), normal, color, t1));
-		if (i < points.size() - 3) {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color, t2, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, color, t2));
-		}
-		if (i > 0) {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color, t3, 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p3), normal, color, t3));
-		}
-
-		p2 = p3;
-		t2 = t3;
+	std::vector<glm::vec3> pts(points.size());
+	for (int i = 0; i < points.size(); ++i) {
+		pts[i] = glm::vec3(points[i], 0);
 	}
+	transformPoints(mat, &pts[0], &pts[0], pts.size());
+	drawTransformedPolygon(&pts[0], pts.size(), color, &texCoords[0], vertices);
 }
 
 void drawConcavePolygon(const std::vector<glm::vec2>& points, const glm::vec4& color, const glm::mat4& mat, std::vector<Vertex>& vertices) {
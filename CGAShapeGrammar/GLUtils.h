@@ -5,6 +5,7 @@
 #include <glm/gtx/string_cast.hpp>
 #include "Vertex.h"
 #include <vector>
+#include <boost/shared_ptr.hpp>
 
 namespace glutils {
 
@@ -28,6 +29,25 @@ public:
 	bool contains(const glm::vec3& point, float threshold);
 };
 
+/**
+ * Immutable triangle mesh shared by all the instances of a repeated geometry.
+ * The vertices are in the local coordinates of the mesh, and their colors are given by the instances.
+ */
+class Mesh {
+public:
+	std::vector<Vertex> vertices;
+	BoundingBox bbox;
+
+public:
+	Mesh() {}
+	Mesh(const std::vector<Vertex>& vertices);
+};
+
+/**
+ * A face either owns its vertices in the world coordinates, or is an instance of a shared mesh.
+ * An instance has no vertices of its own, and the consumers have to draw the mesh with modelMat and color,
+ * or call instantiate() to get the flattened vertices.
+ */
 class Face {
 public:
 	std::string name;
@@ -37,17 +57,29 @@ public:
 	BoundingBox bbox;
 	std::string grammar_type;
 
+	// instance
+	boost::shared_ptr<const Mesh> mesh;
+	glm::mat4 modelMat;
+	glm::vec4 color;
+	glm::vec4 uvTransform;	// texCoord = (uvFromPosition ? position.xy : texCoord) * uvTransform.xy + uvTransform.zw
+	bool uvFromPosition;
+
 public:
-	Face() {}
+	Face() : uvFromPosition(false) {}
 	Face(const std::string& name, const std::string& grammar_type, const std::vector<Vertex>& vertices);
 	Face(const std::string& name, const std::string& grammar_type, const std::vector<Vertex>& vertices, const std::string& texture);
+	Face(const std::string& name, const std::string& grammar_type, const boost::shared_ptr<const Mesh>& mesh, const glm::mat4& modelMat, const glm::vec4& color, const std::string& texture);
 
+	bool isInstance() const { return mesh.get() != NULL; }
+	void instantiate(std::vector<Vertex>& vertices) const;
 	void select();
 	void unselect();
 
 	Face rotate(float rad, const glm::vec3& axis);
 };
 
+void flattenFaces(const std::vector<boost::shared_ptr<Face> >& faces, std::vector<boost::shared_ptr<Face> >& flattenedFaces);
+
 // geometry computation
 bool isWithinPolygon(const glm::vec2& p, const std::vector<glm::vec2>& points);
 float area(const std::vector<glm::vec2>& points);
@@ -64,6 +96,7 @@ void drawCircle(float r1, float r2, const glm::vec4& color, const glm::mat4& mat
 void drawCircle(float r1, float r2, float texWidth, float texHeight, const glm::mat4& mat, std::vector<Vertex>& vertices, int slices = 12);
 void drawQuad(float w, float h, const glm::vec4& color, const glm::mat4& mat, std::vector<Vertex>& vertices);
 void drawQuad(float w, float h, const glm::vec2& t1, const glm::vec2& t2, const glm::vec2& t3, const glm::vec2& t4, const glm::mat4& mat, std::vector<Vertex>& vertices);
+void drawTransformedPolygon(const glm::vec3* points, int n, const glm::vec4& color, const glm::vec2* texCoords, std::vector<Vertex>& vertices);
 void drawPolygon(const std::vector<glm::vec3>& points, const glm::vec4& color, const std::vector<glm::vec2>& texCoords, const glm::mat4& mat, std::vector<Vertex>& vertices);
 void drawPolygon(const std::vector<glm::vec3>& points, const glm::vec4& color, const glm::mat4& mat, std::vector<Vertex>& vertices);
 void drawPolygon(const std::vector<glm::vec2>& points, const glm::vec4& color, const std::vector<glm::vec2>& texCoords, const glm::mat4& mat, std::vector<Vertex>& vertices);
@@ -14,11 +14,108 @@
 #include <QTextStream>
 #include <iostream>
 #include "EDLinesLib.h"
+#include "SoftwareRenderer.h"
+#include "EdgeExtractor.h"
+#include "FrameReadback.h"
+#include "ImageWriter.h"
+#include "Dataset.h"
+#include "GeometryRing.h"
+#include <QCoreApplication>
 #include <QProcess>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+/** sizes of the buildings of generateBuildingImages(), each of which has BUILDINGS_PER_SIZE random buildings */
+const int MIN_WIDTH = 28;
+const int MAX_WIDTH = 28;
+const int MIN_DEPTH = 20;
+const int MAX_DEPTH = 20;
+const int BUILDINGS_PER_SIZE = 10;
+
+/** bytes of a slot of the geometry ring, which holds a building */
+const int RING_SLOT_SIZE = 32 * 1024 * 1024;
+
+/** size of the images and the ratio of the line pixels that may differ between OpenGL and the software renderer */
+const int CHECK_SIZE = 256;
+const float MAX_UNMATCHED_RATIO = 0.05f;
+
+/**
+ * Return the number of the line pixels of the image that have no line pixel of the other image within a pixel,
+ * and set the number of the line pixels of the image. Both are 8-bit BGRA images of the dark lines on the white background.
+ */
+int countUnmatchedLinePixels(const cv::Mat& image, const cv::Mat& other, int& numLinePixels) {
+	auto isLine = [](const cv::Mat& mat, int x, int y) {
+		const cv::Vec4b& color = mat.at<cv::Vec4b>(y, x);
+		return color[0] + color[1] + color[2] < 128 * 3;
+	};
+
+	int count = 0;
+	numLinePixels = 0;
+	for (int y = 0; y < image.rows; ++y) {
+		for (int x = 0; x < image.cols; ++x) {
+			if (!isLine(image, x, y)) continue;
+			numLinePixels++;
+
+			bool matched = false;
+			for (int v = std::max(0, y - 1); v <= std::min(other.rows - 1, y + 1) && !matched; ++v) {
+				for (int u = std::max(0, x - 1); u <= std::min(other.cols - 1, x + 1) && !matched; ++u) {
+					matched = isLine(other, u, v);
+				}
+			}
+			if (!matched) count++;
+		}
+	}
+	return count;
+}
+
+int numBuildings() {
+	return (MAX_WIDTH - MIN_WIDTH + 1) * (MAX_DEPTH - MIN_DEPTH + 1) * BUILDINGS_PER_SIZE;
+}
+
+/**
+ * Fix the view direction and the position of the camera for the building images.
+ */
+void setBuildingView(Camera& camera) {
+	camera.xrot = 0.0f;
+	camera.yrot = -40.0f;
+	camera.zrot = 0.0f;
+	camera.pos = glm::vec3(0, 15, 80);
+	camera.updateMVPMatrix();
+}
+
+/**
+ * Put the start shape of the building of the index on the stack, and return its parameter values.
+ * Each building uses its own random seed, so that it is the same in any process and in a resumed run.
+ */
+std::vector<float> startBuilding(cga::CGA& system, cga::Grammar& grammar, int index) {
+	int object_width = MIN_WIDTH + index / BUILDINGS_PER_SIZE / (MAX_DEPTH - MIN_DEPTH + 1);
+	int object_depth = MIN_DEPTH + index / BUILDINGS_PER_SIZE % (MAX_DEPTH - MIN_DEPTH + 1);
+	int offset_x = 0;
+	int offset_y = 0;
+	srand(index);
+
+	cga::Rectangle* start = new cga::Rectangle("Start", "", glm::translate(glm::rotate(glm::mat4(), -3.141592f * 0.5f, glm::vec3(1, 0, 0)), glm::vec3(offset_x - (float)object_width*0.5f, offset_y - (float)object_depth*0.5f, 0)), glm::mat4(), object_width, object_depth, glm::vec3(1, 1, 1));
+	system.stack.push_back(boost::shared_ptr<cga::Shape>(start));
+
+	std::vector<float> param_values = system.randomParamValues(grammar);
+
+	// put depth, width at the begining of the param values array
+	param_values.insert(param_values.begin() + 0, offset_x);
+	param_values.insert(param_values.begin() + 1, offset_y);
+	param_values.insert(param_values.begin() + 2, object_width);
+	param_values.insert(param_values.begin() + 3, object_depth);
+
+	return param_values;
+}
+
+}
 
 GLWidget3D::GLWidget3D(MainWindow *parent) : QGLWidget(QGLFormat(QGL::SampleBuffers)) {
 	this->mainWin = parent;
 	shiftPressed = false;
+	softwareRendering = false;
 
 	// 光源位置をセット
 	// ShadowMappingは平行光源を使っている。この位置から原点方向を平行光源の方向とする。
@@ -157,8 +254,11 @@ void GLWidget3D::initializeGL() {
 	if (glewIsSupported("GL_VERSION_4_2"))
 		printf("Ready for OpenGL 4.2\n");
 	else {
-		printf("OpenGL 4.2 not supported\n");
-		exit(1);
+		// only the line drawings of generateBuildingImages() are available without OpenGL 4.2
+		printf("OpenGL 4.2 not supported, so the images are rendered by the software renderer\n");
+		softwareRendering = true;
+		system.modelMat = glm::rotate(glm::mat4(), -3.1415926f * 0.5f, glm::vec3(1, 0, 0));
+		return;
 	}
 	const GLubyte* text = glGetString(GL_VERSION);
 	printf("VERSION: %s\n", text);
@@ -198,8 +298,10 @@ void GLWidget3D::initializeGL() {
  */
 void GLWidget3D::resizeGL(int width, int height) {
 	height = height ? height : 1;
-	glViewport(0, 0, width, height);
 	camera.updatePMatrix(width, height);
+	if (softwareRendering) return;
+
+	glViewport(0, 0, width, height);
 
 	renderManager.resize(width, height);
 }
@@ -208,6 +310,8 @@ void GLWidget3D::resizeGL(int width, int height) {
  * This function is called whenever the widget needs to be painted.
  */
 void GLWidget3D::paintGL() {
+	if (softwareRendering) return;
+
 	render();
 
 	//printf("<<\n");
@@ -232,29 +336,21 @@ void GLWidget3D::render() {
 
 	glMatrixMode(GL_MODELVIEW);
 
+	// the passes that the rendering mode does not need are skipped, and the shadow map is updated only when it is used
+	renderManager.updateRenderGraph();
+	const RenderGraph& graph = renderManager.graph;
+	if (graph.isEnabled(RenderGraph::PASS_SHADOW) && renderManager.shadowMapOutdated) {
+		renderManager.updateShadowMap(this, light_dir, light_mvpMatrix);
+	}
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// PASS 1: Render to texture
 	glUseProgram(renderManager.programs["pass1"]);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, renderManager.fragDataFB);
+	renderManager.bindGeometryBuffers();
 	glClearColor(0.95, 0.95, 0.95, 1);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, renderManager.fragDataTex[0], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, renderManager.fragDataTex[1], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, renderManager.fragDataTex[2], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, renderManager.fragDataTex[3], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, renderManager.fragDepthTex, 0);
-
-	// Set the list of draw buffers.
-	GLenum DrawBuffers[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-	glDrawBuffers(4, DrawBuffers); // "3" is the size of DrawBuffers
-	// Always check that our framebuffer is ok
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-		printf("+ERROR: GL_FRAMEBUFFER_COMPLETE false\n");
-		exit(0);
-	}
-
 	glUniformMatrix4fv(glGetUniformLocation(renderManager.programs["pass1"], "mvpMatrix"), 1, false, &camera.mvpMatrix[0][0]);
 	glUniform3f(glGetUniformLocation(renderManager.programs["pass1"], "lightDir"), light_dir.x, light_dir.y, light_dir.z);
 	glUniformMatrix4fv(glGetUniformLocation(renderManager.programs["pass1"], "light_mvpMatrix"), 1, false, &light_mvpMatrix[0][0]);
@@ -269,7 +365,7 @@ void GLWidget3D::render() {
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// PASS 2: Create AO
-	if (renderManager.renderingMode == RenderManager::RENDERING_MODE_SSAO) {
+	if (graph.isEnabled(RenderGraph::PASS_SSAO)) {
 		glUseProgram(renderManager.programs["ssao"]);
 		glBindFramebuffer(GL_FRAMEBUFFER, renderManager.fragDataFB_AO);
 
@@ -333,69 +429,14 @@ void GLWidget3D::render() {
 		glBindVertexArray(0);
 		glDepthFunc(GL_LEQUAL);
 	}
-	else if (renderManager.renderingMode == RenderManager::RENDERING_MODE_LINE || renderManager.renderingMode == RenderManager::RENDERING_MODE_HATCHING) {
-		glUseProgram(renderManager.programs["line"]);
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClearColor(1, 1, 1, 1);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glDisable(GL_DEPTH_TEST);
-		glDepthFunc(GL_ALWAYS);
-
-		glUniform2f(glGetUniformLocation(renderManager.programs["line"], "pixelSize"), 1.0f / this->width(), 1.0f / this->height());
-		glUniformMatrix4fv(glGetUniformLocation(renderManager.programs["line"], "pMatrix"), 1, false, &camera.pMatrix[0][0]);
-		if (renderManager.renderingMode == RenderManager::RENDERING_MODE_LINE) {
-			glUniform1i(glGetUniformLocation(renderManager.programs["line"], "useHatching"), 0);
-		}
-		else {
-			glUniform1i(glGetUniformLocation(renderManager.programs["line"], "useHatching"), 1);
-		}
-
-		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex0"), 1);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[0]);
-
-		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex1"), 2);
-		glActiveTexture(GL_TEXTURE2);
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[1]);
-
-		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex2"), 3);
-		glActiveTexture(GL_TEXTURE3);
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[2]);
-
-		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex3"), 4);
-		glActiveTexture(GL_TEXTURE4);
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[3]);
-
-		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "depthTex"), 8);
-		glActiveTexture(GL_TEXTURE8);
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, renderManager.fragDepthTex);
-
-		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "hatchingTexture"), 5);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_3D, renderManager.hatchingTextures);
-		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-		glBindVertexArray(renderManager.secondPassVAO);
-
-		glDrawArrays(GL_QUADS, 0, 4);
-		glBindVertexArray(0);
-		glDepthFunc(GL_LEQUAL);
+	else if (graph.isEnabled(RenderGraph::PASS_LINE)) {
+		renderLines(0, width(), height(), camera.pMatrix);
 	}
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Blur
 
-	if (renderManager.renderingMode != RenderManager::RENDERING_MODE_LINE && renderManager.renderingMode != RenderManager::RENDERING_MODE_HATCHING) {
+	if (graph.isEnabled(RenderGraph::PASS_BLUR)) {
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		qglClearColor(QColor(0xFF, 0xFF, 0xFF));
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -450,8 +491,119 @@ void GLWidget3D::render() {
 	glActiveTexture(GL_TEXTURE0);
 }
 
+/**
+ * Render the objects of the groups, which are added with RenderAtlas::group(), from each of the views,
+ * and draw the lines of all the tiles by a single pass. The g-th group seen from the v-th view is rendered
+ * into the (g * views.size() + v)-th tile. The views must share the projection, and the buffers of the
+ * render manager must be resized to the atlas. The shadow map is not updated, since it is shared by the tiles.
+ */
+void GLWidget3D::renderAtlas(const RenderAtlas& atlas, int numGroups, const std::vector<Camera>& views) {
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// PASS 1: Render the tiles to texture
+	glUseProgram(renderManager.programs["pass1"]);
+
+	renderManager.updateRenderGraph();
+	renderManager.bindGeometryBuffers();
+	glViewport(0, 0, atlas.width(), atlas.height());
+	glClearColor(0.95, 0.95, 0.95, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glUniform3f(glGetUniformLocation(renderManager.programs["pass1"], "lightDir"), light_dir.x, light_dir.y, light_dir.z);
+	glUniformMatrix4fv(glGetUniformLocation(renderManager.programs["pass1"], "light_mvpMatrix"), 1, false, &light_mvpMatrix[0][0]);
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["pass1"], "shadowMap"), 6);
+	glActiveTexture(GL_TEXTURE6);
+	glBindTexture(GL_TEXTURE_2D, renderManager.shadow.textureDepth);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(true);
+	for (int i = 0; i < numGroups; ++i) {
+		std::vector<RenderView> renderViews;
+		for (int v = 0; v < views.size(); ++v) {
+			int x, y;
+			atlas.tileOrigin(i * views.size() + v, x, y);
+			renderViews.push_back(RenderView(x, y, atlas.tileWidth, atlas.tileHeight, views[v].mvpMatrix));
+		}
+		renderManager.renderGroup(RenderAtlas::group(i), renderViews);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// PASS 2: Draw the lines of the whole atlas
+	if (!views.empty()) {
+		renderLines(atlas.fbo, atlas.width(), atlas.height(), views[0].pMatrix);
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/**
+ * Draw the lines from the buffers of the first pass into the frame buffer of the given size.
+ */
+void GLWidget3D::renderLines(GLuint framebuffer, int width, int height, const glm::mat4& pMatrix) {
+	glUseProgram(renderManager.programs["line"]);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+	glClearColor(1, 1, 1, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glDisable(GL_DEPTH_TEST);
+	glDepthFunc(GL_ALWAYS);
+
+	glUniform2f(glGetUniformLocation(renderManager.programs["line"], "pixelSize"), 1.0f / width, 1.0f / height);
+	glUniformMatrix4fv(glGetUniformLocation(renderManager.programs["line"], "pMatrix"), 1, false, &pMatrix[0][0]);
+	if (renderManager.renderingMode == RenderManager::RENDERING_MODE_LINE) {
+		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "useHatching"), 0);
+	}
+	else {
+		glUniform1i(glGetUniformLocation(renderManager.programs["line"], "useHatching"), 1);
+	}
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex0"), 1);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[0]);
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex1"), 2);
+	glActiveTexture(GL_TEXTURE2);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[1]);
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex2"), 3);
+	glActiveTexture(GL_TEXTURE3);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[2]);
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["line"], "tex3"), 4);
+	glActiveTexture(GL_TEXTURE4);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, renderManager.fragDataTex[3]);
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["line"], "depthTex"), 8);
+	glActiveTexture(GL_TEXTURE8);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, renderManager.fragDepthTex);
+
+	glUniform1i(glGetUniformLocation(renderManager.programs["line"], "hatchingTexture"), 5);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_3D, renderManager.hatchingTextures);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	glBindVertexArray(renderManager.secondPassVAO);
+
+	glDrawArrays(GL_QUADS, 0, 4);
+	glBindVertexArray(0);
+	glDepthFunc(GL_LEQUAL);
+}
+
 void GLWidget3D::loadCGA(char* filename) {
-	renderManager.removeObjects();
+	if (!softwareRendering) {
+		renderManager.removeObjects();
+	}
 
 	float offset_x = 0.0f;
 	float offset_y = 0.0f;
@@ -470,11 +622,19 @@ void GLWidget3D::loadCGA(char* filename) {
 	try {
 		cga::Grammar grammar;
 		cga::parseGrammar(filename, grammar);
+		system.preload(grammar, softwareRendering ? NULL : &renderManager);
 		//system.randomParamValues(grammar);
-		system.derive(grammar, true);
 		faces.clear();
-		system.generateGeometry(faces);
-		renderManager.addFaces(faces);
+		system.generate(grammar, faces, true);
+		if (system.geometryCached) {
+			mainWin->statusBar()->showMessage("The geometry is loaded from the cache.");
+		}
+		else if (system.faceCulling.enabled) {
+			mainWin->statusBar()->showMessage(QString("Face culling: %1 of %2 triangles removed.").arg(system.faceCulling.numCulledTriangles).arg(system.faceCulling.numTriangles));
+		}
+		if (!softwareRendering) {
+			renderManager.addFaces(faces);
+		}
 	} catch (const std::string& ex) {
 		std::cout << "ERROR:" << std::endl << ex << std::endl;
 	} catch (const char* ex) {
@@ -487,20 +647,56 @@ void GLWidget3D::loadCGA(char* filename) {
 	glutils::drawGrid(100, 100, 2.5, glm::vec4(0.521, 0.815, 0.917, 1), glm::vec4(0.898, 0.933, 0.941, 1), system.modelMat, vertices);
 	renderManager.addObject("grid", "", vertices, false);
 	*/
-	renderManager.updateShadowMap(this, light_dir, light_mvpMatrix);
+	if (!softwareRendering) {
+		renderManager.updateShadowMap(this, light_dir, light_mvpMatrix);
+	}
 
 	updateGL();
 }
 
-void GLWidget3D::generateBuildingImages(int image_width, int image_height, bool grayscale) {
-	QString resultDir = "results/buildings/";
+/**
+ * Derive the grammar, and write the geometry to the sink while deriving without keeping it in memory.
+ * The scene that is shown is not changed.
+ */
+void GLWidget3D::exportCGA(char* filename, GeometrySink& sink) {
+	float object_width = 28.0f;
+	float object_depth = 20.0f;
+	cga::Rectangle* start = new cga::Rectangle("Start", "", glm::translate(glm::rotate(glm::mat4(), -3.141592f * 0.5f, glm::vec3(1, 0, 0)), glm::vec3(-(float)object_width*0.5f, -(float)object_depth*0.5f, 0)), glm::mat4(), object_width, object_depth, glm::vec3(1, 1, 1));
+	system.stack.push_back(boost::shared_ptr<cga::Shape>(start));
 
-	if (QDir(resultDir).exists()) {
-		QDir(resultDir).removeRecursively();
+	try {
+		cga::Grammar grammar;
+		cga::parseGrammar(filename, grammar);
+		system.preload(grammar);
+		system.derive(grammar, sink, true);
+	} catch (const std::string& ex) {
+		std::cout << "ERROR:" << std::endl << ex << std::endl;
+	} catch (const char* ex) {
+		std::cout << "ERROR:" << std::endl << ex << std::endl;
 	}
+	sink.close();
+}
+
+/**
+ * Generate the line drawings of random buildings and their parameter values in results/buildings/.
+ * They are written to the sharded dataset, or to the given sink with the parameter values in parameters.txt.
+ * The samples that the sink has already written in a previous run are skipped, and each sample uses its own
+ * random seed, so that a resumed run produces the same samples.
+ * Each building is seen from numViews directions around it, and its v-th view is the sample of the index
+ * building index * numViews + v, which has the parameter values of the building.
+ * With OpenGL, the views of the buildings are rendered into up to tilesPerAtlas tiles of an atlas at once,
+ * and read back together.
+ * If sketch is true, the visible edges are extracted from the geometry and drawn by the stylized polylines
+ * instead of the line rendering, in grayscale or in color, and they are written in results/sketches/ instead,
+ * so that they do not mix with the line drawings of the same indices.
+ * If numWorkers is given with OpenGL, the buildings are derived by as many worker processes of runRingWorker(),
+ * and they are rendered from the slots of the geometry ring without copying them.
+ */
+void GLWidget3D::generateBuildingImages(int image_width, int image_height, bool grayscale, int numViews, int tilesPerAtlas, const boost::shared_ptr<ImageSink>& sink, bool sketch, int numWorkers) {
+	QString resultDir = sketch ? "results/sketches/" : "results/buildings/";
 	QDir().mkpath(resultDir);
+	bool useGL = !softwareRendering && !sketch;
 
-	srand(0);
 	renderManager.renderingMode = RenderManager::RENDERING_MODE_LINE;
 
 	int origWidth = width();
@@ -509,92 +705,357 @@ void GLWidget3D::generateBuildingImages(int image_width, int image_height, bool
 	//resizeGL(512, 512);
 
 	// fix camera view direction and position
-	camera.xrot = 0.0f;
-	camera.yrot = -40.0f;
-	camera.zrot = 0.0f;
-	camera.pos = glm::vec3(0, 15, 80);
-	camera.updateMVPMatrix();
+	setBuildingView(camera);
 
-	QFile file(resultDir + "parameters.txt");
-	if (!file.open(QIODevice::WriteOnly)) {
-		std::cerr << "Cannot open file for writing: " << qPrintable(file.errorString()) << std::endl;
-		return;
+	// the images are rendered in the output size
+	Camera imageCamera = camera;
+	imageCamera.updatePMatrix(image_width, image_height);
+
+	// the views turn around the building at the same distance
+	std::vector<Camera> views(numViews, imageCamera);
+	for (int v = 0; v < numViews; ++v) {
+		views[v].yrot += 360.0f * v / numViews;
+		views[v].updateMVPMatrix();
 	}
 
-	QTextStream out(&file);
+	// skip the details that are smaller than a pixel in the output image, which are about the same for all the views
+	system.lodPolicy = cga::LODPolicy(imageCamera.mvpMatrix, image_width, image_height);
+
+	// the frames are read back and encoded while the next buildings are generated and rendered
+	boost::shared_ptr<ImageSink> imageSink = sink;
+	std::string parameterFilename;
+	if (imageSink.get() == NULL) {
+		// the existing dataset may be broken or have been written with other settings
+		try {
+			imageSink = boost::shared_ptr<ImageSink>(new DatasetWriter(resultDir.toStdString()));
+		} catch (const std::string& ex) {
+			mainWin->statusBar()->showMessage(ex.c_str());
+			return;
+		} catch (const char* ex) {
+			mainWin->statusBar()->showMessage(ex);
+			return;
+		}
+	}
+	else {
+		parameterFilename = (resultDir + "parameters.txt").toStdString();
+	}
+	ImageWriter imageWriter(imageSink, parameterFilename);
 
-	int count = 0;
-	for (int object_width = 28; object_width <= 28; object_width += 1) {
-		for (int object_depth = 20; object_depth <= 20; object_depth += 1) {
-			int offset_x = 0;
-			int offset_y = 0;
-
-			for (int k = 0; k < 10; ++k) {
-				std::vector<float> param_values;
-
-				renderManager.removeObjects();
-
-				// generate a building
-				cga::Rectangle* start = new cga::Rectangle("Start", "", glm::translate(glm::rotate(glm::mat4(), -3.141592f * 0.5f, glm::vec3(1, 0, 0)), glm::vec3(offset_x - (float)object_width*0.5f, offset_y - (float)object_depth*0.5f, 0)), glm::mat4(), object_width, object_depth, glm::vec3(1, 1, 1));
-				system.stack.push_back(boost::shared_ptr<cga::Shape>(start));
-
-				cga::Grammar grammar;
-				cga::parseGrammar("../cga/building.xml", grammar);
-				param_values = system.randomParamValues(grammar);
-				system.derive(grammar, true);
-				std::vector<boost::shared_ptr<glutils::Face> > faces;
-				system.generateGeometry(faces);
-				renderManager.addFaces(faces);
-
-				renderManager.updateShadowMap(this, light_dir, light_mvpMatrix);
-
-				// render a building
-				/*glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-				glEnable(GL_DEPTH_TEST);
-				glDisable(GL_TEXTURE_2D);*/
-				render();
-
-				QImage img = this->grabFrameBuffer();
-				cv::Mat mat = cv::Mat(img.height(), img.width(), CV_8UC4, img.bits(), img.bytesPerLine()).clone();
-
-				// 画像を縮小
-				/*cv::resize(mat, mat, cv::Size(256, 256));
-				cv::threshold(mat, mat, 250, 255, CV_THRESH_BINARY);
-				cv::resize(mat, mat, cv::Size(image_width, image_height));
-				cv::threshold(mat, mat, 250, 255, CV_THRESH_BINARY);
-				*/
-
-				// put depth, width at the begining of the param values array
-				param_values.insert(param_values.begin() + 0, offset_x);
-				param_values.insert(param_values.begin() + 1, offset_y);
-				param_values.insert(param_values.begin() + 2, object_width);
-				param_values.insert(param_values.begin() + 3, object_depth);
-
-				// set filename
-				QString filename = resultDir + "/" + QString("image_%1.png").arg(count, 6, 10, QChar('0'));
-				cv::imwrite(filename.toUtf8().constData(), mat);
-
-				// write all the param values to the file
-				for (int pi = 0; pi < param_values.size(); ++pi) {
-					if (pi > 0) {
-						out << ",";
-					}
-					out << param_values[pi];
+	auto isWritten = [&](int count) {
+		for (int v = 0; v < numViews; ++v) {
+			if (!imageSink->isWritten(count * numViews + v)) return false;
+		}
+		return true;
+	};
+
+	// the workers derive the buildings from the first one that is not written
+	int firstBuilding = 0;
+	while (firstBuilding < numBuildings() && isWritten(firstBuilding)) firstBuilding++;
+	boost::shared_ptr<GeometryRing> ring;
+	std::vector<boost::shared_ptr<QProcess> > workers;
+	if (numWorkers > 0 && useGL) {
+		QString key = QString("CGAShapeGrammar-%1").arg(QCoreApplication::applicationPid());
+		ring = boost::shared_ptr<GeometryRing>(new GeometryRing(key));
+		if (!ring->create(numWorkers * 2, RING_SLOT_SIZE)) {
+			mainWin->statusBar()->showMessage("Cannot create the geometry ring.");
+			return;
+		}
+
+		for (int i = 0; i < numWorkers; ++i) {
+			QStringList args;
+			args << "--ring-worker" << key << QString::number(image_width) << QString::number(image_height) << QString::number(firstBuilding + i) << QString::number(numBuildings()) << QString::number(numWorkers);
+			boost::shared_ptr<QProcess> worker(new QProcess());
+			worker->setProcessChannelMode(QProcess::ForwardedChannels);
+			worker->start(QCoreApplication::applicationFilePath(), args);
+			workers.push_back(worker);
+		}
+	}
+
+	RenderAtlas atlas;
+	FrameReadback frameReadback;
+	boost::shared_ptr<SoftwareRenderer> softwareRenderer;
+	if (!useGL) {
+		softwareRenderer = boost::shared_ptr<SoftwareRenderer>(new SoftwareRenderer(image_width, image_height));
+	}
+	else {
+		makeCurrent();
+		atlas.init(image_width, image_height, std::max(1, tilesPerAtlas / numViews) * numViews);
+		renderManager.resize(atlas.width(), atlas.height());
+		renderManager.removeObjects();
+		frameReadback.init(atlas.width(), atlas.height());
+	}
+	std::map<int, std::vector<float> > frameParamValues;
+	std::map<int, std::vector<int> > atlasSamples;
+	std::vector<int> tileSamples;
+	std::vector<GeometryRing::Slot> tileSlots;
+	int atlasCount = 0;
+	cv::Mat frame;
+	int frameId;
+
+	// pass the tiles of the atlas read back to the encoders
+	auto writeTiles = [&]() {
+		std::vector<int>& samples = atlasSamples[frameId];
+		for (int i = 0; i < samples.size(); ++i) {
+			for (int v = 0; v < numViews; ++v) {
+				int tile = i * numViews + v;
+				imageWriter.write(samples[i] * numViews + v, frame.empty() ? cv::Mat() : atlas.tileImage(frame, tile), frameParamValues[samples[i]]);
+			}
+			frameParamValues.erase(samples[i]);
+		}
+		atlasSamples.erase(frameId);
+	};
+
+	// render the buildings added to the tiles from all the views, and queue the readback of the atlas
+	auto renderTiles = [&]() {
+		if (tileSamples.empty()) return;
+
+		renderAtlas(atlas, tileSamples.size(), views);
+		renderManager.removeObjects();
+
+		// the vertices of the slots have been copied to the geometry buffer
+		for (int i = 0; i < tileSlots.size(); ++i) {
+			ring->release(tileSlots[i]);
+		}
+		tileSlots.clear();
+
+		if (frameReadback.isFull() && frameReadback.takeFrame(frame, frameId, true)) {
+			writeTiles();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, atlas.fbo);
+		frameReadback.readPixels(atlasCount);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		atlasSamples[atlasCount++] = tileSamples;
+		tileSamples.clear();
+
+		while (frameReadback.takeFrame(frame, frameId, false)) {
+			writeTiles();
+		}
+	};
+
+	// all the samples derive the same grammar with different values of the attributes
+	cga::Grammar grammar;
+	cga::parseGrammar("../cga/building.xml", grammar);
+	system.preload(grammar, useGL ? &renderManager : NULL);
+
+	if (ring.get() != NULL) {
+		int numReceived = 0;
+		while (numReceived < numBuildings() - firstBuilding) {
+			GeometryRing::Slot slot;
+			if (!ring->acquire(slot)) {
+				bool running = false;
+				for (int i = 0; i < workers.size(); ++i) {
+					workers[i]->waitForFinished(0);
+					if (workers[i]->state() != QProcess::NotRunning) running = true;
 				}
-				out << "\n";
+				if (running) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					continue;
+				}
+
+				// the workers may have pushed the last buildings just before they exited
+				if (!ring->acquire(slot)) break;
+			}
+			numReceived++;
+
+			if (isWritten(slot.id)) {
+				ring->release(slot);
+				continue;
+			}
 
-				count++;
+			// the slot is kept until the tiles are rendered
+			for (int i = 0; i < slot.numRanges; ++i) {
+				const GeometryRing::Range& range = slot.ranges[i];
+				renderManager.addObject(RenderAtlas::group(tileSamples.size()) + range.name, range.texture, slot.vertices + range.firstVertex, range.numVertices, true);
+			}
+			tileSlots.push_back(slot);
+			tileSamples.push_back(slot.id);
+			frameParamValues[slot.id] = std::vector<float>(slot.paramValues, slot.paramValues + slot.numParams);
+			if (tileSamples.size() * numViews == atlas.numTiles) {
+				renderTiles();
+			}
+		}
+
+		if (numReceived < numBuildings() - firstBuilding) {
+			mainWin->statusBar()->showMessage(QString("The worker processes did not derive %1 buildings.").arg(numBuildings() - firstBuilding - numReceived));
+		}
+	}
+	else {
+		for (int count = 0; count < numBuildings(); ++count) {
+			if (isWritten(count)) continue;
+
+			// generate a building
+			std::vector<float> param_values = startBuilding(system, grammar, count);
+			std::vector<boost::shared_ptr<glutils::Face> > faces;
+			system.generate(grammar, faces, true);
+
+			if (sketch) {
+				for (int v = 0; v < numViews; ++v) {
+					cv::Mat mat;
+					drawVisibleEdges(faces, views[v], *softwareRenderer, mat, grayscale);
+					imageWriter.write(count * numViews + v, mat, param_values);
+				}
+			}
+			else if (softwareRendering) {
+				for (int v = 0; v < numViews; ++v) {
+					softwareRenderer->render(faces, views[v].mvpMatrix);
+
+					QImage img;
+					softwareRenderer->drawLines(views[v].pMatrix, img);
+					cv::Mat mat = cv::Mat(img.height(), img.width(), CV_8UC4, img.bits(), img.bytesPerLine()).clone();
+					imageWriter.write(count * numViews + v, mat, param_values);
+				}
+			}
+			else {
+				// the shadow map is not updated, since the line drawings do not use the light intensity
+				renderManager.addFaces(faces, RenderAtlas::group(tileSamples.size()));
+				tileSamples.push_back(count);
+				frameParamValues[count] = param_values;
+				if (tileSamples.size() * numViews == atlas.numTiles) {
+					renderTiles();
+				}
 			}
 
+			// 画像を縮小
+			/*cv::resize(mat, mat, cv::Size(256, 256));
+			cv::threshold(mat, mat, 250, 255, CV_THRESH_BINARY);
+			cv::resize(mat, mat, cv::Size(image_width, image_height));
+			cv::threshold(mat, mat, 250, 255, CV_THRESH_BINARY);
+			*/
 		}
+	}
 
-		file.close();
+	if (useGL) {
+		renderTiles();
+		while (frameReadback.takeFrame(frame, frameId, true)) {
+			writeTiles();
+		}
+		frameReadback.release();
+		atlas.release();
+		renderManager.resize(width(), height());
+		glViewport(0, 0, width(), height());
 	}
+	imageWriter.close();
+
+	system.lodPolicy = cga::LODPolicy();
 
 	//resize(origWidth, origHeight);
 	//resizeGL(origWidth, origHeight);
 }
 
+/**
+ * Check that the software renderer produces the same buffers and lines with and without SSE and with any number of
+ * threads, and, if OpenGL 4.2 is available, that its lines match those of the line rendering of generateBuildingImages()
+ * within a pixel, since the rasterization rules of the drivers differ. The result is shown in the status bar.
+ */
+void GLWidget3D::checkSoftwareRenderer() {
+	if (!SoftwareRenderer::checkConsistency(CHECK_SIZE, CHECK_SIZE)) {
+		mainWin->statusBar()->showMessage("The software renderer depends on SSE or the number of threads.");
+		return;
+	}
+	if (softwareRendering) {
+		mainWin->statusBar()->showMessage("The software renderer is consistent. OpenGL 4.2 is not available to compare with.");
+		return;
+	}
+
+	std::vector<boost::shared_ptr<glutils::Face> > faces;
+	Camera view;
+	SoftwareRenderer::checkScene(faces, view, CHECK_SIZE, CHECK_SIZE);
+
+	SoftwareRenderer softwareRenderer(CHECK_SIZE, CHECK_SIZE);
+	softwareRenderer.render(faces, view.mvpMatrix);
+	QImage img;
+	softwareRenderer.drawLines(view.pMatrix, img);
+	cv::Mat softwareImage(img.height(), img.width(), CV_8UC4, img.bits(), img.bytesPerLine());
+
+	// render the scene into a single tile in the same way as generateBuildingImages(), next to the objects that are shown
+	makeCurrent();
+	int origRenderingMode = renderManager.renderingMode;
+	renderManager.renderingMode = RenderManager::RENDERING_MODE_LINE;
+	RenderAtlas atlas;
+	atlas.init(CHECK_SIZE, CHECK_SIZE, 1);
+	renderManager.resize(atlas.width(), atlas.height());
+	renderManager.addFaces(faces, RenderAtlas::group(0));
+	renderAtlas(atlas, 1, std::vector<Camera>(1, view));
+	for (int i = 0; i < faces.size(); ++i) {
+		renderManager.removeObject(RenderAtlas::group(0) + faces[i]->name.c_str());
+	}
+
+	FrameReadback frameReadback;
+	frameReadback.init(atlas.width(), atlas.height(), 1);
+	glBindFramebuffer(GL_FRAMEBUFFER, atlas.fbo);
+	frameReadback.readPixels(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	cv::Mat frame;
+	int frameId;
+	bool read = frameReadback.takeFrame(frame, frameId, true) && !frame.empty();
+	cv::Mat glImage = read ? atlas.tileImage(frame, 0).clone() : cv::Mat();
+	frameReadback.release();
+	atlas.release();
+
+	renderManager.renderingMode = origRenderingMode;
+	renderManager.resize(width(), height());
+	glViewport(0, 0, width(), height());
+	updateGL();
+
+	if (!read) {
+		mainWin->statusBar()->showMessage("The line rendering of OpenGL cannot be read back.");
+		return;
+	}
+
+	int numGLLinePixels;
+	int numSoftwareLinePixels;
+	int numUnmatched = countUnmatchedLinePixels(glImage, softwareImage, numGLLinePixels) + countUnmatchedLinePixels(softwareImage, glImage, numSoftwareLinePixels);
+	float ratio = (float)numUnmatched / std::max(1, numGLLinePixels + numSoftwareLinePixels);
+	if (ratio > MAX_UNMATCHED_RATIO) {
+		mainWin->statusBar()->showMessage(QString("The software renderer differs from OpenGL: %1% of the line pixels are more than a pixel apart.").arg(ratio * 100, 0, 'f', 2));
+	}
+	else {
+		mainWin->statusBar()->showMessage(QString("The software renderer is consistent and matches OpenGL: %1% of the line pixels are more than a pixel apart.").arg(ratio * 100, 0, 'f', 2));
+	}
+}
+
+/**
+ * Derive the buildings first, first + step, ... below last of generateBuildingImages() in a worker process,
+ * and push them to the geometry ring of the key. The geometry is streamed to the ring while deriving,
+ * so that the face culling is applied among the faces of each rule application.
+ * Return the exit code of the process.
+ */
+int GLWidget3D::runRingWorker(const QString& key, int image_width, int image_height, int first, int last, int step) {
+	GeometryRing ring(key);
+	if (!ring.attach()) {
+		std::cerr << "Cannot attach to the geometry ring: " << key.toStdString() << std::endl;
+		return 1;
+	}
+
+	Camera imageCamera;
+	setBuildingView(imageCamera);
+	imageCamera.updatePMatrix(image_width, image_height);
+
+	cga::CGA system;
+	system.lodPolicy = cga::LODPolicy(imageCamera.mvpMatrix, image_width, image_height);
+
+	try {
+		cga::Grammar grammar;
+		cga::parseGrammar("../cga/building.xml", grammar);
+		system.preload(grammar);
+
+		for (int count = first; count < last; count += step) {
+			std::vector<float> param_values = startBuilding(system, grammar, count);
+			GeometryRingSink sink(ring, count, param_values);
+			system.derive(grammar, sink, true);
+			sink.close();
+		}
+	} catch (const std::string& ex) {
+		std::cerr << "ERROR:" << std::endl << ex << std::endl;
+		return 1;
+	} catch (const char* ex) {
+		std::cerr << "ERROR:" << std::endl << ex << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
 /**
  * http://www.ceng.anadolu.edu.tr/CV/EDLines/
  */
@@ -672,11 +1133,35 @@ void GLWidget3D::EDLine(const cv::Mat& source, cv::Mat& result, bool grayscale)
 		if (!erased) break;
 	}
 
+	drawEdges(edges, source.cols, source.rows, result, grayscale);
+}
+
+/**
+ * Draw the visible edges of the faces by the stylized polylines.
+ * Unlike EDLine(), the edges are extracted from the geometry, so that no image needs to be rendered and read back.
+ * The renderer only provides the depth for the hidden-line removal, and the image has its size.
+ */
+void GLWidget3D::drawVisibleEdges(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const Camera& camera, SoftwareRenderer& softwareRenderer, cv::Mat& result, bool grayscale) {
+	softwareRenderer.render(faces, camera.mvpMatrix);
+
+	std::vector<EdgeExtractor::FeatureEdge> featureEdges;
+	EdgeExtractor::extractFeatureEdges(faces, camera.mvpMatrix, featureEdges);
+
+	std::vector<std::pair<glm::vec2, glm::vec2> > edges;
+	EdgeExtractor::extractVisibleEdges(featureEdges, camera.mvpMatrix, camera.pMatrix, softwareRenderer, edges);
+
+	drawEdges(edges, softwareRenderer.width, softwareRenderer.height, result, grayscale);
+}
+
+/**
+ * Draw the edges by the randomly chosen stylized polylines on a white image.
+ */
+void GLWidget3D::drawEdges(const std::vector<std::pair<glm::vec2, glm::vec2> >& edges, int width, int height, cv::Mat& result, bool grayscale) {
 	if (grayscale) {
-		result = cv::Mat(source.rows, source.cols, CV_8U, cv::Scalar(255));
+		result = cv::Mat(height, width, CV_8U, cv::Scalar(255));
 	}
 	else {
-		result = cv::Mat(source.rows, source.cols, CV_8UC3, cv::Scalar(255, 255, 255));
+		result = cv::Mat(height, width, CV_8UC3, cv::Scalar(255, 255, 255));
 	}
 
 	for (int i = 0; i < edges.size(); ++i) {
@@ -10,11 +10,14 @@
 #include "ShadowMapping.h"
 #include "RenderManager.h"
 #include "CGA.h"
+#include "ImageSink.h"
+#include "RenderAtlas.h"
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
 class MainWindow;
+class SoftwareRenderer;
 
 class GLWidget3D : public QGLWidget {
 public:
@@ -22,9 +25,16 @@ public:
 
 	void drawScene();
 	void render();
+	void renderAtlas(const RenderAtlas& atlas, int numGroups, const std::vector<Camera>& views);
+	void renderLines(GLuint framebuffer, int width, int height, const glm::mat4& pMatrix);
 	void loadCGA(char* filename);
-	void generateBuildingImages(int image_width, int image_height, bool grayscale);
+	void exportCGA(char* filename, GeometrySink& sink);
+	void generateBuildingImages(int image_width, int image_height, bool grayscale, int numViews = 1, int tilesPerAtlas = 16, const boost::shared_ptr<ImageSink>& sink = boost::shared_ptr<ImageSink>(), bool sketch = false, int numWorkers = 0);
+	void checkSoftwareRenderer();
+	static int runRingWorker(const QString& key, int image_width, int image_height, int first, int last, int step);
 	void EDLine(const cv::Mat& source, cv::Mat& result, bool grayscale);
+	void drawVisibleEdges(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const Camera& camera, SoftwareRenderer& softwareRenderer, cv::Mat& result, bool grayscale);
+	void drawEdges(const std::vector<std::pair<glm::vec2, glm::vec2> >& edges, int width, int height, cv::Mat& result, bool grayscale);
 	void draw2DPolyline(cv::Mat& img, const glm::vec2& p0, const glm::vec2& p1, int polyline_index);
 	bool isImageValid(const cv::Mat& image);
 	void rotationStart();
@@ -54,6 +64,7 @@ public:
 	glm::vec3 light_dir;
 	glm::mat4 light_mvpMatrix;
 	bool shiftPressed;
+	bool softwareRendering;		// true if OpenGL 4.2 is not available
 
 	RenderManager renderManager;
 
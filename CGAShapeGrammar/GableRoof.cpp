@@ -185,6 +185,8 @@ void GableRoof::comp(const std::map<std::string, std::string>& name_map, std::ve
 }
 
 void GableRoof::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	std::vector<Vertex> vertices;
 
 	Polygon_2 poly;
@@ -263,9 +265,9 @@ void GableRoof::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >&
 					}
 
 					// 三角形を作成
-					glm::vec3 v0 = glm::vec3(_pivot * _modelMat * glm::vec4(p0, 0, 1));
-					glm::vec3 v1 = glm::vec3(_pivot * _modelMat * glm::vec4(prev_p, 1));
-					glm::vec3 v2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, z, 1));
+					glm::vec3 v0 = glm::vec3(shapeMat * glm::vec4(p0, 0, 1));
+					glm::vec3 v1 = glm::vec3(shapeMat * glm::vec4(prev_p, 1));
+					glm::vec3 v2 = glm::vec3(shapeMat * glm::vec4(p2, z, 1));
 
 					glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
 
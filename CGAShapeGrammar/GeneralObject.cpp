@@ -1,6 +1,7 @@
 #include "GeneralObject.h"
 #include "CGA.h"
 #include "GLUtils.h"
+#include "VertexTransform.h"
 
 namespace cga {
 
@@ -86,15 +87,31 @@ void GeneralObject::size(float xSize, float ySize, float zSize) {
 void GeneralObject::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	// transform the points of all the polygons in one batch
+	std::vector<glm::vec3> pts;
 	for (int i = 0; i < _points.size(); ++i) {
+		pts.insert(pts.end(), _points[i].begin(), _points[i].end());
+	}
+	if (pts.empty()) return;
+	glutils::transformPoints(_pivot * _modelMat, &pts[0], &pts[0], pts.size());
+
+	int offset = 0;
+	for (int i = 0; i < _points.size(); ++i) {
+		int n = _points[i].size();
+		if (n < 3) {
+			offset += n;
+			continue;
+		}
+
 		std::vector<Vertex> vertices;
 		if (_textureEnabled) {
-			glutils::drawPolygon(_points[i], glm::vec4(_color, opacity), _texCoords[i], _pivot * _modelMat, vertices);
+			glutils::drawTransformedPolygon(&pts[offset], n, glm::vec4(_color, opacity), &_texCoords[i][0], vertices);
 			faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
 		} else {
-			glutils::drawPolygon(_points[i], glm::vec4(_color, opacity), _pivot * _modelMat, vertices);
+			glutils::drawTransformedPolygon(&pts[offset], n, glm::vec4(_color, opacity), NULL, vertices);
 			faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 		}
+		offset += n;
 	}
 }
 
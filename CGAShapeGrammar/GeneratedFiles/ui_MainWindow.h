@@ -48,6 +48,13 @@ public:
     QAction *actionRotationStart;
     QAction *actionRotationEnd;
     QAction *actionSaveGeometry;
+    QAction *actionViewCullHiddenFaces;
+    QAction *actionViewCacheGeometry;
+    QAction *actionViewCacheAssets;
+    QAction *actionExportGeometryWhileDeriving;
+    QAction *actionGenerateSketchImages;
+    QAction *actionGenerateBuildingImagesInWorkers;
+    QAction *actionCheckSoftwareRenderer;
     QWidget *centralWidget;
     QMenuBar *menuBar;
     QMenu *menuFile;
@@ -111,6 +118,23 @@ public:
         actionRotationEnd->setObjectName(QStringLiteral("actionRotationEnd"));
         actionSaveGeometry = new QAction(MainWindowClass);
         actionSaveGeometry->setObjectName(QStringLiteral("actionSaveGeometry"));
+        actionViewCullHiddenFaces = new QAction(MainWindowClass);
+        actionViewCullHiddenFaces->setObjectName(QStringLiteral("actionViewCullHiddenFaces"));
+        actionViewCullHiddenFaces->setCheckable(true);
+        actionViewCacheGeometry = new QAction(MainWindowClass);
+        actionViewCacheGeometry->setObjectName(QStringLiteral("actionViewCacheGeometry"));
+        actionViewCacheGeometry->setCheckable(true);
+        actionViewCacheAssets = new QAction(MainWindowClass);
+        actionViewCacheAssets->setObjectName(QStringLiteral("actionViewCacheAssets"));
+        actionViewCacheAssets->setCheckable(true);
+        actionExportGeometryWhileDeriving = new QAction(MainWindowClass);
+        actionExportGeometryWhileDeriving->setObjectName(QStringLiteral("actionExportGeometryWhileDeriving"));
+        actionGenerateSketchImages = new QAction(MainWindowClass);
+        actionGenerateSketchImages->setObjectName(QStringLiteral("actionGenerateSketchImages"));
+        actionGenerateBuildingImagesInWorkers = new QAction(MainWindowClass);
+        actionGenerateBuildingImagesInWorkers->setObjectName(QStringLiteral("actionGenerateBuildingImagesInWorkers"));
+        actionCheckSoftwareRenderer = new QAction(MainWindowClass);
+        actionCheckSoftwareRenderer->setObjectName(QStringLiteral("actionCheckSoftwareRenderer"));
         centralWidget = new QWidget(MainWindowClass);
         centralWidget->setObjectName(QStringLiteral("centralWidget"));
         MainWindowClass->setCentralWidget(centralWidget);
@@ -136,9 +160,13 @@ public:
         menuBar->addAction(menuTool->menuAction());
         menuFile->addAction(actionOpenCGA);
         menuFile->addAction(actionSaveGeometry);
+        menuFile->addAction(actionExportGeometryWhileDeriving);
         menuFile->addSeparator();
         menuFile->addAction(actionExit);
         menuView->addAction(actionViewShadow);
+        menuView->addAction(actionViewCullHiddenFaces);
+        menuView->addAction(actionViewCacheGeometry);
+        menuView->addAction(actionViewCacheAssets);
         menuView->addSeparator();
         menuView->addAction(actionViewBasicRendering);
         menuView->addAction(actionViewSSAO);
@@ -151,6 +179,10 @@ public:
         menuView->addAction(actionRotationStart);
         menuView->addAction(actionRotationEnd);
         menuTool->addAction(actionGenerateBuildingImages);
+        menuTool->addAction(actionGenerateSketchImages);
+        menuTool->addAction(actionGenerateBuildingImagesInWorkers);
+        menuTool->addSeparator();
+        menuTool->addAction(actionCheckSoftwareRenderer);
 
         retranslateUi(MainWindowClass);
 
@@ -185,6 +217,13 @@ public:
         actionRotationEnd->setText(QApplication::translate("MainWindowClass", "Rotation End", 0));
         actionSaveGeometry->setText(QApplication::translate("MainWindowClass", "Save Geometry", 0));
         actionSaveGeometry->setShortcut(QApplication::translate("MainWindowClass", "Ctrl+S", 0));
+        actionViewCullHiddenFaces->setText(QApplication::translate("MainWindowClass", "Cull Hidden Faces", 0));
+        actionViewCacheGeometry->setText(QApplication::translate("MainWindowClass", "Cache Geometry", 0));
+        actionViewCacheAssets->setText(QApplication::translate("MainWindowClass", "Cache Assets", 0));
+        actionExportGeometryWhileDeriving->setText(QApplication::translate("MainWindowClass", "Export Geometry While Deriving", 0));
+        actionGenerateSketchImages->setText(QApplication::translate("MainWindowClass", "Generate Sketch Images", 0));
+        actionGenerateBuildingImagesInWorkers->setText(QApplication::translate("MainWindowClass", "Generate Building Images in Worker Processes", 0));
+        actionCheckSoftwareRenderer->setText(QApplication::translate("MainWindowClass", "Check Software Renderer", 0));
         menuFile->setTitle(QApplication::translate("MainWindowClass", "File", 0));
         menuView->setTitle(QApplication::translate("MainWindowClass", "View", 0));
         menuTool->setTitle(QApplication::translate("MainWindowClass", "Tool", 0));
@@ -0,0 +1,147 @@
+#include "GeometryBuffer.h"
+#include <cstddef>
+#include <cstring>
+
+GeometryBuffer::GeometryBuffer() : vao(0), vbo(0), mapped(NULL), regionSize(0), region(0), used(0), generation(0) {
+}
+
+/**
+ * Create the buffer of numRegions regions, each of which holds regionSize vertices.
+ * Three regions let the GPU draw two scenes while the next one is written.
+ */
+void GeometryBuffer::init(int regionSize, int numRegions) {
+	release();
+
+	this->regionSize = regionSize;
+	fences.resize(numRegions, (GLsync)0);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	GLsizeiptr size = sizeof(Vertex) * (GLsizeiptr)regionSize * numRegions;
+	if (GLEW_ARB_buffer_storage) {
+		// the coherent mapping makes the written vertices visible to the draw calls issued afterwards
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags | GL_DYNAMIC_STORAGE_BIT);
+		mapped = (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	}
+
+	setVertexAttributes();
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Delete the buffer and the fences. The draw calls that are already issued keep using the buffer until they finish.
+ */
+void GeometryBuffer::release() {
+	for (int i = 0; i < fences.size(); ++i) {
+		if (fences[i] != (GLsync)0) glDeleteSync(fences[i]);
+	}
+	if (vbo != 0) glDeleteBuffers(1, &vbo);
+	if (vao != 0) glDeleteVertexArrays(1, &vao);
+
+	vao = 0;
+	vbo = 0;
+	mapped = NULL;
+	fences.clear();
+	region = 0;
+	used = 0;
+}
+
+/**
+ * Copy the vertices to the current region, and return the index of the first one for glDrawArrays().
+ * The buffer grows if the region is full, which increments the generation.
+ */
+int GeometryBuffer::upload(const Vertex* vertices, int numVertices) {
+	int first = allocate(numVertices);
+	write(first, vertices, numVertices);
+	return first;
+}
+
+/**
+ * Reserve the range of numVertices vertices in the current region, and return the index of the first one.
+ * The range is filled by write() piece by piece. The buffer grows if the region is full, which increments the generation.
+ */
+int GeometryBuffer::allocate(int numVertices) {
+	if (vbo == 0) init();
+	if (used + numVertices > regionSize) grow(used + numVertices);
+
+	int first = region * regionSize + used;
+	used += numVertices;
+	return first;
+}
+
+/**
+ * Copy the vertices to the buffer from the index first, which has been allocated in the current region.
+ */
+void GeometryBuffer::write(int first, const Vertex* vertices, int numVertices) {
+	if (numVertices == 0) return;
+
+	if (mapped != NULL) {
+		memcpy(mapped + first, vertices, sizeof(Vertex) * numVertices);
+	}
+	else {
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * (GLintptr)first, sizeof(Vertex) * numVertices, vertices);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+/**
+ * Finish the current scene. Its region is fenced after the draw calls issued so far,
+ * and the next region is reused after the GPU finishes drawing the scene that was written to it.
+ */
+void GeometryBuffer::reset() {
+	if (vbo == 0) return;
+
+	// glBufferSubData() is synchronized by the driver
+	if (mapped != NULL && used > 0) {
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	region = (region + 1) % fences.size();
+	used = 0;
+	waitFence(region);
+}
+
+/**
+ * Configure the attributes of Vertex at the locations 0 to 4 for the bound vertex array and buffer.
+ */
+void GeometryBuffer::setVertexAttributes() {
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, drawEdge));
+}
+
+/**
+ * Recreate the buffer with the regions that hold at least numVertices vertices.
+ */
+void GeometryBuffer::grow(int numVertices) {
+	int newRegionSize = regionSize * 2;
+	while (newRegionSize < numVertices) newRegionSize *= 2;
+
+	init(newRegionSize, fences.size());
+	generation++;
+}
+
+void GeometryBuffer::waitFence(int index) {
+	if (fences[index] == (GLsync)0) return;
+
+	while (glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+	glDeleteSync(fences[index]);
+	fences[index] = (GLsync)0;
+}
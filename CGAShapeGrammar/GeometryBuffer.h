@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glew.h>
+#include <vector>
+#include "Vertex.h"
+
+/**
+ * Vertex buffer and vertex array that are created once and shared by all the objects of RenderManager.
+ * The buffer is divided into the regions, and the objects of a scene are suballocated one after another from a region.
+ * reset() fences the region and moves to the next one, so that the next scene is written while the GPU still draws
+ * the previous ones. If ARB_buffer_storage is supported, the buffer is persistently mapped and the vertices are
+ * copied into it directly, and otherwise they are uploaded by glBufferSubData().
+ * When a scene does not fit in a region, the buffer grows and the generation is incremented, so that the objects
+ * uploaded before know that they have to be uploaded again.
+ * All the functions must be called while the GL context is current.
+ */
+class GeometryBuffer {
+private:
+	GLuint vao;
+	GLuint vbo;
+	Vertex* mapped;			// NULL if the buffer is not persistently mapped
+	int regionSize;			// the number of the vertices in a region
+	std::vector<GLsync> fences;
+	int region;				// the current region
+	int used;				// the number of the vertices allocated in the current region
+	int generation;
+
+public:
+	GeometryBuffer();
+
+	void init(int regionSize = 262144, int numRegions = 3);
+	void release();
+	GLuint getVAO() const { return vao; }
+	int getGeneration() const { return generation; }
+	int upload(const Vertex* vertices, int numVertices);
+	int allocate(int numVertices);
+	void write(int first, const Vertex* vertices, int numVertices);
+	void reset();
+	static void setVertexAttributes();
+
+private:
+	void grow(int numVertices);
+	void waitFence(int index);
+};
@@ -0,0 +1,320 @@
+#include "GeometryCache.h"
+#include "AssetCache.h"
+#include <cstring>
+#include <map>
+#include <set>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace cga {
+
+namespace {
+
+const char MAGIC[4] = { 'C', 'G', 'A', 'G' };
+const unsigned int VERSION = 1;
+
+/**
+ * Header of a cache file, which is followed by dataSize bytes of
+ *   numMeshes meshes: numVertices, Vertex[numVertices]
+ *   numFaces faces: name, grammar_type, texture, mesh index (-1 if the face owns its vertices), and
+ *                   modelMat, color, uvTransform, uvFromPosition for an instance, or numVertices, Vertex[numVertices] otherwise
+ * where a string is stored as its length followed by its characters.
+ */
+struct Header {
+	char magic[4];
+	unsigned int version;
+	unsigned long long key;
+	unsigned int numMeshes;
+	unsigned int numFaces;
+	unsigned long long dataSize;
+};
+
+/**
+ * Serializer to a byte string.
+ */
+class Writer {
+public:
+	std::string data;
+
+public:
+	template<class T>
+	void put(const T& value) { data.append((const char*)&value, sizeof(T)); }
+	void putString(const std::string& str) {
+		put((unsigned int)str.size());
+		data.append(str);
+	}
+	void putVertices(const std::vector<Vertex>& vertices) {
+		put((unsigned int)vertices.size());
+		if (!vertices.empty()) data.append((const char*)&vertices[0], sizeof(Vertex) * vertices.size());
+	}
+};
+
+/**
+ * Deserializer from a memory block, which fails instead of reading beyond the end.
+ */
+class Reader {
+public:
+	const char* p;
+	const char* end;
+
+public:
+	Reader(const char* data, unsigned long long size) : p(data), end(data + size) {}
+
+	template<class T>
+	bool get(T& value) {
+		if (end - p < sizeof(T)) return false;
+		memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+	bool getString(std::string& str) {
+		unsigned int size;
+		if (!get(size) || end - p < size) return false;
+		str.assign(p, size);
+		p += size;
+		return true;
+	}
+	bool getVertices(std::vector<Vertex>& vertices) {
+		unsigned int size;
+		if (!get(size) || (end - p) / sizeof(Vertex) < size) return false;
+		vertices.resize(size);
+		if (size > 0) memcpy(&vertices[0], p, sizeof(Vertex) * size);
+		p += sizeof(Vertex) * size;
+		return true;
+	}
+};
+
+/**
+ * Add the footprint of the axiom shape to the key.
+ * Only the positions and normals of its own geometry are used, because the other attributes of the vertices may be left uninitialized.
+ */
+void putShape(const Shape& shape, Writer& writer) {
+	writer.putString(shape._name);
+	writer.putString(shape._grammar_type);
+	writer.put(shape._pivot);
+	writer.put(shape._modelMat);
+	writer.put(shape._scope);
+	writer.put(shape._color);
+	writer.put(shape._textureEnabled);
+	writer.putString(shape._texture);
+	writer.put((unsigned int)shape._texCoords.size());
+	for (int i = 0; i < shape._texCoords.size(); ++i) {
+		writer.put(shape._texCoords[i]);
+	}
+
+	std::vector<boost::shared_ptr<glutils::Face> > faces;
+	shape.generateGeometry(faces, 1.0f);
+	for (int i = 0; i < faces.size(); ++i) {
+		std::vector<Vertex> vertices;
+		faces[i]->instantiate(vertices);
+		writer.put((unsigned int)vertices.size());
+		for (int k = 0; k < vertices.size(); ++k) {
+			writer.put(vertices[k].position);
+			writer.put(vertices[k].normal);
+		}
+	}
+}
+
+}
+
+bool GeometryCache::enabled = false;
+std::string GeometryCache::directory;
+long long GeometryCache::maxSize = 1LL << 30;
+
+/**
+ * Compute the key of the derivation of the grammar from the axioms.
+ * Return false if the cache is disabled or the grammar is not parsed from a file, since it cannot be identified then.
+ */
+bool GeometryCache::key(const Grammar& grammar, const std::list<boost::shared_ptr<Shape> >& axioms, const LODPolicy& lodPolicy, const FaceCulling& faceCulling, unsigned long long& result) {
+	if (!enabled || grammar.sourceHash == 0) return false;
+
+	Writer writer;
+	writer.put(VERSION);
+	writer.put(grammar.sourceHash);
+	writer.putString(grammar.type);
+	for (auto it = grammar.attrs.begin(); it != grammar.attrs.end(); ++it) {
+		writer.putString(it->first);
+		writer.putString(it->second.value);
+	}
+
+	// the inserted assets are identified by their sizes and modification times
+	std::set<std::string> geometryPaths;
+	std::set<std::string> texturePaths;
+	grammar.getResources(geometryPaths, texturePaths);
+	for (auto it = geometryPaths.begin(); it != geometryPaths.end(); ++it) {
+		QFileInfo info(it->c_str());
+		writer.putString(*it);
+		writer.put((long long)info.size());
+		writer.put((long long)info.lastModified().toMSecsSinceEpoch());
+	}
+
+	writer.put((unsigned int)axioms.size());
+	for (auto it = axioms.begin(); it != axioms.end(); ++it) {
+		putShape(**it, writer);
+	}
+
+	writer.put(lodPolicy.enabled);
+	if (lodPolicy.enabled) {
+		writer.put(lodPolicy.mvpMatrix);
+		writer.put(lodPolicy.viewportWidth);
+		writer.put(lodPolicy.viewportHeight);
+		writer.put(lodPolicy.minPixelSize);
+		writer.put(lodPolicy.fullDetailPixelSize);
+	}
+	writer.put(faceCulling.enabled);
+	if (faceCulling.enabled) {
+		writer.put(faceCulling.cullGround);
+		writer.put(faceCulling.groundHeight);
+		writer.put(faceCulling.tolerance);
+	}
+
+	result = AssetCache::hash(writer.data.data(), writer.data.size());
+	return true;
+}
+
+/**
+ * Append the faces stored for the key.
+ * Return false if the cache is disabled, or the entry does not exist or is broken, in which case the faces are not changed.
+ */
+bool GeometryCache::load(unsigned long long key, std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+	if (!enabled) return false;
+
+	QFile file(cachePath(key).c_str());
+	if (!file.open(QIODevice::ReadOnly) || file.size() < sizeof(Header)) return false;
+
+	const uchar* data = file.map(0, file.size());
+	if (data == NULL) return false;
+
+	const Header& header = *(const Header*)data;
+	if (memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION || header.key != key || sizeof(Header) + header.dataSize != file.size()) return false;
+
+	Reader reader((const char*)data + sizeof(Header), header.dataSize);
+
+	std::vector<boost::shared_ptr<const glutils::Mesh> > meshes(header.numMeshes);
+	for (int i = 0; i < header.numMeshes; ++i) {
+		std::vector<Vertex> vertices;
+		if (!reader.getVertices(vertices)) return false;
+		meshes[i] = boost::shared_ptr<const glutils::Mesh>(new glutils::Mesh(vertices));
+	}
+
+	std::vector<boost::shared_ptr<glutils::Face> > loadedFaces;
+	loadedFaces.reserve(header.numFaces);
+	for (int i = 0; i < header.numFaces; ++i) {
+		std::string name;
+		std::string grammar_type;
+		std::string texture;
+		int meshIndex;
+		if (!reader.getString(name) || !reader.getString(grammar_type) || !reader.getString(texture) || !reader.get(meshIndex)) return false;
+
+		if (meshIndex >= 0) {
+			glm::mat4 modelMat;
+			glm::vec4 color;
+			glm::vec4 uvTransform;
+			unsigned char uvFromPosition;
+			if (meshIndex >= meshes.size() || !reader.get(modelMat) || !reader.get(color) || !reader.get(uvTransform) || !reader.get(uvFromPosition)) return false;
+
+			boost::shared_ptr<glutils::Face> face(new glutils::Face(name, grammar_type, meshes[meshIndex], modelMat, color, texture));
+			face->uvTransform = uvTransform;
+			face->uvFromPosition = uvFromPosition != 0;
+			loadedFaces.push_back(face);
+		}
+		else {
+			std::vector<Vertex> vertices;
+			if (!reader.getVertices(vertices)) return false;
+			loadedFaces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(name, grammar_type, vertices, texture)));
+		}
+	}
+
+	faces.insert(faces.end(), loadedFaces.begin(), loadedFaces.end());
+	return true;
+}
+
+/**
+ * Store the faces from the first-th one for the key, and evict the old entries if the cache is full.
+ * The meshes shared by the instances are stored once.
+ */
+bool GeometryCache::save(unsigned long long key, const std::vector<boost::shared_ptr<glutils::Face> >& faces, int first) {
+	if (!enabled) return false;
+
+	std::map<const glutils::Mesh*, int> meshIndices;
+	Writer meshData;
+	Writer faceData;
+	for (int i = first; i < faces.size(); ++i) {
+		const glutils::Face& face = *faces[i];
+		faceData.putString(face.name);
+		faceData.putString(face.grammar_type);
+		faceData.putString(face.texture);
+
+		if (face.isInstance()) {
+			std::map<const glutils::Mesh*, int>::iterator it = meshIndices.find(face.mesh.get());
+			if (it == meshIndices.end()) {
+				it = meshIndices.insert(std::make_pair(face.mesh.get(), (int)meshIndices.size())).first;
+				meshData.putVertices(face.mesh->vertices);
+			}
+			faceData.put(it->second);
+			faceData.put(face.modelMat);
+			faceData.put(face.color);
+			faceData.put(face.uvTransform);
+			faceData.put((unsigned char)(face.uvFromPosition ? 1 : 0));
+		}
+		else {
+			faceData.put(-1);
+			faceData.putVertices(face.vertices);
+		}
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, 4);
+	header.version = VERSION;
+	header.key = key;
+	header.numMeshes = meshIndices.size();
+	header.numFaces = faces.size() - first;
+	header.dataSize = meshData.data.size() + faceData.data.size();
+
+	QDir().mkpath(cacheDirectory().c_str());
+	QSaveFile file(cachePath(key).c_str());
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	file.write((const char*)&header, sizeof(Header));
+	file.write(meshData.data.data(), meshData.data.size());
+	file.write(faceData.data.data(), faceData.data.size());
+	if (!file.commit()) return false;
+
+	evict();
+	return true;
+}
+
+/**
+ * Remove the least recently written entries until the total size is within maxSize.
+ * An entry that is being read by another process may fail to be removed, and it is left for the next time.
+ */
+void GeometryCache::evict() {
+	QFileInfoList entries = QDir(cacheDirectory().c_str()).entryInfoList(QStringList("*.geometry"), QDir::Files, QDir::Time);
+
+	long long totalSize = 0;
+	for (int i = 0; i < entries.size(); ++i) {
+		totalSize += entries[i].size();
+		if (totalSize > maxSize) {
+			QFile::remove(entries[i].filePath());
+		}
+	}
+}
+
+/**
+ * Return the directory of the entries with the trailing separator.
+ */
+std::string GeometryCache::cacheDirectory() {
+	if (!directory.empty()) return directory;
+
+	return (QCoreApplication::applicationDirPath() + "/cache/").toStdString();
+}
+
+std::string GeometryCache::cachePath(unsigned long long key) {
+	return cacheDirectory() + QString("%1").arg(key, 16, 16, QChar('0')).toStdString() + ".geometry";
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "GLUtils.h"
+#include "Grammar.h"
+#include "Shape.h"
+#include "LODPolicy.h"
+#include "FaceCulling.h"
+
+namespace cga {
+
+/**
+ * On-disk cache of the generated geometry.
+ * An entry is addressed by the hash of everything the geometry depends on, i.e., the source of the grammar,
+ * the values of its attributes, the assets it inserts, the axiom shapes, and the settings of the LOD policy
+ * and the face culling. The faces are stored in a flat binary file, which is memory-mapped when it is loaded.
+ * The entries are written to temporary files and renamed, so that multiple processes can share the cache,
+ * and the oldest entries are removed when the total size exceeds maxSize.
+ * The cache is disabled by default. If the directory is empty, the entries are stored in the "cache" directory
+ * next to the executable, so that they do not depend on the working directory.
+ */
+class GeometryCache {
+protected:
+	GeometryCache() {}
+
+public:
+	static bool enabled;
+	static std::string directory;
+	static long long maxSize;
+
+public:
+	static bool key(const Grammar& grammar, const std::list<boost::shared_ptr<Shape> >& axioms, const LODPolicy& lodPolicy, const FaceCulling& faceCulling, unsigned long long& result);
+	static bool load(unsigned long long key, std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	static bool save(unsigned long long key, const std::vector<boost::shared_ptr<glutils::Face> >& faces, int first = 0);
+	static void evict();
+	static std::string cacheDirectory();
+	static std::string cachePath(unsigned long long key);
+};
+
+}
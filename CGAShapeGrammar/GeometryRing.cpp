@@ -0,0 +1,263 @@
+#include "GeometryRing.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace {
+
+/** state of the initialized ring, i.e., "CGAR" */
+const unsigned int READY = 0x52414743;
+const unsigned int VERSION = 2;
+const int CACHE_LINE = 64;
+
+/** the producer gives up if the consumer does not take any building for this time */
+const int PUSH_TIMEOUT = 60000;
+
+/**
+ * Header of the shared memory, which is followed by the slots.
+ * state is set to READY after the other members and the slots are initialized, and the producers attach
+ * only after they see it. head and tail count the claimed slots of the producers and the consumers, and
+ * they are on different cache lines so that the producers and the consumers do not contend.
+ * The atomics are lock-free for 32-bit integers, so that they work across the processes.
+ */
+struct RingHeader {
+	std::atomic<unsigned int> state;
+	unsigned int version;
+	unsigned int numSlots;
+	unsigned int slotStride;
+	std::atomic<unsigned int> head;
+	char padding[CACHE_LINE];
+	std::atomic<unsigned int> tail;
+};
+
+/**
+ * Header of a slot, which is followed by Range[numRanges], float[numParams], and Vertex[numVertices].
+ * The slot at position p is free for the producer when sequence is p, and it holds a building
+ * for the consumer when sequence is p + 1.
+ */
+struct SlotHeader {
+	std::atomic<unsigned int> sequence;
+	unsigned int id;
+	unsigned int numRanges;
+	unsigned int numParams;
+	unsigned int numVertices;
+};
+
+int roundUp(int size, int alignment) {
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+const int HEADER_SIZE = roundUp(sizeof(RingHeader), CACHE_LINE);
+
+}
+
+GeometryRing::GeometryRing(const QString& key) : memory(key), data(NULL), numSlots(0), slotStride(0) {
+}
+
+GeometryRing::~GeometryRing() {
+	detach();
+}
+
+/**
+ * Create the shared memory of numSlots slots, each of which holds up to slotSize bytes of the ranges, the parameter values, and the vertices.
+ * numSlots is rounded up to a power of two, so that the slot of a position does not change when the position wraps around.
+ * Return false if it cannot be created, e.g., the ring of the same key exists already.
+ */
+bool GeometryRing::create(int numSlots, int slotSize) {
+	detach();
+	if (numSlots <= 0) return false;
+
+	int n = 1;
+	while (n < numSlots) n *= 2;
+	numSlots = n;
+
+	int stride = roundUp(sizeof(SlotHeader) + slotSize, CACHE_LINE);
+	if (!memory.create(HEADER_SIZE + numSlots * stride)) return false;
+
+	data = (char*)memory.data();
+	memset(data, 0, HEADER_SIZE + numSlots * stride);
+
+	RingHeader* header = new (data) RingHeader();
+	header->version = VERSION;
+	header->numSlots = numSlots;
+	header->slotStride = stride;
+	header->head.store(0);
+	header->tail.store(0);
+
+	this->numSlots = numSlots;
+	this->slotStride = stride;
+	for (int i = 0; i < numSlots; ++i) {
+		SlotHeader* slot = new (slotAt(i)) SlotHeader();
+		slot->sequence.store(i);
+	}
+
+	// publish the initialized ring to the producers
+	header->state.store(READY, std::memory_order_release);
+
+	return true;
+}
+
+/**
+ * Attach to the ring created by another process.
+ * Return false if it does not exist or is not initialized yet.
+ */
+bool GeometryRing::attach() {
+	detach();
+	if (!memory.attach()) return false;
+
+	data = (char*)memory.data();
+	RingHeader* header = (RingHeader*)data;
+	if (header->state.load(std::memory_order_acquire) != READY || header->version != VERSION) {
+		detach();
+		return false;
+	}
+
+	numSlots = header->numSlots;
+	slotStride = header->slotStride;
+	return true;
+}
+
+void GeometryRing::detach() {
+	if (memory.isAttached()) {
+		memory.detach();
+	}
+	data = NULL;
+	numSlots = 0;
+	slotStride = 0;
+}
+
+/**
+ * Write the parameter values and the objects of a building to the next free slot.
+ * Return false without waiting if the ring is full. Throw an exception if the building does not fit
+ * in a slot or has a name or a texture path that is too long, since it never fits.
+ */
+bool GeometryRing::push(unsigned int id, const std::vector<float>& paramValues, const Objects& objects) {
+	if (data == NULL) throw std::string("The geometry ring is not attached.");
+
+	unsigned int numVertices = 0;
+	for (Objects::const_iterator it = objects.begin(); it != objects.end(); ++it) {
+		if (it->first.first.size() >= MAX_NAME_LENGTH || it->first.second.size() >= MAX_TEXTURE_LENGTH) {
+			throw std::string("The name or the texture is too long for the geometry ring: ") + it->first.first + " " + it->first.second;
+		}
+		numVertices += it->second.size();
+	}
+	if (sizeof(SlotHeader) + sizeof(Range) * objects.size() + sizeof(float) * paramValues.size() + sizeof(Vertex) * numVertices > slotStride) {
+		throw std::string("The building does not fit in a slot of the geometry ring.");
+	}
+
+	// claim the slot
+	RingHeader* header = (RingHeader*)data;
+	unsigned int position = header->head.load(std::memory_order_relaxed);
+	SlotHeader* slot;
+	while (true) {
+		slot = (SlotHeader*)slotAt(position);
+		int diff = (int)(slot->sequence.load(std::memory_order_acquire) - position);
+		if (diff == 0) {
+			if (header->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+		}
+		else if (diff < 0) {
+			return false;
+		}
+		else {
+			position = header->head.load(std::memory_order_relaxed);
+		}
+	}
+
+	// write the building
+	Range* ranges = (Range*)(slot + 1);
+	float* params = (float*)(ranges + objects.size());
+	Vertex* vertices = (Vertex*)(params + paramValues.size());
+	unsigned int firstVertex = 0;
+	for (Objects::const_iterator it = objects.begin(); it != objects.end(); ++it, ++ranges) {
+		memset(ranges, 0, sizeof(Range));
+		strcpy(ranges->name, it->first.first.c_str());
+		strcpy(ranges->texture, it->first.second.c_str());
+		ranges->firstVertex = firstVertex;
+		ranges->numVertices = it->second.size();
+		if (!it->second.empty()) memcpy(vertices + firstVertex, &it->second[0], sizeof(Vertex) * it->second.size());
+		firstVertex += it->second.size();
+	}
+	if (!paramValues.empty()) memcpy(params, &paramValues[0], sizeof(float) * paramValues.size());
+
+	slot->id = id;
+	slot->numRanges = objects.size();
+	slot->numParams = paramValues.size();
+	slot->numVertices = numVertices;
+
+	// publish the slot to the consumers
+	slot->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+/**
+ * Take the oldest building without copying it.
+ * Return false without waiting if the ring is empty. The slot must be released after it is used.
+ */
+bool GeometryRing::acquire(Slot& slot) {
+	if (data == NULL) return false;
+
+	RingHeader* header = (RingHeader*)data;
+	unsigned int position = header->tail.load(std::memory_order_relaxed);
+	SlotHeader* slotHeader;
+	while (true) {
+		slotHeader = (SlotHeader*)slotAt(position);
+		int diff = (int)(slotHeader->sequence.load(std::memory_order_acquire) - (position + 1));
+		if (diff == 0) {
+			if (header->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+		}
+		else if (diff < 0) {
+			return false;
+		}
+		else {
+			position = header->tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot.id = slotHeader->id;
+	slot.ranges = (const Range*)(slotHeader + 1);
+	slot.numRanges = slotHeader->numRanges;
+	slot.paramValues = (const float*)(slot.ranges + slot.numRanges);
+	slot.numParams = slotHeader->numParams;
+	slot.vertices = (const Vertex*)(slot.paramValues + slot.numParams);
+	slot.numVertices = slotHeader->numVertices;
+	slot.position = position;
+	return true;
+}
+
+/**
+ * Return the slot to the producers. The memory of the slot must not be used afterwards.
+ */
+void GeometryRing::release(const Slot& slot) {
+	if (data == NULL) return;
+
+	SlotHeader* slotHeader = (SlotHeader*)slotAt(slot.position);
+	slotHeader->sequence.store(slot.position + numSlots, std::memory_order_release);
+}
+
+char* GeometryRing::slotAt(unsigned int position) {
+	return data + HEADER_SIZE + (position % numSlots) * slotStride;
+}
+
+GeometryRingSink::GeometryRingSink(GeometryRing& ring, unsigned int id, const std::vector<float>& paramValues) : ring(ring), id(id), paramValues(paramValues) {
+}
+
+void GeometryRingSink::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+	for (int i = 0; i < faces.size(); ++i) {
+		faces[i]->instantiate(objects[std::make_pair(faces[i]->name, faces[i]->texture)]);
+	}
+}
+
+/**
+ * Push the building to the ring, and wait while the ring is full.
+ * Throw an exception if the consumer does not take any building for a while, e.g., it has exited.
+ */
+void GeometryRingSink::close() {
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(PUSH_TIMEOUT);
+	while (!ring.push(id, paramValues, objects)) {
+		if (std::chrono::steady_clock::now() > deadline) throw std::string("The geometry ring stays full.");
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	objects.clear();
+}
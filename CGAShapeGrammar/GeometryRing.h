@@ -0,0 +1,104 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <QSharedMemory>
+#include <QString>
+#include <boost/shared_ptr.hpp>
+#include "GLUtils.h"
+#include "GeometrySink.h"
+#include "Vertex.h"
+
+/**
+ * Ring of fixed-size slots in shared memory, which hands the geometry of derived buildings over from
+ * the derivation processes to a rendering process without files. Each slot holds the parameter values and
+ * the vertices of one building as a contiguous array in the layout of Vertex, grouped by object name and
+ * texture, so that the consumer can upload each range from the slot as it is. The slots are claimed and
+ * published by lock-free sequence numbers, so that any number of producers and consumers may share the ring.
+ *
+ * Usage:
+ *   consumer: ring.create(numSlots, slotSize);
+ *             if (ring.acquire(slot)) {
+ *                 for each range: renderManager.addObject(range.name, range.texture, slot.vertices + range.firstVertex, range.numVertices, true);
+ *                 render, and then ring.release(slot);
+ *             }
+ *   producer: ring.attach();
+ *             GeometryRingSink sink(ring, id, paramValues);
+ *             system.derive(grammar, sink);
+ *             sink.close();
+ */
+class GeometryRing {
+public:
+	static const int MAX_NAME_LENGTH = 64;
+	static const int MAX_TEXTURE_LENGTH = 260;
+
+	/** vertices of a building for each pair of object name and texture */
+	typedef std::map<std::pair<std::string, std::string>, std::vector<Vertex> > Objects;
+
+	/**
+	 * Vertices of a building that have the same object name and texture.
+	 */
+	struct Range {
+		char name[MAX_NAME_LENGTH];
+		char texture[MAX_TEXTURE_LENGTH];
+		unsigned int firstVertex;
+		unsigned int numVertices;
+	};
+
+	/**
+	 * A building acquired by the consumer, which points into the shared memory until it is released.
+	 */
+	class Slot {
+	public:
+		unsigned int id;
+		const Range* ranges;
+		int numRanges;
+		const float* paramValues;
+		int numParams;
+		const Vertex* vertices;
+		int numVertices;
+		unsigned int position;
+
+	public:
+		Slot() : id(0), ranges(NULL), numRanges(0), paramValues(NULL), numParams(0), vertices(NULL), numVertices(0), position(0) {}
+	};
+
+private:
+	QSharedMemory memory;
+	char* data;
+	int numSlots;
+	int slotStride;
+
+public:
+	GeometryRing(const QString& key);
+	~GeometryRing();
+
+	bool create(int numSlots, int slotSize);
+	bool attach();
+	void detach();
+	bool push(unsigned int id, const std::vector<float>& paramValues, const Objects& objects);
+	bool acquire(Slot& slot);
+	void release(const Slot& slot);
+
+private:
+	char* slotAt(unsigned int position);
+};
+
+/**
+ * Sink that collects the faces of a building during the derivation, where the instances are expanded,
+ * and pushes them to the ring as one slot by close(). close() waits while the ring is full.
+ */
+class GeometryRingSink : public GeometrySink {
+private:
+	GeometryRing& ring;
+	unsigned int id;
+	std::vector<float> paramValues;
+	GeometryRing::Objects objects;
+
+public:
+	GeometryRingSink(GeometryRing& ring, unsigned int id, const std::vector<float>& paramValues);
+
+	void write(const std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	void close();
+};
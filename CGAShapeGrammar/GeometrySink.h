@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include "GLUtils.h"
+#include <boost/shared_ptr.hpp>
+
+/**
+ * Destination of the faces that are generated during the derivation.
+ * The faces are passed in batches and may be released after write() returns, so that an implementation
+ * must not keep them. close() finishes the output after the last batch.
+ */
+class GeometrySink {
+public:
+	virtual ~GeometrySink() {}
+
+	virtual void write(const std::vector<boost::shared_ptr<glutils::Face> >& faces) = 0;
+	virtual void close() {}
+};
@@ -252,4 +252,15 @@ std::string Grammar::evalString(const std::string& attr_name, const boost::share
 	}
 }
 
+/**
+ * Collect the geometry and texture files that are used by the rules of this grammar.
+ */
+void Grammar::getResources(std::set<std::string>& geometryPaths, std::set<std::string>& texturePaths) const {
+	for (auto it = rules.begin(); it != rules.end(); ++it) {
+		for (int i = 0; i < it->second.operators.size(); ++i) {
+			it->second.operators[i]->getResources(*this, geometryPaths, texturePaths);
+		}
+	}
+}
+
 }
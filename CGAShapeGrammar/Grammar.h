@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <list>
+#include <set>
 #include <boost/shared_ptr.hpp>
 #include "Shape.h"
 
@@ -49,6 +50,8 @@ public:
 	Operator() {}
 
 	virtual boost::shared_ptr<Shape> apply(boost::shared_ptr<Shape>& shape, const Grammar& grammar, std::list<boost::shared_ptr<Shape> >& stack) = 0;
+	/** add the files that this operator reads during the derivation */
+	virtual void getResources(const Grammar& grammar, std::set<std::string>& geometryPaths, std::set<std::string>& texturePaths) const {}
 };
 
 class Rule {
@@ -67,9 +70,10 @@ public:
 	std::string type;
 	std::map<std::string, Attribute> attrs;
 	std::map<std::string, cga::Rule> rules;
+	unsigned long long sourceHash;	// hash of the source file, or 0 if the grammar is not parsed from a file
 
 public:
-	Grammar() {}
+	Grammar() : sourceHash(0) {}
 
 	bool contain(const std::string& name) const;
 	Rule getRule(const std::string& name) const { return rules.at(name); }
@@ -79,6 +83,7 @@ public:
 	void addOperator(const std::string& name, const boost::shared_ptr<Operator>& op);
 	float evalFloat(const std::string& attr_name, const boost::shared_ptr<Shape>& shape) const;
 	std::string evalString(const std::string& attr_name, const boost::shared_ptr<Shape>& shape) const;
+	void getResources(std::set<std::string>& geometryPaths, std::set<std::string>& texturePaths) const;
 };
 
 }
@@ -23,6 +23,7 @@
 #include "TextureOperator.h"
 #include "TranslateOperator.h"
 #include "CGA.h"
+#include "AssetCache.h"
 #include <iostream>
 #include "Grammar.h"
 
@@ -30,9 +31,14 @@ namespace cga {
 
 void parseGrammar(const char* filename, Grammar& grammar) {
 	QFile file(filename);
+	QByteArray contents;
+	if (file.open(QIODevice::ReadOnly)) {
+		contents = file.readAll();
+	}
+	grammar.sourceHash = AssetCache::hash(contents.constData(), contents.size());
 
 	QDomDocument doc;
-	doc.setContent(&file, true);
+	doc.setContent(contents, true);
 	QDomElement root = doc.documentElement();
 
 	if (root.toElement().hasAttribute("type")) {
@@ -4,6 +4,8 @@
 #include "Rectangle.h"
 #include "Polygon.h"
 #include "GLUtils.h"
+#include "LODPolicy.h"
+#include "UnitMeshCache.h"
 
 namespace cga {
 
@@ -92,65 +94,20 @@ void Hemisphere::setupProjection(int axesSelector, float texWidth, float texHeig
 void Hemisphere::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
-	int slices = 20;
-	int stacks = 7;
-
+	int slices = LODPolicy::slices(20, _lod, 6);
+	int stacks = LODPolicy::slices(7, _lod, 2);
 	float radius = _scope.x * 0.5f;
 
-	for (int i = 0; i < stacks; ++i) {
-		float theta1 = (float)i / stacks * M_PI * 0.5f;
-		float theta2 = (float)(i + 1) / stacks * M_PI * 0.5f;
-
-		for (int j = 0; j < slices; ++j) {
-			float phi1 = (float)j / slices * M_PI * 2.0f;
-			float phi2 = (float)(j + 1) / slices * M_PI * 2.0f;
-
-			glm::vec3 p1(radius * cosf(theta1) * cosf(phi1) + radius, radius * cosf(theta1) * sinf(phi1) + radius, radius * sinf(theta1));
-			glm::vec3 p2(radius * cosf(theta1) * cosf(phi2) + radius, radius * cosf(theta1) * sinf(phi2) + radius, radius * sinf(theta1));
-			glm::vec3 p3(radius * cosf(theta2) * cosf(phi2) + radius, radius * cosf(theta2) * sinf(phi2) + radius, radius * sinf(theta2));
-			glm::vec3 p4(radius * cosf(theta2) * cosf(phi1) + radius, radius * cosf(theta2) * sinf(phi1) + radius, radius * sinf(theta2));
-
-			p1 = glm::vec3(_pivot * _modelMat * glm::vec4(p1, 1));
-			p2 = glm::vec3(_pivot * _modelMat * glm::vec4(p2, 1));
-			p3 = glm::vec3(_pivot * _modelMat * glm::vec4(p3, 1));
-			p4 = glm::vec3(_pivot * _modelMat * glm::vec4(p4, 1));
-
-			glm::vec3 n1(cosf(theta1) * cosf(phi1), cosf(theta1) * sinf(phi1), sinf(theta1));
-			glm::vec3 n2(cosf(theta1) * cosf(phi2), cosf(theta1) * sinf(phi2), sinf(theta1));
-			glm::vec3 n3(cosf(theta2) * cosf(phi2), cosf(theta2) * sinf(phi2), sinf(theta1));
-			glm::vec3 n4(cosf(theta2) * cosf(phi1), cosf(theta2) * sinf(phi1), sinf(theta1));
-
-			n1 = glm::vec3(_pivot * _modelMat * glm::vec4(n1, 0));
-			n2 = glm::vec3(_pivot * _modelMat * glm::vec4(n2, 0));
-			n3 = glm::vec3(_pivot * _modelMat * glm::vec4(n3, 0));
-			n4 = glm::vec3(_pivot * _modelMat * glm::vec4(n4, 0));
-
-			if (_textureEnabled) {
-				glm::vec2 t1((float)j / slices * radius * 2.0f * M_PI / _texWidth, (float)i / stacks * radius * 2.0f * M_PI * 0.25f / _texHeight);
-				glm::vec2 t2((float)(j + 1) / slices * radius * 2.0f * M_PI / _texWidth, (float)i / stacks * radius * 2.0f * M_PI * 0.25f / _texHeight);
-				glm::vec2 t3((float)(j + 1) / slices * radius * 2.0f * M_PI / _texWidth, (float)(i + 1) / stacks * radius * 2.0f * M_PI * 0.25f / _texHeight);
-				glm::vec2 t4((float)j / slices * radius * 2.0f * M_PI / _texWidth, (float)(i + 1) / stacks * radius * 2.0f * M_PI * 0.25f / _texHeight);
-
-				std::vector<Vertex> vertices;
-				vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity), t1));
-				vertices.push_back(Vertex(p2, n2, glm::vec4(_color, opacity), t2));
-				vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity), t3));
-				vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity), t1));
-				vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity), t3));
-				vertices.push_back(Vertex(p4, n4, glm::vec4(_color, opacity), t4));
-				faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
-			}
-			else {
-				std::vector<Vertex> vertices;
-				vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity)));
-				vertices.push_back(Vertex(p2, n2, glm::vec4(_color, opacity)));
-				vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity)));
-				vertices.push_back(Vertex(p1, n1, glm::vec4(_color, opacity)));
-				vertices.push_back(Vertex(p3, n3, glm::vec4(_color, opacity)));
-				vertices.push_back(Vertex(p4, n4, glm::vec4(_color, opacity)));
-				faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
-			}
-		}
+	std::vector<Vertex> vertices;
+	boost::shared_ptr<const UnitMesh> mesh = UnitMeshCache::hemisphere(slices, stacks);
+
+	if (_textureEnabled) {
+		mesh->instantiate(_pivot * _modelMat, glm::vec3(radius, radius, radius), glm::vec4(_color, opacity), glm::vec2(radius * 2.0f * M_PI / _texWidth, radius * 2.0f * M_PI * 0.25f / _texHeight), glm::vec2(0, 0), vertices);
+		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
+	}
+	else {
+		mesh->instantiate(_pivot * _modelMat, glm::vec3(radius, radius, radius), glm::vec4(_color, opacity), vertices);
+		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 }
 
@@ -112,6 +112,8 @@ void HipRoof::comp(const std::map<std::string, std::string>& name_map, std::vect
 void HipRoof::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	std::vector<Vertex> vertices;
 
 	Polygon_2 poly;
@@ -149,8 +151,8 @@ void HipRoof::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& f
 				p1 = glm::vec2(head->point().x(), head->point().y());
 				first = false;
 
-				points.push_back(glm::vec3(_pivot * _modelMat * glm::vec4(p0, 0, 1)));
-				points.push_back(glm::vec3(_pivot * _modelMat * glm::vec4(p1, 0, 1)));
+				points.push_back(glm::vec3(shapeMat * glm::vec4(p0, 0, 1)));
+				points.push_back(glm::vec3(shapeMat * glm::vec4(p1, 0, 1)));
 			} else {
 				glm::vec2 p2 = glm::vec2(head->point().x(), head->point().y());
 
@@ -158,7 +160,7 @@ void HipRoof::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& f
 					// p2の高さを計算
 					float z = glutils::distance(p0, p1, p2) * tanf(_angle * M_PI / 180.0f);
 
-					points.push_back(glm::vec3(_pivot * _modelMat * glm::vec4(head->point().x(), head->point().y(), z, 1)));
+					points.push_back(glm::vec3(shapeMat * glm::vec4(head->point().x(), head->point().y(), z, 1)));
 				}
 			}
 		} while ((edge = edge->next()) != edge0);
@@ -0,0 +1,49 @@
+#include "ImageSink.h"
+#include <fstream>
+#include <opencv2/highgui/highgui.hpp>
+#include <QString>
+
+namespace {
+
+const unsigned int VERSION = 1;
+
+std::string imagePath(const std::string& directory, int index, const char* extension) {
+	return directory + "/" + QString("image_%1.").arg(index, 6, 10, QChar('0')).toStdString() + extension;
+}
+
+template<class T>
+void put(std::ofstream& file, const T& value) {
+	file.write((const char*)&value, sizeof(T));
+}
+
+}
+
+PNGImageSink::PNGImageSink(const std::string& directory, int compressionLevel) : directory(directory), compressionLevel(compressionLevel) {
+}
+
+bool PNGImageSink::write(int index, const cv::Mat& image, const std::vector<float>& paramValues) {
+	std::vector<int> params;
+	params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+	params.push_back(compressionLevel);
+	return cv::imwrite(imagePath(directory, index, "png"), image, params);
+}
+
+RawImageSink::RawImageSink(const std::string& directory) : directory(directory) {
+}
+
+bool RawImageSink::write(int index, const cv::Mat& image, const std::vector<float>& paramValues) {
+	std::ofstream file(imagePath(directory, index, "raw").c_str(), std::ios::binary);
+	if (!file) return false;
+
+	file.write("CGAI", 4);
+	put(file, VERSION);
+	put(file, image.cols);
+	put(file, image.rows);
+	put(file, image.type());
+
+	int rowSize = image.cols * image.elemSize();
+	for (int y = 0; y < image.rows; ++y) {
+		file.write((const char*)image.ptr(y), rowSize);
+	}
+	return file.good();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * Destination of the rendered images and their parameter values.
+ * write() is called by multiple encoder threads at the same time and in any order of the indices,
+ * so that an implementation must be thread-safe. close() finishes the output after the last image.
+ * isWritten() tells the samples that a previous run has already written, which are not generated again.
+ */
+class ImageSink {
+public:
+	virtual ~ImageSink() {}
+
+	virtual bool write(int index, const cv::Mat& image, const std::vector<float>& paramValues) = 0;
+	virtual bool isWritten(int index) { return false; }
+	virtual void close() {}
+};
+
+/**
+ * PNG file per image, i.e., image_000000.png, ...
+ * compressionLevel is from 0 (fastest) to 9 (smallest). The parameter values are not stored.
+ */
+class PNGImageSink : public ImageSink {
+private:
+	std::string directory;
+	int compressionLevel;
+
+public:
+	PNGImageSink(const std::string& directory, int compressionLevel = 3);
+
+	bool write(int index, const cv::Mat& image, const std::vector<float>& paramValues);
+};
+
+/**
+ * Uncompressed file per image, i.e., image_000000.raw, which has the header of
+ *   "CGAI", version, width, height, OpenCV type
+ * followed by the rows of the pixels without padding. The parameter values are not stored.
+ */
+class RawImageSink : public ImageSink {
+private:
+	std::string directory;
+
+public:
+	RawImageSink(const std::string& directory);
+
+	bool write(int index, const cv::Mat& image, const std::vector<float>& paramValues);
+};
@@ -0,0 +1,95 @@
+#include "ImageWriter.h"
+#include <iostream>
+#include <QString>
+#include "ThreadPool.h"
+
+/**
+ * Start the encoders. If numThreads is 0, the number of the hardware threads is used.
+ */
+ImageWriter::ImageWriter(const boost::shared_ptr<ImageSink>& sink, const std::string& parameterFilename, int numThreads, int queueSize) : sink(sink), queue(queueSize), nextRow(0) {
+	if (!parameterFilename.empty()) {
+		parameterFile.open(parameterFilename.c_str());
+		if (!parameterFile) {
+			std::cerr << "Cannot open file for writing: " << parameterFilename << std::endl;
+		}
+	}
+
+	if (numThreads <= 0) numThreads = ThreadPool::defaultSize();
+	for (int i = 0; i < numThreads; ++i) {
+		workers.push_back(std::thread(&ImageWriter::run, this));
+	}
+}
+
+ImageWriter::~ImageWriter() {
+	close();
+}
+
+/**
+ * Queue the image and its parameter values to be written.
+ * The image must not be modified afterwards, since it is not copied.
+ */
+void ImageWriter::write(int index, const cv::Mat& image, const std::vector<float>& paramValues) {
+	Record record;
+	record.index = index;
+	record.image = image;
+	record.paramValues = paramValues;
+	queue.push(record);
+}
+
+/**
+ * Write the queued records, stop the encoders, and close the sink and the parameter file.
+ */
+void ImageWriter::close() {
+	queue.close();
+	for (int i = 0; i < workers.size(); ++i) {
+		workers[i].join();
+	}
+	workers.clear();
+
+	if (sink.get() != NULL) {
+		sink->close();
+	}
+	if (parameterFile.is_open()) {
+		parameterFile.close();
+	}
+}
+
+void ImageWriter::run() {
+	Record record;
+	while (queue.pop(record)) {
+		bool written = false;
+		try {
+			written = !record.image.empty() && sink->write(record.index, record.image, record.paramValues);
+			if (!written) {
+				std::cerr << "Cannot write image " << record.index << std::endl;
+			}
+		}
+		catch (const cv::Exception& ex) {
+			std::cerr << "Cannot write image " << record.index << ": " << ex.what() << std::endl;
+		}
+
+		if (parameterFile.is_open()) {
+			writeRow(record.index, written ? record.paramValues : std::vector<float>());
+		}
+	}
+}
+
+/**
+ * Write the row of the parameter values, or keep it until the rows of the smaller indices are written.
+ */
+void ImageWriter::writeRow(int index, const std::vector<float>& paramValues) {
+	std::string row;
+	for (int i = 0; i < paramValues.size(); ++i) {
+		if (i > 0) row += ",";
+		row += QString::number(paramValues[i]).toStdString();
+	}
+
+	std::unique_lock<std::mutex> lock(parameterMutex);
+	pendingRows[index] = row;
+	while (!pendingRows.empty() && pendingRows.begin()->first == nextRow) {
+		parameterFile << pendingRows.begin()->second << "\n";
+		pendingRows.erase(pendingRows.begin());
+		nextRow++;
+	}
+	parameterFile.flush();
+}
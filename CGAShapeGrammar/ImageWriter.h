@@ -0,0 +1,50 @@
+#pragma once
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <opencv2/core/core.hpp>
+#include "BlockingQueue.h"
+#include "ImageSink.h"
+
+/**
+ * Encoder threads that write the rendered images and their parameter values in the background.
+ * The records are handed over through a bounded queue, so that the render loop only waits when the
+ * encoders fall behind by more than queueSize images. The images are passed to the sink in any order.
+ * If parameterFilename is given for a sink that does not store the parameter values, the rows of the file
+ * are written in the order of the indices, each after its image, so that the file always refers to the images
+ * that exist. The row of an image that is empty or cannot be written is left empty, so that the i-th row still
+ * belongs to the i-th image. The indices must be 0, 1, 2, ... then.
+ */
+class ImageWriter {
+private:
+	struct Record {
+		int index;
+		cv::Mat image;
+		std::vector<float> paramValues;
+	};
+
+	boost::shared_ptr<ImageSink> sink;
+	BlockingQueue<Record> queue;
+	std::vector<std::thread> workers;
+
+	std::mutex parameterMutex;
+	std::ofstream parameterFile;
+	std::map<int, std::string> pendingRows;
+	int nextRow;
+
+public:
+	ImageWriter(const boost::shared_ptr<ImageSink>& sink, const std::string& parameterFilename = "", int numThreads = 0, int queueSize = 16);
+	~ImageWriter();
+
+	void write(int index, const cv::Mat& image, const std::vector<float>& paramValues);
+	void close();
+
+private:
+	void run();
+	void writeRow(int index, const std::vector<float>& paramValues);
+};
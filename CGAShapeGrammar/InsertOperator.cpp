@@ -13,4 +13,8 @@ boost::shared_ptr<Shape> InsertOperator::apply(boost::shared_ptr<Shape>& shape,
 	return shape->insert(shape->_name, grammar.evalString(geometryPath, shape));
 }
 
+void InsertOperator::getResources(const Grammar& grammar, std::set<std::string>& geometryPaths, std::set<std::string>& texturePaths) const {
+	geometryPaths.insert(grammar.evalString(geometryPath, boost::shared_ptr<Shape>()));
+}
+
 }
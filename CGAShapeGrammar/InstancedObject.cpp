@@ -0,0 +1,65 @@
+#include "InstancedObject.h"
+#include "CGA.h"
+
+namespace cga {
+
+InstancedObject::InstancedObject(const std::string& name, const std::string& grammar_type, const glm::mat4& pivot, const glm::mat4& modelMat, const glm::vec3& scope, const boost::shared_ptr<const Asset>& asset, const glm::mat4& meshMat, const glm::vec3& color) {
+	this->_active = true;
+	this->_axiom = false;
+	this->_name = name;
+	this->_grammar_type = grammar_type;
+	this->_pivot = pivot;
+	this->_modelMat = modelMat;
+	this->_scope = scope;
+	this->_asset = asset;
+	this->_meshMat = meshMat;
+	this->_color = color;
+	this->_uvTransform = glm::vec4(1, 1, 0, 0);
+	this->_uvFromPosition = false;
+	this->_textureEnabled = false;
+}
+
+/**
+ * The texture coordinates are given by (uvFromPosition ? position.xy : texCoord) * uvTransform.xy + uvTransform.zw,
+ * where position and texCoord are the ones of the shared mesh.
+ */
+InstancedObject::InstancedObject(const std::string& name, const std::string& grammar_type, const glm::mat4& pivot, const glm::mat4& modelMat, const glm::vec3& scope, const boost::shared_ptr<const Asset>& asset, const glm::mat4& meshMat, const glm::vec3& color, const glm::vec4& uvTransform, bool uvFromPosition, const std::string& texture) {
+	this->_active = true;
+	this->_axiom = false;
+	this->_name = name;
+	this->_grammar_type = grammar_type;
+	this->_pivot = pivot;
+	this->_modelMat = modelMat;
+	this->_scope = scope;
+	this->_asset = asset;
+	this->_meshMat = meshMat;
+	this->_color = color;
+	this->_uvTransform = uvTransform;
+	this->_uvFromPosition = uvFromPosition;
+	this->_texture = texture;
+	this->_textureEnabled = true;
+}
+
+boost::shared_ptr<Shape> InstancedObject::clone(const std::string& name) const {
+	boost::shared_ptr<Shape> copy = boost::shared_ptr<Shape>(new InstancedObject(*this));
+	copy->_name = name;
+	return copy;
+}
+
+void InstancedObject::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
+	if (!_active) return;
+
+	// use the simplified variant for the coarse level of detail
+	boost::shared_ptr<const glutils::Mesh> mesh = _asset->mesh;
+	if (_lod > 0 && !_asset->lods.empty()) {
+		mesh = _asset->lods[std::min((int)_asset->lods.size(), _lod) - 1]->mesh;
+	}
+	if (mesh->vertices.empty()) return;
+
+	boost::shared_ptr<glutils::Face> face(new glutils::Face(_name, _grammar_type, mesh, _pivot * _modelMat * _meshMat, glm::vec4(_color, opacity), _textureEnabled ? _texture : ""));
+	face->uvTransform = _uvTransform;
+	face->uvFromPosition = _uvFromPosition;
+	faces.push_back(face);
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include "Shape.h"
+
+namespace cga {
+
+/**
+ * Inserted geometry that refers to the shared immutable asset instead of owning a copy of it.
+ * The fitting of the asset to the scope is stored as a matrix, so that each insert costs O(1) memory.
+ */
+class InstancedObject : public Shape {
+private:
+	boost::shared_ptr<const Asset> _asset;
+	glm::mat4 _meshMat;
+	glm::vec4 _uvTransform;
+	bool _uvFromPosition;
+
+public:
+	InstancedObject(const std::string& name, const std::string& grammar_type, const glm::mat4& pivot, const glm::mat4& modelMat, const glm::vec3& scope, const boost::shared_ptr<const Asset>& asset, const glm::mat4& meshMat, const glm::vec3& color);
+	InstancedObject(const std::string& name, const std::string& grammar_type, const glm::mat4& pivot, const glm::mat4& modelMat, const glm::vec3& scope, const boost::shared_ptr<const Asset>& asset, const glm::mat4& meshMat, const glm::vec3& color, const glm::vec4& uvTransform, bool uvFromPosition, const std::string& texture);
+	boost::shared_ptr<Shape> clone(const std::string& name) const;
+	void generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const;
+};
+
+}
@@ -0,0 +1,73 @@
+#include "LODPolicy.h"
+#include <algorithm>
+#include <limits>
+
+namespace cga {
+
+LODPolicy::LODPolicy() {
+	enabled = false;
+	viewportWidth = 0;
+	viewportHeight = 0;
+	minPixelSize = 1.0f;
+	fullDetailPixelSize = 64.0f;
+}
+
+LODPolicy::LODPolicy(const glm::mat4& mvpMatrix, int viewportWidth, int viewportHeight, float minPixelSize, float fullDetailPixelSize) {
+	this->enabled = true;
+	this->mvpMatrix = mvpMatrix;
+	this->viewportWidth = viewportWidth;
+	this->viewportHeight = viewportHeight;
+	this->minPixelSize = minPixelSize;
+	this->fullDetailPixelSize = fullDetailPixelSize;
+}
+
+/**
+ * Return the size in pixels of the screen-space bounding box of the scope.
+ * If the scope crosses the near plane, the size is regarded as infinite.
+ *
+ * @param mat		the matrix from the shape coordinates to the world coordinates, i.e., pivot * modelMat
+ * @param scope		the scope of the shape
+ */
+float LODPolicy::projectedSize(const glm::mat4& mat, const glm::vec3& scope) const {
+	glm::mat4 m = mvpMatrix * mat;
+
+	glm::vec2 minPt(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+	glm::vec2 maxPt(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+	for (int i = 0; i < 8; ++i) {
+		glm::vec4 p = m * glm::vec4((i & 1) ? scope.x : 0, (i & 2) ? scope.y : 0, (i & 4) ? scope.z : 0, 1);
+		if (p.w <= 0.0f) return std::numeric_limits<float>::max();
+
+		glm::vec2 ndc(p.x / p.w, p.y / p.w);
+		minPt = glm::min(minPt, ndc);
+		maxPt = glm::max(maxPt, ndc);
+	}
+
+	// Shapes outside the view frustum are not culled, since they may still cast shadows.
+	return std::max((maxPt.x - minPt.x) * 0.5f * viewportWidth, (maxPt.y - minPt.y) * 0.5f * viewportHeight);
+}
+
+/**
+ * Return the level of detail of the shape, or LOD_CULLED if the shape does not need to be generated.
+ */
+int LODPolicy::level(const glm::mat4& mat, const glm::vec3& scope) const {
+	if (!enabled) return 0;
+
+	float size = projectedSize(mat, scope);
+	if (size < minPixelSize) return LOD_CULLED;
+
+	int level = 0;
+	while (level < MAX_LEVEL && size < fullDetailPixelSize / (float)(1 << level)) {
+		level++;
+	}
+	return level;
+}
+
+/**
+ * Return the number of slices for the specified level of detail.
+ */
+int LODPolicy::slices(int slices, int level, int minSlices) {
+	if (level <= 0) return slices;
+	return std::max(minSlices, slices >> level);
+}
+
+}
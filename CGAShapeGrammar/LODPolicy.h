@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace cga {
+
+/**
+ * Level-of-detail policy used by CGA::generateGeometry().
+ * The level of each shape is determined by the projected size of its scope on the target image.
+ * Level 0 is the full detail, and each level halves the tessellation of the curved primitives.
+ * Shapes whose projected size is smaller than minPixelSize are skipped entirely.
+ */
+class LODPolicy {
+public:
+	enum { LOD_CULLED = -1 };
+
+	/** the number of simplified levels in addition to the full detail */
+	static const int MAX_LEVEL = 3;
+
+public:
+	bool enabled;
+	glm::mat4 mvpMatrix;
+	int viewportWidth;
+	int viewportHeight;
+	float minPixelSize;
+	float fullDetailPixelSize;
+
+public:
+	LODPolicy();
+	LODPolicy(const glm::mat4& mvpMatrix, int viewportWidth, int viewportHeight, float minPixelSize = 1.0f, float fullDetailPixelSize = 64.0f);
+
+	float projectedSize(const glm::mat4& mat, const glm::vec3& scope) const;
+	int level(const glm::mat4& mat, const glm::vec3& scope) const;
+	static int slices(int slices, int level, int minSlices);
+};
+
+}
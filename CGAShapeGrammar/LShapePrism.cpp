@@ -159,17 +159,19 @@ void LShapePrism::split(int splitAxis, const std::vector<float>& sizes, const st
 void LShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	// top
 	{
 		std::vector<Vertex> vertices;
-		glutils::drawQuad(_front_width, _scope.y - _right_width, glm::vec4(_color, opacity), glm::translate(_pivot * _modelMat, glm::vec3(_front_width * 0.5f, (_scope.y - _right_width) * 0.5f, _scope.z)), vertices);
-		glutils::drawQuad(_scope.x, _right_width, glm::vec4(_color, opacity), glm::translate(_pivot * _modelMat, glm::vec3(_scope.x * 0.5, _scope.y - _right_width * 0.5, _scope.z)), vertices);
+		glutils::drawQuad(_front_width, _scope.y - _right_width, glm::vec4(_color, opacity), glm::translate(shapeMat, glm::vec3(_front_width * 0.5f, (_scope.y - _right_width) * 0.5f, _scope.z)), vertices);
+		glutils::drawQuad(_scope.x, _right_width, glm::vec4(_color, opacity), glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y - _right_width * 0.5, _scope.z)), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices, _texture)));
 	}
 
 	// base
 	if (_scope.z >= 0) {
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y, 0)), M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y, 0)), M_PI, glm::vec3(1, 0, 0));
 		std::vector<Vertex> vertices;
 		glutils::drawQuad(_scope.x, _right_width, glm::vec4(_color, opacity), glm::translate(mat, glm::vec3(_scope.x * 0.5f, _right_width * 0.5f, 0)), vertices);
 		glutils::drawQuad(_front_width, _scope.y - _right_width, glm::vec4(_color, opacity), glm::translate(mat, glm::vec3(_front_width * 0.5f, _scope.y - _right_width * 0.5f, 0)), vertices);
@@ -183,17 +185,17 @@ void LShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width * 0.5f, 0, _scope.z * 0.5f)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width * 0.5f, 0, _scope.z * 0.5f)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_front_width, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width, (_scope.y - _right_width) * 0.5f, _scope.z * 0.5f)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width, (_scope.y - _right_width) * 0.5f, _scope.z * 0.5f)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y - _right_width, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3((_scope.x +_front_width) * 0.5f, _scope.y - _right_width, _scope.z * 0.5f)), rot_angle, glm::vec3(1, 0, 0));
+		mat = glm::rotate(glm::translate(shapeMat, glm::vec3((_scope.x +_front_width) * 0.5f, _scope.y - _right_width, _scope.z * 0.5f)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x - _front_width, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -205,7 +207,7 @@ void LShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -217,7 +219,7 @@ void LShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y - _right_width * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y - _right_width * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_right_width, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -229,7 +231,7 @@ void LShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y * 0.5f, _scope.z * 0.5f)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y * 0.5f, _scope.z * 0.5f)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
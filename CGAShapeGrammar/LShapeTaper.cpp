@@ -121,6 +121,8 @@ void LShapeTaper::size(float xSize, float ySize, float zSize, bool centered) {
 void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	float offset = _scope.z / tanf(_slope / 180.0f * M_PI);
 
 	// top face
@@ -135,19 +137,19 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		points.push_back(glm::vec2(_scope.x - offset * 2, _scope.y - offset * 2));
 		points.push_back(glm::vec2(0, _scope.y - offset * 2));
 
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(offset, offset, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(offset, offset, _scope.z));
 		glutils::drawPolygon(points, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 	else if (_front_width * 0.5f > offset) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_front_width * 0.5f, _scope.y * 0.5f, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_front_width * 0.5f, _scope.y * 0.5f, _scope.z));
 		glutils::drawQuad(_front_width - offset * 2, _scope.y - offset * 2, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 	else if (_right_width * 0.5f > offset) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5f, _scope.y - _right_width * 0.5f, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_scope.x * 0.5f, _scope.y - _right_width * 0.5f, _scope.z));
 		glutils::drawQuad(_scope.x - offset * 2, _right_width - offset * 2, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -155,7 +157,7 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 	// side faces
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(_modelMat, _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(shapeMat, _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_front_width, 0));
@@ -167,7 +169,7 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y - _right_width, 0));
@@ -179,7 +181,7 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width, _scope.y - _right_width, 0)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width, _scope.y - _right_width, 0)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.x - _front_width, 0));
@@ -191,7 +193,7 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y - _right_width, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y - _right_width, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_right_width, 0));
@@ -203,7 +205,7 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y, 0)), M_PI, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y, 0)), M_PI, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.x, 0));
@@ -215,7 +217,7 @@ void LShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y, 0));
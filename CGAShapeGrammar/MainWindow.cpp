@@ -1,6 +1,12 @@
 #include "MainWindow.h"
 #include <QFileDialog>
+#include <QFileInfo>
 #include "OBJWriter.h"
+#include "GLBWriter.h"
+#include "PLYWriter.h"
+#include "GeometryCache.h"
+#include "AssetCache.h"
+#include "ThreadPool.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 	ui.setupUi(this);
@@ -18,7 +24,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 	connect(ui.actionExit, SIGNAL(triggered()), this, SLOT(close()));
 	connect(ui.actionOpenCGA, SIGNAL(triggered()), this, SLOT(onOpenCGA()));
 	connect(ui.actionSaveGeometry, SIGNAL(triggered()), this, SLOT(onSaveGeometry()));
+	connect(ui.actionExportGeometryWhileDeriving, SIGNAL(triggered()), this, SLOT(onExportGeometryWhileDeriving()));
 	connect(ui.actionViewShadow, SIGNAL(triggered()), this, SLOT(onViewShadow()));
+	connect(ui.actionViewCullHiddenFaces, SIGNAL(triggered()), this, SLOT(onViewCullHiddenFaces()));
+	connect(ui.actionViewCacheGeometry, SIGNAL(triggered()), this, SLOT(onViewCacheGeometry()));
+	connect(ui.actionViewCacheAssets, SIGNAL(triggered()), this, SLOT(onViewCacheAssets()));
 	connect(ui.actionViewBasicRendering, SIGNAL(triggered()), this, SLOT(onViewRendering()));
 	connect(ui.actionViewSSAO, SIGNAL(triggered()), this, SLOT(onViewRendering()));
 	connect(ui.actionViewLineRendering, SIGNAL(triggered()), this, SLOT(onViewRendering()));
@@ -29,6 +39,9 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 	connect(ui.actionRotationEnd, SIGNAL(triggered()), this, SLOT(onRotationEnd()));
 
 	connect(ui.actionGenerateBuildingImages, SIGNAL(triggered()), this, SLOT(onGenerateBuildingImages()));
+	connect(ui.actionGenerateSketchImages, SIGNAL(triggered()), this, SLOT(onGenerateSketchImages()));
+	connect(ui.actionGenerateBuildingImagesInWorkers, SIGNAL(triggered()), this, SLOT(onGenerateBuildingImagesInWorkers()));
+	connect(ui.actionCheckSoftwareRenderer, SIGNAL(triggered()), this, SLOT(onCheckSoftwareRenderer()));
 
 	glWidget = new GLWidget3D(this);
 	setCentralWidget(glWidget);
@@ -50,10 +63,46 @@ void MainWindow::onOpenCGA() {
 }
 
 void MainWindow::onSaveGeometry() {
-	QString filename = QFileDialog::getSaveFileName(this, tr("Save OBJ file..."), "", tr("OBJ Files (*.obj)"));
+	QString filename = QFileDialog::getSaveFileName(this, tr("Save geometry file..."), "", tr("OBJ Files (*.obj);;glTF Binary Files (*.glb);;PLY Files (*.ply)"));
 	if (filename.isEmpty()) return;
 
-	OBJWriter::write(glWidget->faces, filename.toUtf8().constData());
+	QString suffix = QFileInfo(filename).suffix().toLower();
+	bool written;
+	if (suffix == "glb") {
+		written = GLBWriter::write(glWidget->faces, filename.toUtf8().constData());
+	}
+	else if (suffix == "ply") {
+		written = PLYWriter::write(glWidget->faces, filename.toUtf8().constData());
+	}
+	else {
+		written = OBJWriter::write(glWidget->faces, filename.toUtf8().constData());
+	}
+	if (!written) {
+		statusBar()->showMessage("The file cannot be written: " + filename);
+	}
+}
+
+/**
+ * Derive the current grammar again, and write the geometry to the file while deriving, which is for
+ * the scenes that are too large to keep in memory.
+ */
+void MainWindow::onExportGeometryWhileDeriving() {
+	if (!fileLoaded) return;
+
+	QString new_filename = QFileDialog::getSaveFileName(this, tr("Export geometry file..."), "", tr("OBJ Files (*.obj);;PLY Files (*.ply)"));
+	if (new_filename.isEmpty()) return;
+
+	if (QFileInfo(new_filename).suffix().toLower() == "ply") {
+		PLYStreamWriter sink(new_filename.toUtf8().constData());
+		glWidget->exportCGA(filename.toUtf8().data(), sink);
+		if (sink.failed) {
+			statusBar()->showMessage("The file cannot be written: " + new_filename);
+		}
+	}
+	else {
+		OBJStreamWriter sink(new_filename.toUtf8().constData());
+		glWidget->exportCGA(filename.toUtf8().data(), sink);
+	}
 }
 
 void MainWindow::onViewShadow() {
@@ -61,6 +110,19 @@ void MainWindow::onViewShadow() {
 	glWidget->updateGL();
 }
 
+void MainWindow::onViewCullHiddenFaces() {
+	glWidget->system.faceCulling.enabled = ui.actionViewCullHiddenFaces->isChecked();
+	onViewRefresh();
+}
+
+void MainWindow::onViewCacheGeometry() {
+	cga::GeometryCache::enabled = ui.actionViewCacheGeometry->isChecked();
+}
+
+void MainWindow::onViewCacheAssets() {
+	cga::AssetCache::enabled = ui.actionViewCacheAssets->isChecked();
+}
+
 void MainWindow::onViewRendering() {
 	if (ui.actionViewBasicRendering->isChecked()) {
 		glWidget->renderManager.renderingMode = RenderManager::RENDERING_MODE_BASIC;
@@ -98,6 +160,18 @@ void MainWindow::onGenerateBuildingImages() {
 	glWidget->generateBuildingImages(256, 256, true);
 }
 
+void MainWindow::onGenerateSketchImages() {
+	glWidget->generateBuildingImages(256, 256, true, 1, 16, boost::shared_ptr<ImageSink>(), true);
+}
+
+void MainWindow::onGenerateBuildingImagesInWorkers() {
+	glWidget->generateBuildingImages(256, 256, true, 1, 16, boost::shared_ptr<ImageSink>(), false, ThreadPool::defaultSize());
+}
+
+void MainWindow::onCheckSoftwareRenderer() {
+	glWidget->checkSoftwareRenderer();
+}
+
 void MainWindow::camera_update() {
 	glWidget->camera.yrot += 0.02;
 	glWidget->camera.updateMVPMatrix();
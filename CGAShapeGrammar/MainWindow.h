@@ -21,12 +21,19 @@ public:
 public slots:
 	void onOpenCGA();
 	void onSaveGeometry();
+	void onExportGeometryWhileDeriving();
 	void onViewShadow();
+	void onViewCullHiddenFaces();
+	void onViewCacheGeometry();
+	void onViewCacheAssets();
 	void onViewRendering();
 	void onViewRefresh();
 	void onRotationStart();
 	void onRotationEnd();
 	void onGenerateBuildingImages();
+	void onGenerateSketchImages();
+	void onGenerateBuildingImagesInWorkers();
+	void onCheckSoftwareRenderer();
 	void camera_update();
 };
 
@@ -1,244 +1,429 @@
 #include "OBJLoader.h"
-#include <fstream>
-#include <iostream>
-#include <sstream>
-#include <QString>
-#include <QTextStream>
-#include <QStringList>
 #include <QFile>
+#include <QByteArray>
+
+namespace {
 
 /**
- * Load vertices data from a OBJ file.
+ * Contents of an OBJ file.
+ * The corners of all the faces are stored in flat arrays, and the corners of the i-th face are
+ * faceStart[i], ..., faceStart[i + 1] - 1. The indices are 0-based, and -1 means that the
+ * corner does not have the corresponding attribute.
  */
-void OBJLoader::load(const char* filename, std::vector<Vertex>& vertices) {
-	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly)) {
-		return;
+struct OBJData {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<int> faceStart;
+	std::vector<int> v_elements;
+	std::vector<int> t_elements;
+	std::vector<int> n_elements;
+
+	OBJData() { faceStart.push_back(0); }
+	int numFaces() const { return faceStart.size() - 1; }
+	int numCorners(int face) const { return faceStart[face + 1] - faceStart[face]; }
+	bool hasTexCoords(int face) const;
+	bool hasNormals(int face) const;
+};
+
+bool OBJData::hasTexCoords(int face) const {
+	for (int i = faceStart[face]; i < faceStart[face + 1]; ++i) {
+		if (t_elements[i] < 0) return false;
 	}
+	return true;
+}
 
-	QTextStream in(&file);
- 
-	std::vector<float> raw_vertices;
-	std::vector<float> raw_normals;
-	std::vector<float> raw_texCoords;
-	std::vector<unsigned int> v_elements;
-	std::vector<unsigned int> t_elements;
-	std::vector<unsigned int> n_elements;
-
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		if (line.startsWith("v ")) {
-			int index1 = line.indexOf(QRegExp("[0-9\\.\\-]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			raw_vertices.push_back(values[0].toFloat());
-			raw_vertices.push_back(values[1].toFloat());
-			raw_vertices.push_back(values[2].toFloat());
-		} else if (line.startsWith("vn ")) {
-			int index1 = line.indexOf(QRegExp("[0-9\\.\\-]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			raw_normals.push_back(values[0].toFloat());
-			raw_normals.push_back(values[1].toFloat());
-			raw_normals.push_back(values[2].toFloat());
-		} else if (line.startsWith("vt ")) {
-			int index1 = line.indexOf(QRegExp("[0-9\\.\\-]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			raw_texCoords.push_back(values[0].toFloat());
-			raw_texCoords.push_back(values[1].toFloat());
-		} else if (line.startsWith("f ")) {
-			int index1 = line.indexOf(QRegExp("[0-9]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			for (int i = 0; i < values.size() - 2; ++i) {
-				unsigned int a,b,c;
-				a = values[0].split("/")[0].toUInt() - 1;
-				b = values[i+1].split("/")[0].toUInt() - 1;
-				c = values[i+2].split("/")[0].toUInt() - 1;
-				v_elements.push_back(a); v_elements.push_back(b); v_elements.push_back(c);
-
-				if (values[0].split("/").size() >= 2 && values[0].split("/")[1].size() > 0) {
-					a = values[0].split("/")[1].toUInt() - 1;
-					b = values[i+1].split("/")[1].toUInt() - 1;
-					c = values[i+2].split("/")[1].toUInt() - 1;
-					t_elements.push_back(a); t_elements.push_back(b); t_elements.push_back(c);
-				}
+bool OBJData::hasNormals(int face) const {
+	for (int i = faceStart[face]; i < faceStart[face + 1]; ++i) {
+		if (n_elements[i] < 0) return false;
+	}
+	return true;
+}
 
-				if (values[0].split("/").size() >= 3 && values[0].split("/")[2].size() > 0) {
-					a = values[0].split("/")[2].toUInt() - 1;
-					b = values[i+1].split("/")[2].toUInt() - 1;
-					c = values[i+2].split("/")[2].toUInt() - 1;
-					n_elements.push_back(a); n_elements.push_back(b); n_elements.push_back(c);
-				}
-			}
-		} else if (line.size() == 0) {
-			/* ignore empty line */
-		} else if (line.startsWith("#")) {
-			/* ignore comment line */
+/**
+ * Hand-written scanner that works directly on the contents of the file without any allocation.
+ */
+class OBJScanner {
+private:
+	const char* p;
+	const char* end;
+
+public:
+	OBJScanner(const char* data, qint64 size) : p(data), end(data + size) {}
+
+	bool atEnd() const { return p >= end; }
+	bool atEndOfLine() const { return p >= end || *p == '\n'; }
+	bool isSpace(char c) const { return c == ' ' || c == '\t' || c == '\r'; }
+	bool isDigit(char c) const { return c >= '0' && c <= '9'; }
+
+	void skipSpaces() {
+		while (p < end && isSpace(*p)) ++p;
+	}
+
+	void skipLine() {
+		while (p < end && *p != '\n') ++p;
+		if (p < end) ++p;
+	}
+
+	/**
+	 * Read the keyword at the beginning of the line, e.g., "v", "vt", "f".
+	 */
+	int readKeyword(const char*& keyword) {
+		skipSpaces();
+		keyword = p;
+		while (p < end && !isSpace(*p) && *p != '\n') ++p;
+		return p - keyword;
+	}
+
+	bool readFloat(float& value);
+	bool readIndex(int& value);
+	bool readCorner(int& v, int& t, int& n);
+};
+
+/**
+ * Read a floating point number.
+ * The decimal mantissa and exponent are accumulated as integers, and if the mantissa is exactly
+ * representable and |exponent| <= 22, a single multiplication or division gives the correctly rounded
+ * double. Otherwise, the token is converted by Qt. In both cases, the double is rounded to float
+ * in the same way as QString::toFloat().
+ */
+bool OBJScanner::readFloat(float& value) {
+	static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	skipSpaces();
+	const char* start = p;
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		++p;
+	}
+
+	unsigned long long mantissa = 0;
+	int numDigits = 0;
+	int exponent = 0;
+	bool exact = true;
+
+	while (p < end && isDigit(*p)) {
+		if (mantissa < 100000000000000000ULL) {
+			mantissa = mantissa * 10 + (*p - '0');
 		} else {
-			/* ignore this line */
+			exponent++;
+			if (*p != '0') exact = false;
+		}
+		numDigits++;
+		++p;
+	}
+	if (p < end && *p == '.') {
+		++p;
+		while (p < end && isDigit(*p)) {
+			if (mantissa < 100000000000000000ULL) {
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
+			} else if (*p != '0') {
+				exact = false;
+			}
+			numDigits++;
+			++p;
 		}
 	}
+	if (numDigits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negativeExponent = *p == '-';
+			++p;
+		}
+		if (p >= end || !isDigit(*p)) exact = false;
+		int e = 0;
+		while (p < end && isDigit(*p)) {
+			if (e < 10000) e = e * 10 + (*p - '0');
+			++p;
+		}
+		exponent += negativeExponent ? -e : e;
+	}
 
-	vertices.resize(v_elements.size());
-	for (int i = 0; i < v_elements.size(); i+=3) {
-		unsigned int ia = v_elements[i];
-		unsigned int ib = v_elements[i+1];
-		unsigned int ic = v_elements[i+2];
+	// anything else, e.g., "nan" or "inf", is left to Qt
+	if (numDigits == 0 || (p < end && !isSpace(*p) && *p != '\n')) {
+		while (p < end && !isSpace(*p) && *p != '\n') ++p;
+		exact = false;
+	}
+	if (p == start) return false;
 
-		for (int j = 0; j < 3; ++j) {
-			vertices[i].position[j] = raw_vertices[ia*3 + j];
-			vertices[i+1].position[j] = raw_vertices[ib*3 + j];
-			vertices[i+2].position[j] = raw_vertices[ic*3 + j];
+	double d;
+	if (exact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+		d = exponent >= 0 ? (double)mantissa * POW10[exponent] : (double)mantissa / POW10[-exponent];
+		if (negative) d = -d;
+	} else {
+		bool ok;
+		d = QByteArray::fromRawData(start, p - start).toDouble(&ok);
+		if (!ok) return false;
+	}
+
+	value = (float)d;
+	return true;
+}
+
+/**
+ * Read an integer index, which may be negative.
+ */
+bool OBJScanner::readIndex(int& value) {
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		++p;
+	}
+	if (p >= end || !isDigit(*p)) return false;
+
+	value = 0;
+	while (p < end && isDigit(*p)) {
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+	if (negative) value = -value;
+	return true;
+}
+
+/**
+ * Read a corner of a face in the form of "v", "v/t", "v//n", or "v/t/n".
+ * The missing indices are set to 0.
+ */
+bool OBJScanner::readCorner(int& v, int& t, int& n) {
+	skipSpaces();
+	t = 0;
+	n = 0;
+
+	if (!readIndex(v)) return false;
+	if (p < end && *p == '/') {
+		++p;
+		if (p < end && *p != '/' && !isSpace(*p) && *p != '\n') {
+			if (!readIndex(t)) return false;
 		}
+		if (p < end && *p == '/') {
+			++p;
+			if (p < end && !isSpace(*p) && *p != '\n') {
+				if (!readIndex(n)) return false;
+			}
+		}
+	}
+
+	return p >= end || isSpace(*p) || *p == '\n';
+}
 
-		if (n_elements.size() > 0) {
-			for (int j = 0; j < 3; ++j) {
-				vertices[i].normal[j] = raw_normals[n_elements[i]*3 + j];
-				vertices[i+1].normal[j] = raw_normals[n_elements[i+1]*3 + j];
-				vertices[i+2].normal[j] = raw_normals[n_elements[i+2]*3 + j];
+/**
+ * Convert an 1-based or negative (relative) OBJ index to a 0-based index.
+ * 0 means that the index is missing, and it is converted to -1.
+ */
+bool resolveIndex(int index, int count, int& result) {
+	if (index > 0) result = index - 1;
+	else if (index < 0) result = count + index;
+	else result = -1;
+
+	return index == 0 || result >= 0;
+}
+
+/**
+ * Parse the contents of an OBJ file. Faces with less than three corners are skipped.
+ */
+bool parse(const char* data, qint64 size, OBJData& obj) {
+	OBJScanner scanner(data, size);
+
+	while (!scanner.atEnd()) {
+		const char* keyword;
+		int len = scanner.readKeyword(keyword);
+
+		if (len == 1 && keyword[0] == 'v') {
+			glm::vec3 p;
+			if (!scanner.readFloat(p.x) || !scanner.readFloat(p.y) || !scanner.readFloat(p.z)) return false;
+			obj.positions.push_back(p);
+		} else if (len == 2 && keyword[0] == 'v' && keyword[1] == 'n') {
+			glm::vec3 n;
+			if (!scanner.readFloat(n.x) || !scanner.readFloat(n.y) || !scanner.readFloat(n.z)) return false;
+			obj.normals.push_back(n);
+		} else if (len == 2 && keyword[0] == 'v' && keyword[1] == 't') {
+			// the second component is optional
+			glm::vec2 t;
+			if (!scanner.readFloat(t.x)) return false;
+			scanner.skipSpaces();
+			if (scanner.atEndOfLine()) {
+				t.y = 0.0f;
+			} else if (!scanner.readFloat(t.y)) {
+				return false;
 			}
-		} else {
-			glm::vec3 normal = glm::cross(
-				glm::vec3(raw_vertices[ib*3], raw_vertices[ib*3+1], raw_vertices[ib*3+2]) - glm::vec3(raw_vertices[ia*3], raw_vertices[ia*3+1], raw_vertices[ia*3+2]),
-				glm::vec3(raw_vertices[ic*3], raw_vertices[ic*3+1], raw_vertices[ic*3+2]) - glm::vec3(raw_vertices[ia*3], raw_vertices[ia*3+1], raw_vertices[ia*3+2]));
-			normal = glm::normalize(normal);
+			obj.texCoords.push_back(t);
+		} else if (len == 1 && keyword[0] == 'f') {
+			int first = obj.v_elements.size();
+			while (true) {
+				scanner.skipSpaces();
+				if (scanner.atEndOfLine()) break;
 
-			for (int j = 0; j < 3; ++j) {
-				vertices[i].normal[j] = j == 0 ? normal.x : (j == 1 ? normal.y : normal.z);
-				vertices[i+1].normal[j] = j == 0 ? normal.x : (j == 1 ? normal.y : normal.z);
-				vertices[i+2].normal[j] = j == 0 ? normal.x : (j == 1 ? normal.y : normal.z);
+				int v, t, n;
+				if (!scanner.readCorner(v, t, n)) return false;
+				if (v == 0) return false;
+				if (!resolveIndex(v, obj.positions.size(), v) || !resolveIndex(t, obj.texCoords.size(), t) || !resolveIndex(n, obj.normals.size(), n)) return false;
+				obj.v_elements.push_back(v);
+				obj.t_elements.push_back(t);
+				obj.n_elements.push_back(n);
 			}
-		}
 
-		if (t_elements.size() > 0) {
-			for (int j = 0; j < 2; ++j) {
-				vertices[i].texCoord[j] = raw_texCoords[t_elements[i]*2 + j];
-				vertices[i+1].texCoord[j] = raw_texCoords[t_elements[i+1]*2 + j];
-				vertices[i+2].texCoord[j] = raw_texCoords[t_elements[i+2]*2 + j];
+			if (obj.v_elements.size() - first < 3) {
+				obj.v_elements.resize(first);
+				obj.t_elements.resize(first);
+				obj.n_elements.resize(first);
+			} else {
+				obj.faceStart.push_back(obj.v_elements.size());
 			}
 		} else {
-			for (int j = 0; j < 3; ++j) {
-				vertices[i].texCoord[j] = 0.0f;
-				vertices[i+1].texCoord[j] = j == 0 ? 1.0f : 0.0f;
-				vertices[i+2].texCoord[j] = j == 0 ? 0.0f : 1.0f;
-			}
+			/* ignore empty, comment, and other lines */
 		}
 
-		// assign some colors
-		for (int j = 0; j < 3; ++j) {
-			vertices[i].color[j] = 1.0f;
-			vertices[i+1].color[j] = 1.0f;
-			vertices[i+2].color[j] = 1.0f;
-		}
+		scanner.skipLine();
 	}
+
+	// positive indices may refer to the vertices defined later, so they are validated at the end
+	for (int i = 0; i < obj.v_elements.size(); ++i) {
+		if (obj.v_elements[i] >= (int)obj.positions.size()) return false;
+		if (obj.t_elements[i] >= (int)obj.texCoords.size() || obj.n_elements[i] >= (int)obj.normals.size()) return false;
+	}
+
+	return true;
 }
 
 /**
- * Load vertices data from a OBJ file.
+ * Memory-map the file and parse it.
  */
-bool OBJLoader::load(const char* filename, std::vector<std::vector<glm::vec3> >& points, std::vector<std::vector<glm::vec3> >& normals, std::vector<std::vector<glm::vec2> >& texCoords) {
+bool parse(const char* filename, OBJData& obj) {
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly)) {
 		return false;
 	}
 
-	QTextStream in(&file);
- 
-	std::vector<glm::vec3> raw_vertices;
-	std::vector<glm::vec3> raw_normals;
-	std::vector<glm::vec2> raw_texCoords;
-	std::vector<std::vector<unsigned int> > v_elements;
-	std::vector<std::vector<unsigned int> > t_elements;
-	std::vector<std::vector<unsigned int> > n_elements;
-
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		if (line.startsWith("v ")) {
-			int index1 = line.indexOf(QRegExp("[0-9\\.\\-]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			raw_vertices.push_back(glm::vec3(values[0].toFloat(), values[1].toFloat(), values[2].toFloat()));
-		} else if (line.startsWith("vn ")) {
-			int index1 = line.indexOf(QRegExp("[0-9\\.\\-]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			raw_normals.push_back(glm::vec3(values[0].toFloat(), values[1].toFloat(), values[2].toFloat()));
-		} else if (line.startsWith("vt ")) {
-			int index1 = line.indexOf(QRegExp("[0-9\\.\\-]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-			raw_texCoords.push_back(glm::vec2(values[0].toFloat(), values[1].toFloat()));
-		} else if (line.startsWith("f ")) {
-			int index1 = line.indexOf(QRegExp("[0-9]"), 2);
-			int index2 = line.lastIndexOf(QRegExp("[0-9]"));
-			QStringList values = line.mid(index1, index2 - index1 + 1).split(" ");
-
-			std::vector<unsigned int> v_ele;
-			std::vector<unsigned int> n_ele;
-			std::vector<unsigned int> t_ele;
-			for (int i = 0; i < values.size(); ++i) {
-				v_ele.push_back(values[i].split("/")[0].toUInt() - 1);
-				if (values[0].split("/").size() >= 2 && values[0].split("/")[1].size() > 0) {
-					t_ele.push_back(values[i].split("/")[1].toUInt() - 1);
+	qint64 size = file.size();
+	if (size == 0) return true;
+
+	uchar* data = file.map(0, size);
+	if (data != NULL) {
+		return parse((const char*)data, size, obj);
+	}
+	else {
+		// some files, e.g., those in Qt resources, cannot be mapped
+		QByteArray contents = file.readAll();
+		return parse(contents.constData(), contents.size(), obj);
+	}
+}
+
+}
+
+/**
+ * Load vertices data from a OBJ file.
+ * The faces are triangulated as fans, and the normals are computed per triangle if they are not specified.
+ */
+void OBJLoader::load(const char* filename, std::vector<Vertex>& vertices) {
+	OBJData obj;
+	if (!parse(filename, obj)) {
+		return;
+	}
+
+	int numTriangles = 0;
+	for (int i = 0; i < obj.numFaces(); ++i) {
+		numTriangles += obj.numCorners(i) - 2;
+	}
+	vertices.resize(numTriangles * 3);
+
+	int k = 0;
+	for (int i = 0; i < obj.numFaces(); ++i) {
+		int start = obj.faceStart[i];
+		bool hasNormals = obj.hasNormals(i);
+		bool hasTexCoords = obj.hasTexCoords(i);
+
+		for (int j = 1; j < obj.numCorners(i) - 1; ++j, k += 3) {
+			int corners[3] = { start, start + j, start + j + 1 };
+
+			for (int l = 0; l < 3; ++l) {
+				vertices[k + l].position = obj.positions[obj.v_elements[corners[l]]];
+			}
+
+			if (hasNormals) {
+				for (int l = 0; l < 3; ++l) {
+					vertices[k + l].normal = obj.normals[obj.n_elements[corners[l]]];
 				}
-				if (values[0].split("/").size() >= 3 && values[0].split("/")[2].size() > 0) {
-					n_ele.push_back(values[i].split("/")[2].toUInt() - 1);
+			} else {
+				glm::vec3 normal = glm::normalize(glm::cross(vertices[k + 1].position - vertices[k].position, vertices[k + 2].position - vertices[k].position));
+				for (int l = 0; l < 3; ++l) {
+					vertices[k + l].normal = normal;
 				}
 			}
 
-			v_elements.push_back(v_ele);
-			if (t_ele.size() > 0) {
-				t_elements.push_back(t_ele);
+			if (hasTexCoords) {
+				for (int l = 0; l < 3; ++l) {
+					vertices[k + l].texCoord = obj.texCoords[obj.t_elements[corners[l]]];
+				}
+			} else {
+				vertices[k].texCoord = glm::vec2(0, 0);
+				vertices[k + 1].texCoord = glm::vec2(1, 0);
+				vertices[k + 2].texCoord = glm::vec2(0, 1);
 			}
-			if (n_ele.size() > 0) {
-				n_elements.push_back(n_ele);
+
+			// assign some colors
+			for (int l = 0; l < 3; ++l) {
+				vertices[k + l].color.r = 1.0f;
+				vertices[k + l].color.g = 1.0f;
+				vertices[k + l].color.b = 1.0f;
 			}
-		} else if (line.size() == 0) {
-			/* ignore empty line */
-		} else if (line.startsWith("#")) {
-			/* ignore comment line */
-		} else {
-			/* ignore this line */
 		}
 	}
+}
+
+/**
+ * Load vertices data from a OBJ file.
+ * If no face has texture coordinates, texCoords is left empty.
+ */
+bool OBJLoader::load(const char* filename, std::vector<std::vector<glm::vec3> >& points, std::vector<std::vector<glm::vec3> >& normals, std::vector<std::vector<glm::vec2> >& texCoords) {
+	OBJData obj;
+	if (!parse(filename, obj)) {
+		return false;
+	}
 
-	points.resize(v_elements.size());
-	normals.resize(v_elements.size());
-	if (t_elements.size() > 0) {
-		texCoords.resize(v_elements.size());
+	bool anyTexCoords = false;
+	for (int i = 0; i < obj.numFaces() && !anyTexCoords; ++i) {
+		anyTexCoords = obj.hasTexCoords(i);
 	}
-	for (int i = 0; i < v_elements.size(); ++i) {
-		points[i].resize(v_elements[i].size());
-		normals[i].resize(v_elements[i].size());
-		if (t_elements.size() > 0) {
-			texCoords[i].resize(v_elements[i].size());
+
+	points.resize(obj.numFaces());
+	normals.resize(obj.numFaces());
+	if (anyTexCoords) {
+		texCoords.resize(obj.numFaces());
+	}
+	for (int i = 0; i < obj.numFaces(); ++i) {
+		int start = obj.faceStart[i];
+		int n = obj.numCorners(i);
+
+		points[i].resize(n);
+		normals[i].resize(n);
+		if (anyTexCoords) {
+			texCoords[i].resize(n);
 		}
 
-		for (int j = 0; j < v_elements[i].size(); ++j) {
-			unsigned int idx = v_elements[i][j];
-			points[i][j] = raw_vertices[idx];
+		for (int j = 0; j < n; ++j) {
+			points[i][j] = obj.positions[obj.v_elements[start + j]];
 		}
 
-		if (n_elements.size() > 0 && n_elements[i].size() > 0) {
-			for (int j = 0; j < n_elements[i].size(); ++j) {
-				unsigned int idx = n_elements[i][j];
-				normals[i][j] = raw_normals[idx];
+		if (obj.hasNormals(i)) {
+			for (int j = 0; j < n; ++j) {
+				normals[i][j] = obj.normals[obj.n_elements[start + j]];
 			}
 		} else {
 			glm::vec3 normal = glm::cross(points[i][1] - points[i][0], points[i][2] - points[i][0]);
 			normal = glm::normalize(normal);
 
-			for (int j = 0; j < v_elements[i].size(); ++j) {
+			for (int j = 0; j < n; ++j) {
 				normals[i][j] = normal;
 			}
 		}
 
-		if (t_elements.size() > 0 && t_elements[i].size() > 0) {
-			for (int j = 0; j < t_elements[i].size(); ++j) {
-				unsigned int idx = t_elements[i][j];
-				texCoords[i][j] = raw_texCoords[idx];
+		if (obj.hasTexCoords(i)) {
+			for (int j = 0; j < n; ++j) {
+				texCoords[i][j] = obj.texCoords[obj.t_elements[start + j]];
 			}
 		}
 	}
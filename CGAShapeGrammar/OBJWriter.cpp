@@ -1,7 +1,15 @@
 #include "OBJWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <map>
 #include <sstream>
+#include <unordered_map>
 #include <boost/filesystem.hpp>
+#include <QFile>
+#include "ThreadPool.h"
 
 bool Material::equals(const Material& other) {
 	if (type != other.type) return false;
@@ -15,6 +23,23 @@ bool Material::equals(const Material& other) {
 	return true;
 }
 
+/**
+ * Order of the materials, which is used to give the same id to the equal materials.
+ */
+bool Material::operator<(const Material& other) const {
+	if (type != other.type) return type < other.type;
+	if (type == 1) {
+		for (int i = 0; i < 4; ++i) {
+			if (color[i] != other.color[i]) return color[i] < other.color[i];
+		}
+	}
+	else if (type == 2) {
+		return texture < other.texture;
+	}
+
+	return false;
+}
+
 std::string Material::to_string() {
 	std::stringstream ss;
 
@@ -142,95 +167,484 @@ void OBJWriter::write(const std::vector<sc::SceneObject>& objects, const std::st
 	file.close();
 }*/
 
-void OBJWriter::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename) {
-	std::ofstream file(filename);
-	std::ofstream mat_file(filename + ".mtl");
-
-	boost::filesystem::path p(filename + ".mtl");
+namespace {
+
+// number of triangles per chunk of the parallel export, which must not depend on the number of threads
+const int CHUNK_TRIANGLES = 1 << 16;
+
+/**
+ * Text buffer with the fast formatting of the numbers.
+ */
+class OBJBuffer {
+public:
+	std::string data;
+
+public:
+	OBJBuffer(int capacity = 0) { data.reserve(capacity); }
+
+	void append(const char* str) { data.append(str); }
+	void append(char c) { data.push_back(c); }
+	void appendInt(int value);
+	void appendFloat(float value);
+};
+
+void OBJBuffer::appendInt(int value) {
+	char buf[16];
+	int n = 0;
+	unsigned int v = value < 0 ? -(unsigned int)value : value;
+	do {
+		buf[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v > 0);
+	if (value < 0) buf[n++] = '-';
+	while (n > 0) data.push_back(buf[--n]);
+}
 
-	file << "mtllib " << p.filename().string() << std::endl;
-	file << std::endl;
+/**
+ * Append the shortest decimal in the fixed notation that is read back as the same float.
+ * For each number of the fractional digits d, the value is rounded to m / 10^d, and it is accepted
+ * if it lies strictly inside the rounding interval of the float, so that any correctly rounding
+ * reader gets the same float. The values that are too large or too small fall back to "%.9g",
+ * which is not always the shortest.
+ */
+void OBJBuffer::appendFloat(float value) {
+	static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17 };
+
+	if (value == 0.0f) {
+		append(std::signbit(value) ? "-0" : "0");
+		return;
+	}
 
-	file << "# List of geometric vertices" << std::endl;
-	for (int j = 0; j < faces.size(); ++j) {
-		for (int k = 0; k < faces[j]->vertices.size(); ++k) {
-			file << "v " << faces[j]->vertices[k].position.x << " " << faces[j]->vertices[k].position.y << " " << faces[j]->vertices[k].position.z << std::endl;
+	float absValue = fabs(value);
+	if (absValue < 1e7f && absValue >= 1e-7f) {
+		// the half of the distance to the closer neighbor float, shrunk by the error of the double arithmetic
+		unsigned int bits;
+		memcpy(&bits, &absValue, sizeof(float));
+		float next;
+		float prev;
+		bits++;
+		memcpy(&next, &bits, sizeof(float));
+		bits -= 2;
+		memcpy(&prev, &bits, sizeof(float));
+		double tolerance = std::min((double)next - (double)absValue, (double)absValue - (double)prev) * 0.5 * (1.0 - 1e-6);
+
+		for (int d = 0; d <= 17; ++d) {
+			double m = floor((double)absValue * POW10[d] + 0.5);
+			if (m >= 1e10) break;
+			if (fabs(m / POW10[d] - (double)absValue) < tolerance) {
+				unsigned long long mantissa = (unsigned long long)m;
+				unsigned long long intPart = mantissa / (unsigned long long)POW10[d];
+				unsigned long long fracPart = mantissa % (unsigned long long)POW10[d];
+
+				if (value < 0) data.push_back('-');
+				appendInt((int)intPart);
+				if (d > 0) {
+					data.push_back('.');
+					char digits[16];
+					for (int k = d - 1; k >= 0; --k) {
+						digits[k] = '0' + fracPart % 10;
+						fracPart /= 10;
+					}
+					data.append(digits, d);
+				}
+				return;
+			}
 		}
 	}
-	file << std::endl;
 
-	file << "# List of texture coordinates" << std::endl;
-	for (int j = 0; j < faces.size(); ++j) {
-		if (faces[j]->vertices.size() < 3) continue;
-		if (faces[j]->vertices[0].texCoord.x == 0 && faces[j]->vertices[0].texCoord.y == 0 && faces[j]->vertices[1].texCoord.x == 0 && faces[j]->vertices[1].texCoord.y == 0 && faces[j]->vertices[2].texCoord.x == 0 && faces[j]->vertices[2].texCoord.y == 0) continue;
+	char buf[32];
+	sprintf(buf, "%.9g", value);
+	append(buf);
+}
 
-		for (int k = 0; k < faces[j]->vertices.size(); ++k) {
-			file << "vt " << faces[j]->vertices[k].texCoord.x << " " << faces[j]->vertices[k].texCoord.y << std::endl;
+struct Vec3Key {
+	unsigned int v[3];
+
+	Vec3Key(const glm::vec3& p) { memcpy(v, &p[0], sizeof(v)); }
+	bool operator==(const Vec3Key& other) const { return v[0] == other.v[0] && v[1] == other.v[1] && v[2] == other.v[2]; }
+};
+
+struct Vec2Key {
+	unsigned int v[2];
+
+	Vec2Key(const glm::vec2& p) { memcpy(v, &p[0], sizeof(v)); }
+	bool operator==(const Vec2Key& other) const { return v[0] == other.v[0] && v[1] == other.v[1]; }
+};
+
+struct KeyHash {
+	size_t operator()(const Vec3Key& key) const { return (key.v[0] * 73856093u) ^ (key.v[1] * 19349663u) ^ (key.v[2] * 83492791u); }
+	size_t operator()(const Vec2Key& key) const { return (key.v[0] * 73856093u) ^ (key.v[1] * 19349663u); }
+};
+
+/**
+ * Return the 1-based index of the vector, which is appended to the buffer as a new line if it is not written yet.
+ * Note that the bit patterns are compared, so that 0 and -0 are different.
+ */
+int vertexIndex(const glm::vec3& p, const char* prefix, std::unordered_map<Vec3Key, int, KeyHash>& indices, OBJBuffer& buffer) {
+	std::pair<std::unordered_map<Vec3Key, int, KeyHash>::iterator, bool> result = indices.insert(std::make_pair(Vec3Key(p), (int)indices.size() + 1));
+	if (result.second) {
+		buffer.append(prefix);
+		buffer.appendFloat(p.x);
+		buffer.append(' ');
+		buffer.appendFloat(p.y);
+		buffer.append(' ');
+		buffer.appendFloat(p.z);
+		buffer.append('\n');
+	}
+	return result.first->second;
+}
+
+int texCoordIndex(const glm::vec2& t, std::unordered_map<Vec2Key, int, KeyHash>& indices, OBJBuffer& buffer) {
+	std::pair<std::unordered_map<Vec2Key, int, KeyHash>::iterator, bool> result = indices.insert(std::make_pair(Vec2Key(t), (int)indices.size() + 1));
+	if (result.second) {
+		buffer.append("vt ");
+		buffer.appendFloat(t.x);
+		buffer.append(' ');
+		buffer.appendFloat(t.y);
+		buffer.append('\n');
+	}
+	return result.first->second;
+}
+
+/**
+ * Return the material of the face whose vertices are given.
+ * The texture coordinates are not written if those of the first triangle are all zero.
+ */
+Material faceMaterial(const glutils::Face& face, const std::vector<Vertex>& vertices, bool& hasTexCoords) {
+	hasTexCoords = vertices[0].texCoord != glm::vec2(0, 0) || vertices[1].texCoord != glm::vec2(0, 0) || vertices[2].texCoord != glm::vec2(0, 0);
+
+	if (hasTexCoords && !face.texture.empty()) {
+		return Material(face.texture);
+	}
+	else {
+		return Material(vertices[0].color);
+	}
+}
+
+/**
+ * A contiguous range of the faces, which is formatted independently of the others.
+ * The vertex lines are numbered from 1 within the chunk, and the face lines are formatted after
+ * the offsets of the chunk are known from the counts of the preceding chunks.
+ */
+class OBJChunk {
+public:
+	int begin;
+	int end;
+	OBJBuffer positions;
+	OBJBuffer texCoords;
+	OBJBuffer normals;
+	int numPositions;
+	int numTexCoords;
+	int numNormals;
+	std::vector<Material> materials;
+	std::vector<std::vector<int> > corners;	// (position, texCoord, normal) of the corners of each material, where texCoord 0 means none
+	std::vector<OBJBuffer> faceLines;
+
+public:
+	OBJChunk(int begin, int end) : begin(begin), end(end), numPositions(0), numTexCoords(0), numNormals(0) {}
+
+	void formatVertices(const std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	void formatFaces(int positionOffset, int texCoordOffset, int normalOffset);
+};
+
+/**
+ * Format the vertex lines, and collect the local indices of the corners per material.
+ */
+void OBJChunk::formatVertices(const std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+	std::unordered_map<Vec3Key, int, KeyHash> positionIndices;
+	std::unordered_map<Vec2Key, int, KeyHash> texCoordIndices;
+	std::unordered_map<Vec3Key, int, KeyHash> normalIndices;
+	std::map<Material, int> materialIds;
+
+	// OBJ has no instancing, so the instances are written as flattened copies.
+	std::vector<Vertex> instanceVertices;
+
+	for (int j = begin; j < end; ++j) {
+		const std::vector<Vertex>* vertices = &faces[j]->vertices;
+		if (faces[j]->isInstance()) {
+			instanceVertices.clear();
+			faces[j]->instantiate(instanceVertices);
+			vertices = &instanceVertices;
+		}
+		if (vertices->size() < 3) continue;
+
+		bool hasTexCoords;
+		Material material = faceMaterial(*faces[j], *vertices, hasTexCoords);
+
+		std::map<Material, int>::iterator it = materialIds.find(material);
+		if (it == materialIds.end()) {
+			it = materialIds.insert(std::make_pair(material, (int)materials.size())).first;
+			materials.push_back(material);
+			corners.push_back(std::vector<int>());
+		}
+		std::vector<int>& materialCorners = corners[it->second];
+
+		for (int k = 0; k + 2 < vertices->size(); k += 3) {
+			for (int l = 0; l < 3; ++l) {
+				const Vertex& v = (*vertices)[k + l];
+				materialCorners.push_back(vertexIndex(v.position, "v ", positionIndices, positions));
+				materialCorners.push_back(hasTexCoords ? texCoordIndex(v.texCoord, texCoordIndices, texCoords) : 0);
+				materialCorners.push_back(vertexIndex(v.normal, "vn ", normalIndices, normals));
+			}
 		}
 	}
-	file << std::endl;
 
-	file << "# List of vertex normals" << std::endl;
-	for (int j = 0; j < faces.size(); ++j) {
-		for (int k = 0; k < faces[j]->vertices.size(); ++k) {
-			file << "vn " << faces[j]->vertices[k].normal.x << " " << faces[j]->vertices[k].normal.y << " " << faces[j]->vertices[k].normal.z << std::endl;
+	numPositions = positionIndices.size();
+	numTexCoords = texCoordIndices.size();
+	numNormals = normalIndices.size();
+}
+
+/**
+ * Format the face lines with the global indices, which are the local ones plus the offsets of the chunk.
+ */
+void OBJChunk::formatFaces(int positionOffset, int texCoordOffset, int normalOffset) {
+	faceLines.resize(materials.size());
+	for (int i = 0; i < materials.size(); ++i) {
+		OBJBuffer& lines = faceLines[i];
+		lines.data.reserve(corners[i].size() * 8);
+
+		for (int k = 0; k < corners[i].size(); k += 9) {
+			lines.append('f');
+			for (int l = 0; l < 9; l += 3) {
+				lines.append(' ');
+				lines.appendInt(corners[i][k + l] + positionOffset);
+				lines.append('/');
+				if (corners[i][k + l + 1] > 0) {
+					lines.appendInt(corners[i][k + l + 1] + texCoordOffset);
+				}
+				lines.append('/');
+				lines.appendInt(corners[i][k + l + 2] + normalOffset);
+			}
+			lines.append('\n');
 		}
+
+		std::vector<int>().swap(corners[i]);
 	}
-	file << std::endl;
+}
 
+/**
+ * A piece of the output file.
+ */
+struct OBJPiece {
+	const char* data;
+	size_t size;
 
-	int positionId = 1;
-	int texCoordId = 1;
-	int materialId = 1;
-	Material material;
+	OBJPiece(const std::string& str) : data(str.data()), size(str.size()) {}
+};
+
+}
+
+/**
+ * Write the faces to the OBJ file and the MTL file.
+ * The positions, normals, and texture coordinates are deduplicated within each chunk of about
+ * CHUNK_TRIANGLES triangles, and the faces are grouped by material, so that each material is defined
+ * and used only once. The chunks are formatted by numThreads threads (or all the cores if it is 0) in
+ * two passes, the vertex lines with the local indices and then the face lines with the global indices
+ * given by the prefix sums of the vertex counts. Since the chunks do not depend on the number of
+ * threads, the output is identical for any number of threads.
+ * Return false if the file cannot be written. The errors in the formatting, e.g., std::bad_alloc, are thrown.
+ */
+bool OBJWriter::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename, int numThreads) {
+	// split the faces into the chunks
+	std::vector<OBJChunk> chunks;
+	int numTriangles = 0;
+	int begin = 0;
 	for (int j = 0; j < faces.size(); ++j) {
-		if (faces[j]->vertices.size() < 3) continue;
+		numTriangles += (faces[j]->isInstance() ? faces[j]->mesh->vertices.size() : faces[j]->vertices.size()) / 3;
+		if (numTriangles >= CHUNK_TRIANGLES || j == faces.size() - 1) {
+			chunks.push_back(OBJChunk(begin, j + 1));
+			begin = j + 1;
+			numTriangles = 0;
+		}
+	}
 
-		bool textureEnabled = true;
-		if (faces[j]->texture.empty()) {
-			textureEnabled = false;
+	ThreadPool pool(numThreads);
+	for (int i = 0; i < chunks.size(); ++i) {
+		OBJChunk* chunk = &chunks[i];
+		pool.enqueue([chunk, &faces]() { chunk->formatVertices(faces); });
+	}
+	pool.wait();
+
+	// the materials are numbered in the order of their first use
+	std::map<Material, int> materialIds;
+	std::vector<Material> materials;
+	std::vector<std::vector<int> > chunkMaterialIds(chunks.size());
+	int positionOffset = 0;
+	int texCoordOffset = 0;
+	int normalOffset = 0;
+	for (int i = 0; i < chunks.size(); ++i) {
+		for (int k = 0; k < chunks[i].materials.size(); ++k) {
+			std::map<Material, int>::iterator it = materialIds.find(chunks[i].materials[k]);
+			if (it == materialIds.end()) {
+				it = materialIds.insert(std::make_pair(chunks[i].materials[k], (int)materials.size())).first;
+				materials.push_back(chunks[i].materials[k]);
+			}
+			chunkMaterialIds[i].push_back(it->second);
 		}
-		if (faces[j]->vertices[0].texCoord.x == 0 && faces[j]->vertices[0].texCoord.y == 0 && faces[j]->vertices[1].texCoord.x == 0 && faces[j]->vertices[1].texCoord.y == 0 && faces[j]->vertices[2].texCoord.x == 0 && faces[j]->vertices[2].texCoord.y == 0) {
-			textureEnabled = false;
+
+		OBJChunk* chunk = &chunks[i];
+		pool.enqueue([chunk, positionOffset, texCoordOffset, normalOffset]() { chunk->formatFaces(positionOffset, texCoordOffset, normalOffset); });
+
+		positionOffset += chunks[i].numPositions;
+		texCoordOffset += chunks[i].numTexCoords;
+		normalOffset += chunks[i].numNormals;
+	}
+	pool.wait();
+
+	// lay out the pieces of the file in order
+	boost::filesystem::path p(filename + ".mtl");
+	std::vector<std::string> headers;
+	headers.push_back("mtllib " + p.filename().string() + "\n\n# List of geometric vertices\n");
+	headers.push_back("\n# List of texture coordinates\n");
+	headers.push_back("\n# List of vertex normals\n");
+	headers.push_back("\n");
+	for (int i = 0; i < materials.size(); ++i) {
+		std::stringstream ss;
+		ss << "\nusemtl Material" << (i + 1) << "\n";
+		headers.push_back(ss.str());
+	}
+
+	std::vector<OBJPiece> pieces;
+	pieces.push_back(OBJPiece(headers[0]));
+	for (int i = 0; i < chunks.size(); ++i) pieces.push_back(OBJPiece(chunks[i].positions.data));
+	pieces.push_back(OBJPiece(headers[1]));
+	for (int i = 0; i < chunks.size(); ++i) pieces.push_back(OBJPiece(chunks[i].texCoords.data));
+	pieces.push_back(OBJPiece(headers[2]));
+	for (int i = 0; i < chunks.size(); ++i) pieces.push_back(OBJPiece(chunks[i].normals.data));
+	pieces.push_back(OBJPiece(headers[3]));
+	for (int m = 0; m < materials.size(); ++m) {
+		pieces.push_back(OBJPiece(headers[4 + m]));
+		for (int i = 0; i < chunks.size(); ++i) {
+			for (int k = 0; k < chunkMaterialIds[i].size(); ++k) {
+				if (chunkMaterialIds[i][k] == m) pieces.push_back(OBJPiece(chunks[i].faceLines[k].data));
+			}
 		}
+	}
+
+	std::vector<qint64> pieceOffsets(pieces.size() + 1, 0);
+	for (int i = 0; i < pieces.size(); ++i) {
+		pieceOffsets[i + 1] = pieceOffsets[i] + pieces[i].size;
+	}
 
-		Material new_material;
-		if (textureEnabled) {
-			new_material = Material(faces[j]->texture);
+	// the file is preallocated and mapped, so that the pieces are copied to their regions in parallel
+	QFile file(filename.c_str());
+	if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) return false;
+
+	uchar* dst = file.resize(pieceOffsets.back()) ? file.map(0, pieceOffsets.back()) : NULL;
+	if (dst != NULL) {
+		for (int i = 0; i < pieces.size(); ++i) {
+			if (pieces[i].size == 0) continue;
+			const OBJPiece* piece = &pieces[i];
+			uchar* region = dst + pieceOffsets[i];
+			pool.enqueue([piece, region]() { memcpy(region, piece->data, piece->size); });
 		}
-		else {
-			new_material = Material(faces[j]->vertices[0].color);
+		pool.wait();
+		if (!file.unmap(dst)) return false;
+	}
+	else {
+		if (!file.resize(0)) return false;
+		for (int i = 0; i < pieces.size(); ++i) {
+			if (file.write(pieces[i].data, pieces[i].size) != pieces[i].size) return false;
 		}
+	}
+	file.close();
+
+	std::ofstream mat_file(filename + ".mtl", std::ios::binary);
+	for (int i = 0; i < materials.size(); ++i) {
+		mat_file << "newmtl Material" << (i + 1) << "\n";
+		mat_file << materials[i].to_string() << "\n";
+	}
+	mat_file.close();
+	return !mat_file.fail();
+}
 
-		if (!new_material.equals(material)) {
-			material = new_material;
+OBJStreamWriter::OBJStreamWriter(const std::string& filename) : filename(filename), file(filename, std::ios::binary), numPositions(0), numTexCoords(0), numNormals(0), currentMaterial(-1) {
+	boost::filesystem::path p(filename + ".mtl");
+	file << "mtllib " << p.filename().string() << "\n";
+}
+
+OBJStreamWriter::~OBJStreamWriter() {
+	close();
+}
 
-			mat_file << "newmtl Material" << materialId << std::endl;
-			mat_file << material.to_string() << std::endl;
+/**
+ * Append the faces of a batch.
+ * The vertex lines of the batch are followed by its face lines, which refer to the vertices by the global indices.
+ */
+void OBJStreamWriter::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+	if (!file.is_open()) return;
+
+	OBJBuffer vertexLines;
+	OBJBuffer texCoordLines;
+	OBJBuffer normalLines;
+	OBJBuffer faceLines;
+	std::unordered_map<Vec3Key, int, KeyHash> positionIndices;
+	std::unordered_map<Vec2Key, int, KeyHash> texCoordIndices;
+	std::unordered_map<Vec3Key, int, KeyHash> normalIndices;
+	std::vector<Vertex> instanceVertices;
 
-			file << std::endl;
-			file << "usemtl Material" << materialId << std::endl;
-			materialId++;
+	for (int j = 0; j < faces.size(); ++j) {
+		const std::vector<Vertex>* vertices = &faces[j]->vertices;
+		if (faces[j]->isInstance()) {
+			instanceVertices.clear();
+			faces[j]->instantiate(instanceVertices);
+			vertices = &instanceVertices;
 		}
+		if (vertices->size() < 3) continue;
 
-		for (int k = 0; k < faces[j]->vertices.size() / 3; ++k) {
-			file << "f ";
-			for (int l = 0; l < 3; ++l) {
-				if (l > 0) {
-					file << " ";
-				}
-				file << positionId;
+		bool hasTexCoords;
+		Material material = faceMaterial(*faces[j], *vertices, hasTexCoords);
 
-				file << "/";
-				if (faces[j]->vertices[k].texCoord.x != 0 || faces[j]->vertices[k].texCoord.y != 0 || faces[j]->vertices[k + 1].texCoord.x != 0 || faces[j]->vertices[k + 1].texCoord.y != 0 || faces[j]->vertices[k + 2].texCoord.x != 0 || faces[j]->vertices[k + 2].texCoord.y != 0) {
-					file << texCoordId++;
-				}
+		std::map<Material, int>::iterator it = materialIds.find(material);
+		if (it == materialIds.end()) {
+			it = materialIds.insert(std::make_pair(material, (int)materials.size())).first;
+			materials.push_back(material);
+		}
+		if (it->second != currentMaterial) {
+			currentMaterial = it->second;
+			faceLines.append("usemtl Material");
+			faceLines.appendInt(currentMaterial + 1);
+			faceLines.append('\n');
+		}
 
-				file << "/" << positionId++;
+		for (int k = 0; k + 2 < vertices->size(); k += 3) {
+			faceLines.append('f');
+			for (int l = 0; l < 3; ++l) {
+				const Vertex& v = (*vertices)[k + l];
+				faceLines.append(' ');
+				faceLines.appendInt(vertexIndex(v.position, "v ", positionIndices, vertexLines) + numPositions);
+				faceLines.append('/');
+				if (hasTexCoords) {
+					faceLines.appendInt(texCoordIndex(v.texCoord, texCoordIndices, texCoordLines) + numTexCoords);
+				}
+				faceLines.append('/');
+				faceLines.appendInt(vertexIndex(v.normal, "vn ", normalIndices, normalLines) + numNormals);
 			}
-			file << std::endl;
+			faceLines.append('\n');
 		}
 	}
 
+	file.write(vertexLines.data.data(), vertexLines.data.size());
+	file.write(texCoordLines.data.data(), texCoordLines.data.size());
+	file.write(normalLines.data.data(), normalLines.data.size());
+	file.write(faceLines.data.data(), faceLines.data.size());
+
+	numPositions += positionIndices.size();
+	numTexCoords += texCoordIndices.size();
+	numNormals += normalIndices.size();
+}
+
+/**
+ * Finish the OBJ file, and write the MTL file of the materials used so far.
+ */
+void OBJStreamWriter::close() {
+	if (!file.is_open()) return;
 	file.close();
-}
\ No newline at end of file
+
+	std::ofstream mat_file(filename + ".mtl", std::ios::binary);
+	for (int i = 0; i < materials.size(); ++i) {
+		mat_file << "newmtl Material" << (i + 1) << "\n";
+		mat_file << materials[i].to_string() << "\n";
+	}
+	mat_file.close();
+}
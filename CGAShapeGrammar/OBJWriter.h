@@ -2,8 +2,11 @@
 
 #include <vector>
 #include <string>
+#include <fstream>
+#include <map>
 #include <glm/glm.hpp>
 #include "GLUtils.h"
+#include "GeometrySink.h"
 #include <boost/shared_ptr.hpp>
 
 class Material {
@@ -18,6 +21,7 @@ public:
 	Material(const std::string& texture) : type(2), texture(texture) {}
 
 	bool equals(const Material& other);
+	bool operator<(const Material& other) const;
 	std::string to_string();
 };
 
@@ -27,6 +31,29 @@ protected:
 
 public:
 	//static void write(const std::vector<sc::SceneObject>& objects, const std::string& filename);
-	static void write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename);
+	static bool write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename, int numThreads = 0);
 };
 
+/**
+ * Writer of an OBJ file that is appended batch by batch, so that the whole scene is never kept in memory.
+ * The vertices are deduplicated within each batch, and "usemtl" is written whenever the material changes.
+ * The MTL file is written by close().
+ */
+class OBJStreamWriter : public GeometrySink {
+private:
+	std::string filename;
+	std::ofstream file;
+	int numPositions;
+	int numTexCoords;
+	int numNormals;
+	std::map<Material, int> materialIds;
+	std::vector<Material> materials;
+	int currentMaterial;
+
+public:
+	OBJStreamWriter(const std::string& filename);
+	~OBJStreamWriter();
+
+	void write(const std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	void close();
+};
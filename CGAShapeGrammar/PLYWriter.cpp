@@ -0,0 +1,211 @@
+#include "PLYWriter.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+// width of the counts in the header of the streamed file
+const int COUNT_WIDTH = 10;
+
+/**
+ * A vertex record of the PLY file.
+ */
+#pragma pack(push, 1)
+struct PLYVertex {
+	float x, y, z;
+	float nx, ny, nz;
+	float s, t;
+	unsigned char red, green, blue, alpha;
+
+	bool operator==(const PLYVertex& other) const { return memcmp(this, &other, sizeof(PLYVertex)) == 0; }
+};
+
+struct PLYFace {
+	unsigned char count;
+	int indices[3];
+};
+#pragma pack(pop)
+
+struct PLYVertexHash {
+	size_t operator()(const PLYVertex& v) const {
+		const unsigned char* data = (const unsigned char*)&v;
+		size_t h = 2166136261u;
+		for (int i = 0; i < sizeof(PLYVertex); ++i) {
+			h = (h ^ data[i]) * 16777619u;
+		}
+		return h;
+	}
+};
+
+unsigned char toByte(float value) {
+	if (value <= 0.0f) return 0;
+	if (value >= 1.0f) return 255;
+	return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+PLYVertex toPLYVertex(const Vertex& v) {
+	PLYVertex result;
+	memset(&result, 0, sizeof(PLYVertex));
+	result.x = v.position.x;
+	result.y = v.position.y;
+	result.z = v.position.z;
+	result.nx = v.normal.x;
+	result.ny = v.normal.y;
+	result.nz = v.normal.z;
+	result.s = v.texCoord.x;
+	result.t = v.texCoord.y;
+	result.red = toByte(v.color.r);
+	result.green = toByte(v.color.g);
+	result.blue = toByte(v.color.b);
+	result.alpha = toByte(v.color.a);
+	return result;
+}
+
+/**
+ * Return the PLY header with the given counts of the vertices and the faces.
+ */
+std::string header(const std::string& numVertices, const std::string& numFaces) {
+	std::ostringstream header;
+	header << "ply\n";
+	header << "format binary_little_endian 1.0\n";
+	header << "comment generated by CGAShapeGrammar\n";
+	header << "element vertex " << numVertices << "\n";
+	header << "property float x\n";
+	header << "property float y\n";
+	header << "property float z\n";
+	header << "property float nx\n";
+	header << "property float ny\n";
+	header << "property float nz\n";
+	header << "property float s\n";
+	header << "property float t\n";
+	header << "property uchar red\n";
+	header << "property uchar green\n";
+	header << "property uchar blue\n";
+	header << "property uchar alpha\n";
+	header << "element face " << numFaces << "\n";
+	header << "property list uchar int vertex_indices\n";
+	header << "end_header\n";
+	return header.str();
+}
+
+/**
+ * Convert the faces to the PLY records, where the identical vertices are shared.
+ * The vertex indices of the faces start from indexOffset.
+ */
+void toPLYRecords(const std::vector<boost::shared_ptr<glutils::Face> >& faces, int indexOffset, std::vector<PLYVertex>& vertices, std::vector<PLYFace>& triangles) {
+	std::unordered_map<PLYVertex, int, PLYVertexHash> vertexIds;
+
+	std::vector<Vertex> scratch;
+	for (int i = 0; i < faces.size(); ++i) {
+		const std::vector<Vertex>* faceVertices = &faces[i]->vertices;
+		if (faces[i]->isInstance()) {
+			scratch.clear();
+			faces[i]->instantiate(scratch);
+			faceVertices = &scratch;
+		}
+
+		for (int k = 0; k + 2 < faceVertices->size(); k += 3) {
+			PLYFace triangle;
+			triangle.count = 3;
+			for (int l = 0; l < 3; ++l) {
+				PLYVertex v = toPLYVertex((*faceVertices)[k + l]);
+				std::pair<std::unordered_map<PLYVertex, int, PLYVertexHash>::iterator, bool> result = vertexIds.insert(std::make_pair(v, (int)vertices.size()));
+				if (result.second) vertices.push_back(v);
+				triangle.indices[l] = result.first->second + indexOffset;
+			}
+			triangles.push_back(triangle);
+		}
+	}
+}
+
+}
+
+/**
+ * Write the faces to the PLY file, and return false if it cannot be written.
+ */
+bool PLYWriter::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename) {
+	std::vector<PLYVertex> vertices;
+	std::vector<PLYFace> triangles;
+	toPLYRecords(faces, 0, vertices, triangles);
+
+	std::ostringstream numVertices;
+	std::ostringstream numFaces;
+	numVertices << vertices.size();
+	numFaces << triangles.size();
+	std::string text = header(numVertices.str(), numFaces.str());
+
+	// the records are written as they are in memory, which assumes a little-endian machine
+	std::ofstream file(filename, std::ios::binary);
+	file.write(text.c_str(), text.size());
+	if (!vertices.empty()) file.write((const char*)&vertices[0], sizeof(PLYVertex) * vertices.size());
+	if (!triangles.empty()) file.write((const char*)&triangles[0], sizeof(PLYFace) * triangles.size());
+	file.close();
+	return file.good();
+}
+
+PLYStreamWriter::PLYStreamWriter(const std::string& filename) : filename(filename), file(filename, std::ios::binary), faceFile(filename + ".faces", std::ios::binary), numVertices(0), numFaces(0), failed(false) {
+	// the counts are padded by spaces, which are overwritten by close()
+	std::string blank(COUNT_WIDTH, ' ');
+	std::string text = header(blank, blank);
+	vertexCountPos = text.find("element vertex ") + strlen("element vertex ");
+	faceCountPos = text.find("element face ") + strlen("element face ");
+	file.write(text.c_str(), text.size());
+}
+
+PLYStreamWriter::~PLYStreamWriter() {
+	close();
+}
+
+/**
+ * Append the faces of a batch, whose vertices are shared only within the batch.
+ */
+void PLYStreamWriter::write(const std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+	if (!file.is_open()) return;
+
+	std::vector<PLYVertex> vertices;
+	std::vector<PLYFace> triangles;
+	toPLYRecords(faces, numVertices, vertices, triangles);
+
+	if (!vertices.empty()) file.write((const char*)&vertices[0], sizeof(PLYVertex) * vertices.size());
+	if (!triangles.empty()) faceFile.write((const char*)&triangles[0], sizeof(PLYFace) * triangles.size());
+	numVertices += vertices.size();
+	numFaces += triangles.size();
+}
+
+/**
+ * Append the faces after the vertices, and fill in the counts in the header.
+ * If the output or the temporary file has failed, only the temporary file is removed and failed is set.
+ */
+void PLYStreamWriter::close() {
+	if (!file.is_open() && !faceFile.is_open()) return;
+
+	bool good = file.good() && faceFile.good();
+	faceFile.close();
+	good = good && !faceFile.fail();
+
+	if (good) {
+		std::ifstream in(filename + ".faces", std::ios::binary);
+		std::vector<char> block(1 << 20);
+		while (in) {
+			in.read(&block[0], block.size());
+			file.write(&block[0], in.gcount());
+		}
+		good = in.eof() && !in.bad();
+	}
+	std::remove((filename + ".faces").c_str());
+
+	if (good) {
+		std::ostringstream counts[2];
+		counts[0] << numVertices;
+		counts[1] << numFaces;
+		file.seekp(vertexCountPos);
+		file << counts[0].str();
+		file.seekp(faceCountPos);
+		file << counts[1].str();
+	}
+	file.close();
+	failed = !good || !file.good();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <glm/glm.hpp>
+#include "GLUtils.h"
+#include "GeometrySink.h"
+#include <boost/shared_ptr.hpp>
+
+/**
+ * Writer of binary little-endian PLY.
+ * The instances are expanded, and the identical vertices are shared among the triangles.
+ */
+class PLYWriter {
+protected:
+	PLYWriter() {}
+
+public:
+	static bool write(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const std::string& filename);
+};
+
+/**
+ * Writer of a binary PLY file that is appended batch by batch.
+ * The vertices are written to the file directly, and the faces to a temporary file, which is appended
+ * by close(). The counts in the header are left blank and filled in by close().
+ * failed is set by close() if any of the files cannot be written, and the temporary file is removed in any case.
+ */
+class PLYStreamWriter : public GeometrySink {
+private:
+	std::string filename;
+	std::ofstream file;
+	std::ofstream faceFile;
+	std::streamoff vertexCountPos;
+	std::streamoff faceCountPos;
+	int numVertices;
+	int numFaces;
+
+public:
+	bool failed;
+
+public:
+	PLYStreamWriter(const std::string& filename);
+	~PLYStreamWriter();
+
+	void write(const std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	void close();
+};
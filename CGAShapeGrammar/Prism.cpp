@@ -143,10 +143,12 @@ void Prism::split(int splitAxis, const std::vector<float>& sizes, const std::vec
 void Prism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	// top
 	if (_scope.z >= 0) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(0, 0, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(0, 0, _scope.z));
 		glutils::drawConcavePolygon(_points, glm::vec4(_color, opacity), mat, vertices);
 
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
@@ -155,7 +157,7 @@ void Prism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fac
 	// bottom
 	{
 		std::vector<Vertex> vertices;
-		glutils::drawConcavePolygon(_points, glm::vec4(_color, opacity), _pivot * _modelMat, vertices);
+		glutils::drawConcavePolygon(_points, glm::vec4(_color, opacity), shapeMat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 
@@ -163,16 +165,16 @@ void Prism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fac
 	{
 		glm::vec4 p1(_points.back(), 0, 1);
 		glm::vec4 p2(_points.back(), _scope.z, 1);
-		p1 = _pivot * _modelMat * p1;
-		p2 = _pivot * _modelMat * p2;
+		p1 = shapeMat * p1;
+		p2 = shapeMat * p2;
 
 		for (int i = 0; i < _points.size(); ++i) {
 			std::vector<Vertex> vertices;
 
 			glm::vec4 p3(_points[i], 0, 1);
 			glm::vec4 p4(_points[i], _scope.z, 1);
-			p3 = _pivot * _modelMat * p3;
-			p4 = _pivot * _modelMat * p4;
+			p3 = shapeMat * p3;
+			p4 = shapeMat * p4;
 
 			glm::vec3 normal = glm::normalize(glm::cross(glm::vec3(p3) - glm::vec3(p1), glm::vec3(p2) - glm::vec3(p1)));
 	
@@ -125,21 +125,23 @@ void Pyramid::setupProjection(int axesSelector, float texWidth, float texHeight)
 void Pyramid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	if (_top_ratio == 0.0f) {
 		std::vector<Vertex> vertices(_points.size() * 3);
 
 		glm::vec4 p0(_center, _height, 1);
-		p0 = _pivot * _modelMat * p0;
+		p0 = shapeMat * p0;
 
 		glm::vec4 p1(_points.back(), 0, 1);
-		p1 = _pivot * _modelMat * p1;
+		p1 = shapeMat * p1;
 
 		glm::vec2 t0(0.5, _height / _texHeight);
 		glm::vec2 t1(0, 0);
 
 		for (int i = 0; i < _points.size(); ++i) {
 			glm::vec4 p2(_points[i], 0, 1);
-			p2 = _pivot * _modelMat * p2;
+			p2 = shapeMat * p2;
 
 			glm::vec3 normal = glm::cross(glm::vec3(p1 - p0), glm::vec3(p2 - p0));
 
@@ -173,19 +175,19 @@ void Pyramid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& f
 		std::vector<Vertex> vertices(_points.size() * 6);
 
 		glm::vec4 p0(_points.back(), 0, 1);
-		p0 = _pivot * _modelMat * p0;
+		p0 = shapeMat * p0;
 
 		glm::vec4 p1(_points.back() * _top_ratio + _center * (1.0f - _top_ratio), _height, 1);
-		p1 = _pivot * _modelMat * p1;
+		p1 = shapeMat * p1;
 
 		std::vector<glm::vec3> pts3(_points.size());
 		for (int i = 0; i < _points.size(); ++i) {
 			glm::vec4 p2(_points[i], 0, 1);
-			p2 = _pivot * _modelMat * p2;
+			p2 = shapeMat * p2;
 
 			glm::vec4 p3(_points[i] * _top_ratio + _center * (1.0f - _top_ratio), _height, 1);
 			pts3[i] = glm::vec3(p3);
-			p3 = _pivot * _modelMat * p3;
+			p3 = shapeMat * p3;
 
 			glm::vec3 normal = glm::cross(glm::vec3(p2 - p0), glm::vec3(p3 - p0));
 
@@ -203,7 +205,7 @@ void Pyramid::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& f
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		glutils::drawPolygon(pts3, glm::vec4(_color, opacity), _pivot * _modelMat, vertices);
+		glutils::drawPolygon(pts3, glm::vec4(_color, opacity), shapeMat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 }
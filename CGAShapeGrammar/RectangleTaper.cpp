@@ -101,12 +101,14 @@ void RectangleTaper::size(float xSize, float ySize, float zSize, bool centered)
 void RectangleTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	float offset = _scope.z / tanf(_slope / 180.0f * M_PI);
 
 	// top face
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5f, _scope.y * 0.5f, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_scope.x * 0.5f, _scope.y * 0.5f, _scope.z));
 		glutils::drawQuad(_scope.x - offset * 2, _scope.y - offset * 2, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -114,7 +116,7 @@ void RectangleTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 	// side faces
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(_modelMat, _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(shapeMat, _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.x, 0));
@@ -126,7 +128,7 @@ void RectangleTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y, 0));
@@ -138,7 +140,7 @@ void RectangleTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y, 0)), M_PI, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y, 0)), M_PI, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.x, 0));
@@ -150,7 +152,7 @@ void RectangleTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Fac
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y, 0));
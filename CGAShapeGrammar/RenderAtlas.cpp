@@ -0,0 +1,66 @@
+#include "RenderAtlas.h"
+#include <cmath>
+
+RenderAtlas::RenderAtlas() : tileWidth(0), tileHeight(0), numTiles(0), columns(0), rows(0), gutter(0), fbo(0), colorBuffer(0) {
+}
+
+/**
+ * Create the frame buffer that holds numTiles tiles in a roughly square grid.
+ */
+void RenderAtlas::init(int tileWidth, int tileHeight, int numTiles, int gutter) {
+	release();
+
+	this->tileWidth = tileWidth;
+	this->tileHeight = tileHeight;
+	this->numTiles = numTiles;
+	this->gutter = gutter;
+	columns = (int)ceil(sqrt((double)numTiles));
+	rows = (numTiles + columns - 1) / columns;
+
+	GLint maxSize;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+	if (width() > maxSize || height() > maxSize) throw "The render atlas is too large.";
+
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width(), height());
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) throw "The render atlas is not complete.";
+}
+
+void RenderAtlas::release() {
+	if (fbo != 0) glDeleteFramebuffers(1, &fbo);
+	if (colorBuffer != 0) glDeleteRenderbuffers(1, &colorBuffer);
+	fbo = 0;
+	colorBuffer = 0;
+}
+
+/**
+ * Return the bottom-left corner of the tile in the frame buffer.
+ */
+void RenderAtlas::tileOrigin(int index, int& x, int& y) const {
+	x = gutter + (index % columns) * (tileWidth + gutter);
+	y = gutter + (index / columns) * (tileHeight + gutter);
+}
+
+/**
+ * Return the tile of the top-down image of the whole atlas, which shares the pixels with the image.
+ */
+cv::Mat RenderAtlas::tileImage(const cv::Mat& image, int index) const {
+	int x, y;
+	tileOrigin(index, x, y);
+	return image(cv::Rect(x, height() - y - tileHeight, tileWidth, tileHeight));
+}
+
+/**
+ * Return the prefix of the names of the objects in the tile for RenderManager::addFaces().
+ */
+QString RenderAtlas::group(int index) {
+	return QString("tile%1/").arg(index);
+}
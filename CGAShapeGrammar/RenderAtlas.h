@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glew.h>
+#include <QString>
+#include <opencv2/core/core.hpp>
+
+/**
+ * Offscreen render target that is divided into the tiles of the same size, so that many small images are
+ * rendered by a single sequence of the passes and read back at once.
+ * The tiles are laid out row by row from the bottom-left corner, and separated by the gutter of the background,
+ * so that the line filter does not pick up the neighboring tiles.
+ * The GL functions must be called while the GL context is current.
+ */
+class RenderAtlas {
+public:
+	int tileWidth;
+	int tileHeight;
+	int numTiles;
+	int columns;
+	int rows;
+	int gutter;
+	GLuint fbo;
+	GLuint colorBuffer;
+
+public:
+	RenderAtlas();
+
+	void init(int tileWidth, int tileHeight, int numTiles, int gutter = 2);
+	void release();
+	int width() const { return columns * (tileWidth + gutter) + gutter; }
+	int height() const { return rows * (tileHeight + gutter) + gutter; }
+	void tileOrigin(int index, int& x, int& y) const;
+	cv::Mat tileImage(const cv::Mat& image, int index) const;
+	static QString group(int index);
+};
@@ -0,0 +1,59 @@
+#include "RenderGraph.h"
+#include "RenderManager.h"
+
+namespace {
+
+/** buffers written to the color attachments by the geometry pass */
+const int GEOMETRY_OUTPUTS[4] = { RenderGraph::BUFFER_DIFFUSE, RenderGraph::BUFFER_NORMAL, RenderGraph::BUFFER_ORIGIN_POS, RenderGraph::BUFFER_INTENSITY };
+
+}
+
+RenderGraph::RenderGraph() : enabledPasses(NUM_PASSES, false), neededBuffers(0) {
+}
+
+/**
+ * Declare the passes of the rendering mode in the order of the execution, and prune them.
+ */
+RenderGraph::RenderGraph(int renderingMode, bool useShadow) : enabledPasses(NUM_PASSES, false), neededBuffers(0) {
+	dependencies.push_back(Dependency(PASS_SHADOW, 0, BUFFER_SHADOW_MAP));
+
+	// only the shading of the diffuse color and the light intensity uses the shadow map
+	dependencies.push_back(Dependency(PASS_GEOMETRY, useShadow ? BUFFER_SHADOW_MAP : 0, BUFFER_DIFFUSE | BUFFER_INTENSITY));
+	dependencies.push_back(Dependency(PASS_GEOMETRY, 0, BUFFER_NORMAL | BUFFER_ORIGIN_POS | BUFFER_DEPTH));
+
+	if (renderingMode == RenderManager::RENDERING_MODE_LINE) {
+		dependencies.push_back(Dependency(PASS_LINE, BUFFER_NORMAL | BUFFER_ORIGIN_POS | BUFFER_DEPTH, BUFFER_SCREEN));
+	}
+	else if (renderingMode == RenderManager::RENDERING_MODE_HATCHING) {
+		dependencies.push_back(Dependency(PASS_LINE, BUFFER_NORMAL | BUFFER_ORIGIN_POS | BUFFER_DEPTH | BUFFER_INTENSITY, BUFFER_SCREEN));
+	}
+	else if (renderingMode == RenderManager::RENDERING_MODE_SSAO) {
+		dependencies.push_back(Dependency(PASS_SSAO, BUFFER_DIFFUSE | BUFFER_NORMAL | BUFFER_ORIGIN_POS | BUFFER_DEPTH, BUFFER_AO));
+		dependencies.push_back(Dependency(PASS_BLUR, BUFFER_DIFFUSE | BUFFER_DEPTH | BUFFER_AO, BUFFER_SCREEN));
+	}
+	else {
+		dependencies.push_back(Dependency(PASS_BLUR, BUFFER_DIFFUSE | BUFFER_DEPTH, BUFFER_SCREEN));
+	}
+
+	prune();
+}
+
+/**
+ * Return the buffer that the geometry pass writes to the color attachment.
+ */
+int RenderGraph::geometryOutput(int attachment) {
+	return GEOMETRY_OUTPUTS[attachment];
+}
+
+/**
+ * Visit the dependencies backwards from the screen, and enable the passes whose outputs are needed.
+ */
+void RenderGraph::prune() {
+	neededBuffers = BUFFER_SCREEN;
+	for (int i = dependencies.size() - 1; i >= 0; --i) {
+		if ((dependencies[i].outputs & neededBuffers) == 0) continue;
+
+		enabledPasses[dependencies[i].pass] = true;
+		neededBuffers |= dependencies[i].inputs;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * Graph of the render passes for a rendering mode.
+ * Each pass declares which of its outputs are computed from which inputs, and the mode declares the pass that
+ * presents the screen, so that the passes and the outputs that do not contribute to the screen are pruned.
+ * For instance, the line rendering uses neither the shadow map nor the diffuse color.
+ */
+class RenderGraph {
+public:
+	static enum { BUFFER_SHADOW_MAP = 1, BUFFER_DIFFUSE = 2, BUFFER_NORMAL = 4, BUFFER_ORIGIN_POS = 8, BUFFER_INTENSITY = 16, BUFFER_DEPTH = 32, BUFFER_AO = 64, BUFFER_SCREEN = 128 };
+	static enum { PASS_SHADOW = 0, PASS_GEOMETRY, PASS_SSAO, PASS_LINE, PASS_BLUR, NUM_PASSES };
+
+	/** the outputs of the pass computed from the inputs */
+	struct Dependency {
+		int pass;
+		int inputs;
+		int outputs;
+
+		Dependency(int pass, int inputs, int outputs) : pass(pass), inputs(inputs), outputs(outputs) {}
+	};
+
+public:
+	std::vector<Dependency> dependencies;
+	std::vector<bool> enabledPasses;
+	int neededBuffers;
+
+public:
+	RenderGraph();
+	RenderGraph(int renderingMode, bool useShadow);
+
+	bool isEnabled(int pass) const { return enabledPasses[pass]; }
+	bool isNeeded(int buffer) const { return (neededBuffers & buffer) != 0; }
+	static int geometryOutput(int attachment);
+
+private:
+	void prune();
+};
@@ -4,29 +4,88 @@
 #include <QImage>
 #include <QGLWidget>
 #include <sstream>
+#include "ThreadPool.h"
 
 GeometryObject::GeometryObject() {
-	vaoCreated = false;
-	vaoOutdated = true;
+	numExternalVertices = 0;
+	first = 0;
+	generation = -1;
+	outdated = true;
 }
 
 GeometryObject::GeometryObject(const std::vector<Vertex>& vertices, bool lighting) {
 	this->vertices = vertices;
 	this->lighting = lighting;
-	vaoCreated = false;
-	vaoOutdated = true;
+	numExternalVertices = 0;
+	first = 0;
+	generation = -1;
+	outdated = true;
 }
 
 void GeometryObject::addVertices(const std::vector<Vertex>& vertices) {
 	this->vertices.insert(this->vertices.end(), vertices.begin(), vertices.end());
+	outdated = true;
+}
+
+void GeometryObject::addExternalVertices(const Vertex* vertices, int numVertices) {
+	externalVertices.push_back(std::make_pair(vertices, numVertices));
+	numExternalVertices += numVertices;
+	outdated = true;
+}
+
+/**
+ * Remove the vertices, but keep the allocated memory for the next scene.
+ */
+void GeometryObject::clear() {
+	vertices.clear();
+	externalVertices.clear();
+	numExternalVertices = 0;
+	outdated = true;
+}
+
+/**
+ * Copy the vertices and then the external vertices to the geometry buffer if they are changed or the buffer has grown since the last upload.
+ */
+void GeometryObject::upload(GeometryBuffer& buffer) {
+	if (!outdated && generation == buffer.getGeneration()) return;
+
+	first = buffer.allocate(size());
+	buffer.write(first, vertices.data(), vertices.size());
+	int next = first + vertices.size();
+	for (int i = 0; i < externalVertices.size(); ++i) {
+		buffer.write(next, externalVertices[i].first, externalVertices[i].second);
+		next += externalVertices[i].second;
+	}
+
+	// the buffer may have grown by this upload
+	generation = buffer.getGeneration();
+	outdated = false;
+}
+
+InstancedGeometryObject::InstancedGeometryObject() {
+	instanceCapacity = 0;
+	vaoCreated = false;
+	vaoOutdated = true;
+}
+
+InstancedGeometryObject::InstancedGeometryObject(const boost::shared_ptr<const glutils::Mesh>& mesh, bool lighting) {
+	this->mesh = mesh;
+	this->lighting = lighting;
+	instanceCapacity = 0;
+	vaoCreated = false;
+	vaoOutdated = true;
+}
+
+void InstancedGeometryObject::addInstance(const glutils::Face& face) {
+	instances.push_back(InstanceData(face));
 	vaoOutdated = true;
 }
 
 /**
- * Create VAO according to the vertices.
+ * Create VAO that has the shared mesh as the per-vertex attributes and the instances as the per-instance attributes.
+ * The mesh is immutable, so only the instance buffer is updated afterwards, and it is reallocated only when it grows.
  */
-void GeometryObject::createVAO() {
-	// VAOが作成済みで、最新なら、何もしないで終了
+void InstancedGeometryObject::createVAO() {
 	if (vaoCreated && !vaoOutdated) return;
 
 	if (!vaoCreated) {
@@ -34,38 +93,68 @@ void GeometryObject::createVAO() {
 		glGenVertexArrays(1, &vao);
 		glBindVertexArray(vao);
 
-		// create VBO and tranfer the vertices data to GPU buffer
+		// create VBO and tranfer the mesh data to GPU buffer
 		glGenBuffers(1, &vbo);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mesh->vertices.size(), mesh->vertices.data(), GL_STATIC_DRAW);
+		GeometryBuffer::setVertexAttributes();
+
+		// create VBO for the instances
+		glGenBuffers(1, &instanceVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+		for (int i = 0; i < 4; ++i) {
+			glEnableVertexAttribArray(5 + i);
+			glVertexAttribPointer(5 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, modelMat) + sizeof(glm::vec4) * i));
+			glVertexAttribDivisor(5 + i, 1);
+		}
+		glEnableVertexAttribArray(9);
+		glVertexAttribPointer(9, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, color));
+		glVertexAttribDivisor(9, 1);
+		glEnableVertexAttribArray(10);
+		glVertexAttribPointer(10, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, uvTransform));
+		glVertexAttribDivisor(10, 1);
+		glEnableVertexAttribArray(11);
+		glVertexAttribPointer(11, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, uvFromPosition));
+		glVertexAttribDivisor(11, 1);
 
 		vaoCreated = true;
 	} else {
 		glBindVertexArray(vao);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
 	}
 
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	if (instances.size() > instanceCapacity) {
+		instanceCapacity = instances.size();
+		glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData) * instances.size(), instances.data(), GL_DYNAMIC_DRAW);
+	}
+	else if (!instances.empty()) {
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(InstanceData) * instances.size(), instances.data());
+	}
 
-	// configure the attributes in the vao
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, drawEdge));
-		
 	// unbind the vao
-	glBindVertexArray(0); 
+	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	vaoOutdated = false;
 }
 
+/**
+ * Resolve the locations of the uniforms of the program. The uniforms that the program does not use are -1, which glUniform*() ignores.
+ */
+ObjectUniforms::ObjectUniforms(GLuint program) {
+	mvpMatrix = glGetUniformLocation(program, "mvpMatrix");
+	textureEnabled = glGetUniformLocation(program, "textureEnabled");
+	tex0 = glGetUniformLocation(program, "tex0");
+	lighting = glGetUniformLocation(program, "lighting");
+	useShadow = glGetUniformLocation(program, "useShadow");
+	softShadow = glGetUniformLocation(program, "softShadow");
+	instanced = glGetUniformLocation(program, "instanced");
+}
+
 RenderManager::RenderManager() {
+	shadowMapOutdated = true;
+
 	//ssao
 	uKernelSize = 64;// 16;
 	uRadius = 1;// 17.0f;
@@ -78,6 +167,7 @@ RenderManager::~RenderManager() {
 	//delete
 	glDeleteVertexArrays(1,&secondPassVBO);
 	glDeleteVertexArrays(1,&secondPassVAO);
+	geometryBuffer.release();
 }
 
 void RenderManager::init(const std::string& vertex_file, const std::string& geometry_file, const std::string& fragment_file, bool useShadow, int shadowMapSize) {
@@ -140,6 +230,9 @@ void RenderManager::init(const std::string& vertex_file, const std::string& geom
 	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
 
 	glBindVertexArray(0);
+
+	geometryBuffer.init();
+
 	// fragm
 	fragDataFB=INT_MAX;
 	
@@ -345,52 +438,100 @@ void RenderManager::resizeSsaoKernel() {
 }//
 
 
-void RenderManager::addFaces(const std::vector<boost::shared_ptr<glutils::Face> >& faces) {
+/**
+ * Add the faces as the objects of their names, which are prefixed by the group so that renderGroup() can draw them separately.
+ */
+void RenderManager::addFaces(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const QString& group) {
 	for (int i = 0; i < faces.size(); ++i) {
-		addObject(faces[i]->name.c_str(), faces[i]->texture.c_str(), faces[i]->vertices, true);
+		if (faces[i]->isInstance()) {
+			addInstance(group + faces[i]->name.c_str(), faces[i]->texture.c_str(), *faces[i], true);
+		} else {
+			addObject(group + faces[i]->name.c_str(), faces[i]->texture.c_str(), faces[i]->vertices, true);
+		}
 	}
 }
 
 void RenderManager::addObject(const QString& object_name, const QString& texture_file, const std::vector<Vertex>& vertices, bool lighting) {
-	GLuint texId;
-	
-	if (texture_file.length() > 0) {
-		// テクスチャファイルがまだ読み込まれていない場合は、ロードする
-		if (!textures.contains(texture_file)) {
-			texId = loadTexture(texture_file);
-			textures[texture_file] = texId;
-		} else {
-			texId = textures[texture_file];
-		}
-	} else {
-		texId = 0;
+	GLuint texId = getTexture(texture_file);
+
+	if (!objects[object_name].contains(texId)) {
+		GeometryObject object;
+		object.lighting = lighting;
+		objects[object_name][texId] = object;
 	}
+	objects[object_name][texId].addVertices(vertices);
+}
 
-	if (objects.contains(object_name)) {
-		if (objects[object_name].contains(texId)) {
-			objects[object_name][texId].addVertices(vertices);
-		} else {
-			objects[object_name][texId] = GeometryObject(vertices, lighting);
-		}
-	} else {
-		objects[object_name][texId] = GeometryObject(vertices, lighting);
+/**
+ * Add the vertices from the memory of the caller, e.g., a slot of GeometryRing, without copying them.
+ * They are copied to the geometry buffer directly when they are rendered, so that they must be valid until removeObjects().
+ * centerObjects() does not move them.
+ */
+void RenderManager::addObject(const QString& object_name, const QString& texture_file, const Vertex* vertices, int numVertices, bool lighting) {
+	GLuint texId = getTexture(texture_file);
+
+	if (!objects[object_name].contains(texId)) {
+		GeometryObject object;
+		object.lighting = lighting;
+		objects[object_name][texId] = object;
 	}
+	objects[object_name][texId].addExternalVertices(vertices, numVertices);
 }
 
+/**
+ * Add an instance of the shared mesh. The instances of the same mesh and texture are drawn by a single draw call.
+ */
+void RenderManager::addInstance(const QString& object_name, const QString& texture_file, const glutils::Face& face, bool lighting) {
+	GLuint texId = getTexture(texture_file);
+
+	// register the name so that renderAll() visits this object
+	if (!objects.contains(object_name)) {
+		objects[object_name] = QMap<GLuint, GeometryObject>();
+	}
+
+	std::pair<GLuint, const glutils::Mesh*> key(texId, face.mesh.get());
+	std::map<std::pair<GLuint, const glutils::Mesh*>, InstancedGeometryObject>& instanced = instancedObjects[object_name];
+	if (instanced.find(key) == instanced.end()) {
+		instanced[key] = InstancedGeometryObject(face.mesh, lighting);
+	}
+	instanced[key].addInstance(face);
+}
+
+/**
+ * Remove the geometry of all the objects for the next scene, and move to the next region of the geometry buffer.
+ * The objects are emptied instead of deleted, so that the next scene of the same names reuses them without creating GL objects.
+ */
 void RenderManager::removeObjects() {
 	for (auto it = objects.begin(); it != objects.end(); ++it) {
 		removeObject(it.key());
 	}
-	objects.clear();
+	geometryBuffer.reset();
 }
 
 void RenderManager::removeObject(const QString& object_name) {
 	for (auto it = objects[object_name].begin(); it != objects[object_name].end(); ++it) {
-		glDeleteBuffers(1, &it->vbo);
-		glDeleteVertexArrays(1, &it->vao);
+		it->clear();
 	}
 
-	objects[object_name].clear();
+	if (instancedObjects.contains(object_name)) {
+		std::map<std::pair<GLuint, const glutils::Mesh*>, InstancedGeometryObject>& instanced = instancedObjects[object_name];
+		for (auto it = instanced.begin(); it != instanced.end(); ) {
+			// the mesh that is no longer cached will not be used again
+			if (it->second.mesh.use_count() == 1) {
+				if (it->second.vaoCreated) {
+					glDeleteBuffers(1, &it->second.vbo);
+					glDeleteBuffers(1, &it->second.instanceVbo);
+					glDeleteVertexArrays(1, &it->second.vao);
+				}
+				it = instanced.erase(it);
+			}
+			else {
+				it->second.instances.clear();
+				it->second.vaoOutdated = true;
+				++it;
+			}
+		}
+	}
 }
 
 void RenderManager::centerObjects() {
@@ -410,6 +551,19 @@ void RenderManager::centerObjects() {
 			}
 		}
 	}
+	for (auto it = instancedObjects.begin(); it != instancedObjects.end(); ++it) {
+		for (auto it2 = it.value().begin(); it2 != it.value().end(); ++it2) {
+			const glutils::BoundingBox& bbox = it2->second.mesh->bbox;
+			for (int k = 0; k < it2->second.instances.size(); ++k) {
+				for (int l = 0; l < 8; ++l) {
+					glm::vec3 p((l & 1) ? bbox.maxPt.x : bbox.minPt.x, (l & 2) ? bbox.maxPt.y : bbox.minPt.y, (l & 4) ? bbox.maxPt.z : bbox.minPt.z);
+					p = glm::vec3(it2->second.instances[k].modelMat * glm::vec4(p, 1));
+					minPt = glm::min(minPt, p);
+					maxPt = glm::max(maxPt, p);
+				}
+			}
+		}
+	}
 
 	glm::vec3 center = (maxPt + minPt) * 0.5f;
 
@@ -422,88 +576,276 @@ void RenderManager::centerObjects() {
 			for (int k = 0; k < it2->vertices.size(); ++k) {
 				it2->vertices[k].position = (it2->vertices[k].position - center) * scale;
 			}
+			it2->outdated = true;
+		}
+	}
+	glm::mat4 centerMat = glm::translate(glm::scale(glm::mat4(), glm::vec3(scale, scale, scale)), -center);
+	for (auto it = instancedObjects.begin(); it != instancedObjects.end(); ++it) {
+		for (auto it2 = it.value().begin(); it2 != it.value().end(); ++it2) {
+			for (int k = 0; k < it2->second.instances.size(); ++k) {
+				it2->second.instances[k].modelMat = centerMat * it2->second.instances[k].modelMat;
+			}
+			it2->second.vaoOutdated = true;
 		}
 	}
 }
 
 void RenderManager::renderAll() {
+	std::vector<QString> object_names;
 	for (auto it = objects.begin(); it != objects.end(); ++it) {
-		render(it.key());
+		object_names.push_back(it.key());
 	}
+	render(object_names, std::vector<RenderView>());
 }
 
 void RenderManager::renderAllExcept(const QString& object_name) {
+	std::vector<QString> object_names;
 	for (auto it = objects.begin(); it != objects.end(); ++it) {
 		if (it.key() == object_name) continue;
 
-		render(it.key());
+		object_names.push_back(it.key());
+	}
+	render(object_names, std::vector<RenderView>());
+}
+
+/**
+ * Render the objects whose names start with the group into all the views by the first pass.
+ * Each batch is bound once, and only the viewport and the matrix are changed for each view.
+ */
+void RenderManager::renderGroup(const QString& group, const std::vector<RenderView>& views) {
+	std::vector<QString> object_names;
+	for (auto it = objects.lowerBound(group); it != objects.end() && it.key().startsWith(group); ++it) {
+		object_names.push_back(it.key());
 	}
+	render(object_names, views);
 }
 
 void RenderManager::render(const QString& object_name) {
-	for (auto it = objects[object_name].begin(); it != objects[object_name].end(); ++it) {
-		GLuint texId = it.key();
-		
-		// vaoを作成
-		it->createVAO();
-
-		if (texId > 0) {
-			// テクスチャなら、バインドする
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, texId);
-			glUniform1i(glGetUniformLocation(programs["pass1"], "textureEnabled"), 1);
-			glUniform1i(glGetUniformLocation(programs["pass1"], "tex0"), 0);
-		} else {
-			glUniform1i(glGetUniformLocation(programs["pass1"], "textureEnabled"), 0);
+	render(std::vector<QString>(1, object_name), std::vector<RenderView>());
+}
+
+/**
+ * Render the objects into each view, or with the current viewport and matrix if no view is given.
+ * The objects of the same texture and lighting are drawn from the geometry buffer by a single glMultiDrawArrays(),
+ * so that the number of the draw calls and the uniform updates depends on the number of the textures instead of the objects.
+ */
+void RenderManager::render(const std::vector<QString>& object_names, const std::vector<RenderView>& views) {
+	const ObjectUniforms& uniforms = currentUniforms();
+
+	// upload all the objects again if the buffer has grown meanwhile
+	int generation;
+	do {
+		generation = geometryBuffer.getGeneration();
+		for (int i = 0; i < object_names.size(); ++i) {
+			QMap<GLuint, GeometryObject>& textureObjects = objects[object_names[i]];
+			for (auto it = textureObjects.begin(); it != textureObjects.end(); ++it) {
+				if (it->size() > 0) it->upload(geometryBuffer);
+			}
 		}
+	} while (generation != geometryBuffer.getGeneration());
 
-		if (it->lighting) {
-			glUniform1i(glGetUniformLocation(programs["pass1"], "lighting"), 1);
+	for (auto it = batches.begin(); it != batches.end(); ++it) {
+		it->second.firsts.clear();
+		it->second.counts.clear();
+	}
+	for (int i = 0; i < object_names.size(); ++i) {
+		QMap<GLuint, GeometryObject>& textureObjects = objects[object_names[i]];
+		for (auto it = textureObjects.begin(); it != textureObjects.end(); ++it) {
+			if (it->size() == 0) continue;
+
+			DrawBatch& batch = batches[std::make_pair(it.key(), it->lighting)];
+			batch.firsts.push_back(it->first);
+			batch.counts.push_back(it->size());
 		}
-		else {
-			glUniform1i(glGetUniformLocation(programs["pass1"], "lighting"), 0);
+	}
+
+	// 描画
+	glBindVertexArray(geometryBuffer.getVAO());
+	for (auto it = batches.begin(); it != batches.end(); ++it) {
+		if (it->second.counts.empty()) continue;
+
+		setUniforms(uniforms, it->first.first, it->first.second, false);
+
+		if (views.empty()) {
+			glMultiDrawArrays(GL_TRIANGLES, &it->second.firsts[0], &it->second.counts[0], it->second.counts.size());
+		}
+		for (int i = 0; i < views.size(); ++i) {
+			setView(uniforms, views[i]);
+			glMultiDrawArrays(GL_TRIANGLES, &it->second.firsts[0], &it->second.counts[0], it->second.counts.size());
 		}
+	}
+	glBindVertexArray(0);
+
+	// the instances of a mesh and a texture are already drawn by a single call
+	for (int i = 0; i < object_names.size(); ++i) {
+		if (!instancedObjects.contains(object_names[i])) continue;
+
+		std::map<std::pair<GLuint, const glutils::Mesh*>, InstancedGeometryObject>& instanced = instancedObjects[object_names[i]];
+		for (auto it = instanced.begin(); it != instanced.end(); ++it) {
+			if (it->second.instances.empty()) continue;
+
+			GLuint texId = it->first.first;
+
+			it->second.createVAO();
+
+			setUniforms(uniforms, texId, it->second.lighting, true);
 
-		if (useShadow) {
-			glUniform1i(glGetUniformLocation(programs["pass1"], "useShadow"), 1);
-			if (softShadow) {
-				glUniform1i(glGetUniformLocation(programs["pass1"], "softShadow"), 1);
+			glBindVertexArray(it->second.vao);
+			if (views.empty()) {
+				glDrawArraysInstanced(GL_TRIANGLES, 0, it->second.mesh->vertices.size(), it->second.instances.size());
 			}
-			else {
-				glUniform1i(glGetUniformLocation(programs["pass1"], "softShadow"), 0);
+			for (int j = 0; j < views.size(); ++j) {
+				setView(uniforms, views[j]);
+				glDrawArraysInstanced(GL_TRIANGLES, 0, it->second.mesh->vertices.size(), it->second.instances.size());
 			}
-		} else {
-			glUniform1i(glGetUniformLocation(programs["pass1"], "useShadow"), 0);
+
+			glBindVertexArray(0);
 		}
+	}
+}
+
+void RenderManager::setView(const ObjectUniforms& uniforms, const RenderView& view) {
+	glViewport(view.x, view.y, view.width, view.height);
+	glUniformMatrix4fv(uniforms.mvpMatrix, 1, false, &view.mvpMatrix[0][0]);
+}
 
-		// 描画
-		glBindVertexArray(it->vao);
-		glDrawArrays(GL_TRIANGLES, 0, it->vertices.size());
+/**
+ * Return the uniform locations of the current program, which are resolved at the first use of the program.
+ * Both of the pass1 and shadow programs draw the objects.
+ */
+const ObjectUniforms& RenderManager::currentUniforms() {
+	GLint program;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
 
-		glBindVertexArray(0);
+	std::map<GLuint, ObjectUniforms>::iterator it = objectUniforms.find(program);
+	if (it == objectUniforms.end()) {
+		it = objectUniforms.insert(std::make_pair((GLuint)program, ObjectUniforms(program))).first;
 	}
+	return it->second;
+}
+
+void RenderManager::setUniforms(const ObjectUniforms& uniforms, GLuint texId, bool lighting, bool instanced) {
+	if (texId > 0) {
+		// テクスチャなら、バインドする
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, texId);
+		glUniform1i(uniforms.textureEnabled, 1);
+		glUniform1i(uniforms.tex0, 0);
+	} else {
+		glUniform1i(uniforms.textureEnabled, 0);
+	}
+
+	if (lighting) {
+		glUniform1i(uniforms.lighting, 1);
+	}
+	else {
+		glUniform1i(uniforms.lighting, 0);
+	}
+
+	if (graph.isEnabled(RenderGraph::PASS_SHADOW)) {
+		glUniform1i(uniforms.useShadow, 1);
+		if (softShadow) {
+			glUniform1i(uniforms.softShadow, 1);
+		}
+		else {
+			glUniform1i(uniforms.softShadow, 0);
+		}
+	} else {
+		glUniform1i(uniforms.useShadow, 0);
+	}
+
+	glUniform1i(uniforms.instanced, instanced ? 1 : 0);
 }
 
+/**
+ * Update the shadow map if the current rendering mode uses it, or otherwise mark it outdated,
+ * so that it is updated when the rendering mode is changed.
+ */
 void RenderManager::updateShadowMap(GLWidget3D* glWidget3D, const glm::vec3& light_dir, const glm::mat4& light_mvpMatrix) {
-	if (useShadow) {
+	updateRenderGraph();
+	if (graph.isEnabled(RenderGraph::PASS_SHADOW)) {
 		shadow.update(glWidget3D, light_dir, light_mvpMatrix);
+		shadowMapOutdated = false;
+	}
+	else {
+		shadowMapOutdated = true;
 	}
 }
 
-GLuint RenderManager::loadTexture(const QString& filename) {
-	QImage img;
-	if (!img.load(filename)) {
-		std::stringstream ss;
-		ss << "load texture failed : " << filename.toUtf8().constData();
-		std::cout << ss.str() << std::endl;
-		throw ss.str();
+void RenderManager::updateRenderGraph() {
+	graph = RenderGraph(renderingMode, useShadow);
+}
+
+/**
+ * Bind the frame buffer of the geometry pass, where the outputs that the current rendering mode does not use are discarded.
+ */
+void RenderManager::bindGeometryBuffers() {
+	glBindFramebuffer(GL_FRAMEBUFFER, fragDataFB);
+
+	GLenum drawBuffers[4];
+	for (int i = 0; i < 4; ++i) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, fragDataTex[i], 0);
+		drawBuffers[i] = graph.isNeeded(RenderGraph::geometryOutput(i)) ? GL_COLOR_ATTACHMENT0 + i : GL_NONE;
+	}
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, fragDepthTex, 0);
+	glDrawBuffers(4, drawBuffers);
+
+	// Always check that our framebuffer is ok
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		printf("+ERROR: GL_FRAMEBUFFER_COMPLETE false\n");
+		exit(0);
 	}
+}
+
+/**
+ * Return the texture id, which is 0 if texture_file is empty. The texture is loaded when it is used for the first time.
+ */
+GLuint RenderManager::getTexture(const QString& texture_file) {
+	if (texture_file.length() == 0) return 0;
 
+	// テクスチャファイルがまだ読み込まれていない場合は、ロードする
+	if (!textures.contains(texture_file)) {
+		textures[texture_file] = loadTexture(texture_file);
+	}
+	return textures[texture_file];
+}
+
+/**
+ * Decode the texture files that are not loaded yet on the thread pool.
+ * Only the decoding is done by the workers, and the images are uploaded to GPU by getTexture() in the GL thread.
+ * The errors are ignored here, and they are reported when the texture is used.
+ */
+void RenderManager::preloadTextures(const std::set<std::string>& texture_files, ThreadPool& pool) {
+	for (auto it = texture_files.begin(); it != texture_files.end(); ++it) {
+		QString filename = QString::fromStdString(*it);
+		if (filename.isEmpty() || textures.contains(filename)) continue;
+		{
+			std::lock_guard<std::mutex> lock(decodedTexturesMutex);
+			if (decodedTextures.contains(filename)) continue;
+		}
+
+		pool.enqueue([this, filename]() {
+			QImage image;
+			if (decodeTexture(filename, image)) {
+				std::lock_guard<std::mutex> lock(decodedTexturesMutex);
+				decodedTextures[filename] = image;
+			}
+		});
+	}
+}
+
+GLuint RenderManager::loadTexture(const QString& filename) {
 	QImage GL_formatted_image;
-	GL_formatted_image = QGLWidget::convertToGLFormat(img);
-	if (GL_formatted_image.isNull()) {
+	{
+		std::lock_guard<std::mutex> lock(decodedTexturesMutex);
+		if (decodedTextures.contains(filename)) {
+			GL_formatted_image = decodedTextures.take(filename);
+		}
+	}
+
+	if (GL_formatted_image.isNull() && !decodeTexture(filename, GL_formatted_image)) {
 		std::stringstream ss;
-		ss << "Failed to convert to gl format : " << filename.toUtf8().constData();
+		ss << "load texture failed : " << filename.toUtf8().constData();
 		std::cout << ss.str() << std::endl;
 		throw ss.str();
 	}
@@ -523,6 +865,17 @@ GLuint RenderManager::loadTexture(const QString& filename) {
 	return texture;
 }
 
+/**
+ * Load the image file and convert it to the GL format. This does not use GL, so that it can be called by any thread.
+ */
+bool RenderManager::decodeTexture(const QString& filename, QImage& image) {
+	QImage img;
+	if (!img.load(filename)) return false;
+
+	image = QGLWidget::convertToGLFormat(img);
+	return !image.isNull();
+}
+
 GLuint RenderManager::load3DTexture(const std::vector<QString> & pathes) {
 	GLsizei width, height, depth = (GLsizei)pathes.size();
 
@@ -8,24 +8,113 @@
 #include "GLUtils.h"
 #include <boost/shared_ptr.hpp>
 #include "Shader.h"
+#include "RenderGraph.h"
+#include "GeometryBuffer.h"
 #include <map>
+#include <set>
+#include <mutex>
+#include <QImage>
 
+class ThreadPool;
+
+/**
+ * Vertices of an object and a texture, which are drawn from their range in the shared GeometryBuffer.
+ * The external vertices are owned by the caller, e.g., a slot of GeometryRing, and they are copied
+ * from there to the geometry buffer directly.
+ */
 class GeometryObject {
 public:
-	GLuint vao;
-	GLuint vbo;
 	std::vector<Vertex> vertices;
+	/** vertices that are not copied to the object, which must be valid until the object is cleared */
+	std::vector<std::pair<const Vertex*, int> > externalVertices;
+	int numExternalVertices;
 	bool lighting;
-	bool vaoCreated;
-	bool vaoOutdated;
+	/** index of the first vertex in the geometry buffer, which is valid while the generation of the buffer does not change */
+	int first;
+	int generation;
+	bool outdated;
 
 public:
 	GeometryObject();
 	GeometryObject(const std::vector<Vertex>& vertices, bool lighting = true);
 	void addVertices(const std::vector<Vertex>& vertices);
+	void addExternalVertices(const Vertex* vertices, int numVertices);
+	int size() const { return vertices.size() + numExternalVertices; }
+	void clear();
+	void upload(GeometryBuffer& buffer);
+};
+
+/**
+ * Per-instance attributes of the instanced draw, which are bound to the locations 5 to 11.
+ */
+struct InstanceData {
+	glm::mat4 modelMat;
+	glm::vec4 color;
+	glm::vec4 uvTransform;
+	float uvFromPosition;
+
+	InstanceData(const glutils::Face& face) : modelMat(face.modelMat), color(face.color), uvTransform(face.uvTransform), uvFromPosition(face.uvFromPosition ? 1.0f : 0.0f) {}
+};
+
+/**
+ * A shared mesh uploaded once, and drawn for all the instances by a single instanced draw call.
+ */
+class InstancedGeometryObject {
+public:
+	GLuint vao;
+	GLuint vbo;
+	GLuint instanceVbo;
+	/** the number of the instances that the instance buffer can hold */
+	int instanceCapacity;
+	boost::shared_ptr<const glutils::Mesh> mesh;
+	std::vector<InstanceData> instances;
+	bool lighting;
+	bool vaoCreated;
+	bool vaoOutdated;
+
+public:
+	InstancedGeometryObject();
+	InstancedGeometryObject(const boost::shared_ptr<const glutils::Mesh>& mesh, bool lighting = true);
+	void addInstance(const glutils::Face& face);
 	void createVAO();
 };
 
+/**
+ * Viewport and model view projection matrix of a view, which renderGroup() draws the objects into.
+ */
+struct RenderView {
+	int x;
+	int y;
+	int width;
+	int height;
+	glm::mat4 mvpMatrix;
+
+	RenderView(int x, int y, int width, int height, const glm::mat4& mvpMatrix) : x(x), y(y), width(width), height(height), mvpMatrix(mvpMatrix) {}
+};
+
+/**
+ * Locations of the uniforms that are set for each batch of the objects, which are resolved once per program.
+ */
+struct ObjectUniforms {
+	GLint mvpMatrix;
+	GLint textureEnabled;
+	GLint tex0;
+	GLint lighting;
+	GLint useShadow;
+	GLint softShadow;
+	GLint instanced;
+
+	ObjectUniforms(GLuint program);
+};
+
+/**
+ * Ranges of the geometry buffer that have the same texture and lighting, and are drawn by a single glMultiDrawArrays().
+ */
+struct DrawBatch {
+	std::vector<GLint> firsts;
+	std::vector<GLsizei> counts;
+};
+
 class RenderManager {
 public:
 	static enum { RENDERING_MODE_BASIC = 0, RENDERING_MODE_SSAO, RENDERING_MODE_LINE, RENDERING_MODE_HATCHING, RENDERING_MODE_SKETCHY };
@@ -34,8 +123,17 @@ public:
 	Shader shader;
 	std::map<std::string, GLuint> programs;
 
+	/** the objects are kept and reused by the next scene after removeObjects() */
 	QMap<QString, QMap<GLuint, GeometryObject> > objects;
+	QMap<QString, std::map<std::pair<GLuint, const glutils::Mesh*>, InstancedGeometryObject> > instancedObjects;
 	QMap<QString, GLuint> textures;
+	GeometryBuffer geometryBuffer;
+	/** batches of the objects drawn by render() keyed by the texture and the lighting, whose arrays are reused */
+	std::map<std::pair<GLuint, bool>, DrawBatch> batches;
+	std::map<GLuint, ObjectUniforms> objectUniforms;
+	/** decoded images of the preloaded textures, which are waiting to be uploaded to GPU */
+	QMap<QString, QImage> decodedTextures;
+	std::mutex decodedTexturesMutex;
 
 	bool useShadow;
 	bool softShadow;
@@ -43,6 +141,9 @@ public:
 	GLuint hatchingTextures;
 
 	int renderingMode;
+	/** passes of the current rendering mode, which is updated by updateRenderGraph() */
+	RenderGraph graph;
+	bool shadowMapOutdated;
 
 	// SSAO
 	std::vector<QString> fragDataNamesP1;//Multi target fragmebuffer names P1
@@ -75,19 +176,31 @@ public:
 	void resize(int width,int height);
 	void resizeSsaoKernel();
 
-	void addFaces(const std::vector<boost::shared_ptr<glutils::Face> >& faces);
+	void addFaces(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const QString& group = QString());
 	void addObject(const QString& object_name, const QString& texture_file, const std::vector<Vertex>& vertices, bool lighting);
+	void addObject(const QString& object_name, const QString& texture_file, const Vertex* vertices, int numVertices, bool lighting);
+	void addInstance(const QString& object_name, const QString& texture_file, const glutils::Face& face, bool lighting);
 	void removeObjects();
 	void removeObject(const QString& object_name);
 	void centerObjects();
 	void renderAll();
 	void renderAllExcept(const QString& object_name);
+	void renderGroup(const QString& group, const std::vector<RenderView>& views);
 	void render(const QString& object_name);
 	void updateShadowMap(GLWidget3D* glWidget3D, const glm::vec3& light_dir, const glm::mat4& light_mvpMatrix);
+	void updateRenderGraph();
+	void bindGeometryBuffers();
+	void preloadTextures(const std::set<std::string>& texture_files, ThreadPool& pool);
 	
 
 private:
+	void render(const std::vector<QString>& object_names, const std::vector<RenderView>& views);
+	void setView(const ObjectUniforms& uniforms, const RenderView& view);
+	const ObjectUniforms& currentUniforms();
+	GLuint getTexture(const QString& texture_file);
+	void setUniforms(const ObjectUniforms& uniforms, GLuint texId, bool lighting, bool instanced);
 	GLuint loadTexture(const QString& filename);
+	static bool decodeTexture(const QString& filename, QImage& image);
 	GLuint load3DTexture(const std::vector<QString> & pathes);
 };
 
@@ -1,6 +1,8 @@
 #include "SemiCircle.h"
 #include "CGA.h"
 #include "GLUtils.h"
+#include "LODPolicy.h"
+#include "UnitMeshCache.h"
 
 namespace cga {
 
@@ -42,32 +44,8 @@ void SemiCircle::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >
 
 	std::vector<Vertex> vertices;
 
-	glm::vec3 p0 = glm::vec3(_pivot * _modelMat * glm::vec4(_scope.x * 0.5, 0, 0, 1));
-
-	glm::vec3 normal = glm::vec3(_pivot * _modelMat * glm::vec4(0, 0, 1, 0));
-
-	int numSlices = 12;
-	for (int i = 0; i < numSlices; ++i) {
-		float theta1 = (float)i / numSlices * M_PI;
-		float theta2 = (float)(i + 1) / numSlices * M_PI;
-
-		glm::vec4 p1(_scope.x * 0.5 * cosf(theta1) + _scope.x * 0.5, _scope.y * sinf(theta1), 0.0f, 1.0f);
-		p1 = _pivot * _modelMat * p1;
-		glm::vec4 p2(_scope.x * 0.5 * cosf(theta2) + _scope.x * 0.5, _scope.y * sinf(theta2), 0.0f, 1.0f);
-		p2 = _pivot * _modelMat * p2;
-
-		vertices.push_back(Vertex(p0, normal, glm::vec4(_color, opacity)));
-		if (i < numSlices) {
-			vertices.push_back(Vertex(glm::vec3(p1), normal, glm::vec4(_color, opacity), 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p1), normal, glm::vec4(_color, opacity)));
-		}
-		if (i > 0) {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, glm::vec4(_color, opacity), 1));
-		} else {
-			vertices.push_back(Vertex(glm::vec3(p2), normal, glm::vec4(_color, opacity)));
-		}
-	}
+	int numSlices = LODPolicy::slices(12, _lod, 3);
+	UnitMeshCache::semiCircle(numSlices)->instantiate(_pivot * _modelMat, glm::vec3(_scope.x, _scope.y, 1), glm::vec4(_color, opacity), vertices);
 
 	faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 }
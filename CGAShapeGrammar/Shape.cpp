@@ -1,14 +1,32 @@
 #include "Shape.h"
 #include "OBJLoader.h"
-#include "GeneralObject.h"
+#include "AssetCache.h"
+#include "InstancedObject.h"
 #include "GLUtils.h"
 #include <iostream>
 #include <sstream>
 #include "CGA.h"
+#include "LODPolicy.h"
+#include "ThreadPool.h"
+#include <mutex>
 
 namespace cga {
 
-std::map<std::string, Asset> Shape::assets;
+std::map<std::string, boost::shared_ptr<const Asset> > Shape::assets;
+
+namespace {
+
+// guards Shape::assets, which is shared by the derivation and the preloading threads
+std::mutex assetsMutex;
+
+/** grid resolution of the first LOD of the assets, which is halved for each further level */
+const int LOD_RESOLUTION = 16;
+
+}
+
+Shape::Shape() {
+	_lod = 0;
+}
 
 void Shape::center(int axesSelector) {
 	if (axesSelector == AXES_SELECTOR_XYZ || axesSelector == AXES_SELECTOR_XY || axesSelector == AXES_SELECTOR_XZ || axesSelector == AXES_SELECTOR_X) {
@@ -53,7 +71,7 @@ boost::shared_ptr<Shape> Shape::innerSemiCircle(const std::string& name) {
 }
 
 boost::shared_ptr<Shape> Shape::insert(const std::string& name, const std::string& geometryPath) {
-	Asset asset = getAsset(geometryPath);
+	boost::shared_ptr<const Asset> asset = getAsset(geometryPath);
 	/*
 	std::vector<glm::vec3> points;
 	std::vector<glm::vec3> normals;
@@ -71,7 +89,7 @@ boost::shared_ptr<Shape> Shape::insert(const std::string& name, const std::strin
 	float scaleY = 1.0f;
 	float scaleZ = 1.0f;
 
-	glutils::BoundingBox bbox(asset.points);
+	glutils::BoundingBox bbox = asset->bbox;
 	if (_scope.x != 0 && _scope.y != 0 && _scope.z != 0) {			// all non-zero
 		scaleX = _scope.x / bbox.sx();
 		scaleY = _scope.y / bbox.sy();
@@ -104,26 +122,8 @@ boost::shared_ptr<Shape> Shape::insert(const std::string& name, const std::strin
 		// do nothing
 	}
 
-	// scale the points
-	for (int i = 0; i < asset.points.size(); ++i) {
-		for (int k = 0; k < asset.points[i].size(); ++k) {
-			asset.points[i][k].x = (asset.points[i][k].x - bbox.minPt.x) * scaleX;
-			asset.points[i][k].y = (asset.points[i][k].y - bbox.minPt.y) * scaleY;
-			asset.points[i][k].z = (asset.points[i][k].z - bbox.minPt.z) * scaleZ;
-		}
-	}
-
-	// if texCoords are not defined in obj file, generate them automatically.
-	if (_texCoords.size() > 0 && asset.texCoords.size() == 0) {
-		asset.texCoords.resize(asset.points.size());
-		for (int i = 0; i < asset.points.size(); ++i) {
-			asset.texCoords[i].resize(asset.points[i].size());
-			for (int k = 0; k < asset.points[i].size(); ++k) {
-				asset.texCoords[i][k].x = asset.points[i][k].x / _scope.x * (_texCoords[1].x - _texCoords[0].x) + _texCoords[0].x;
-				asset.texCoords[i][k].y = asset.points[i][k].y / _scope.y * (_texCoords[2].y - _texCoords[0].y) + _texCoords[0].y;
-			}
-		}
-	}
+	// the asset is fit to the scope by the matrix instead of scaling a copy of the points
+	glm::mat4 meshMat = glm::translate(glm::scale(glm::mat4(), glm::vec3(scaleX, scaleY, scaleZ)), -bbox.minPt);
 
 	/*
 	for (int i = 0; i < asset.points.size(); ++i) {
@@ -157,10 +157,15 @@ boost::shared_ptr<Shape> Shape::insert(const std::string& name, const std::strin
 	}
 	*/
 
-	if (asset.texCoords.size() > 0) {
-		return boost::shared_ptr<Shape>(new GeneralObject(name, _grammar_type, _pivot, _modelMat, asset.points, asset.normals, _color, asset.texCoords, _texture));
+	if (asset->hasTexCoords) {
+		return boost::shared_ptr<Shape>(new InstancedObject(name, _grammar_type, _pivot, _modelMat, _scope, asset, meshMat, _color, glm::vec4(1, 1, 0, 0), false, _texture));
+	} else if (_texCoords.size() > 0) {
+		// if texCoords are not defined in obj file, generate them from the positions in the scope.
+		glm::vec2 uvScale((_texCoords[1].x - _texCoords[0].x) * scaleX / _scope.x, (_texCoords[2].y - _texCoords[0].y) * scaleY / _scope.y);
+		glm::vec2 uvOffset(_texCoords[0].x - bbox.minPt.x * uvScale.x, _texCoords[0].y - bbox.minPt.y * uvScale.y);
+		return boost::shared_ptr<Shape>(new InstancedObject(name, _grammar_type, _pivot, _modelMat, _scope, asset, meshMat, _color, glm::vec4(uvScale, uvOffset), true, _texture));
 	} else {
-		return boost::shared_ptr<Shape>(new GeneralObject(name, _grammar_type, _pivot, _modelMat, asset.points, asset.normals, _color));
+		return boost::shared_ptr<Shape>(new InstancedObject(name, _grammar_type, _pivot, _modelMat, _scope, asset, meshMat, _color));
 	}
 }
 
@@ -245,8 +250,22 @@ void Shape::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& fac
 	renderManager->addObject("axis", "", vertices);
 }*/
 
-Asset Shape::getAsset(const std::string& filename) {
-	if (assets.find(filename) == assets.end()) {
+/**
+ * Return the asset loaded from the file.
+ * The asset is loaded only once, and all the inserts share the same immutable asset.
+ * This is thread-safe, and different assets are loaded concurrently.
+ */
+boost::shared_ptr<const Asset> Shape::getAsset(const std::string& filename) {
+	{
+		std::lock_guard<std::mutex> lock(assetsMutex);
+		auto it = assets.find(filename);
+		if (it != assets.end()) return it->second;
+	}
+
+	boost::shared_ptr<Asset> asset(new Asset());
+
+	// the binary cache saves parsing the text of the OBJ file and building the meshes
+	if (!AssetCache::load(filename, LODPolicy::MAX_LEVEL, LOD_RESOLUTION, *asset)) {
 		std::vector<std::vector<glm::vec3> > points;
 		std::vector<std::vector<glm::vec3> > normals;
 		std::vector<std::vector<glm::vec2> > texCoords;
@@ -254,10 +273,39 @@ Asset Shape::getAsset(const std::string& filename) {
 			throw std::string("OBJ file cannot be read: ") + filename.c_str() + ".";
 		}
 
-		assets[filename] = Asset(points, normals, texCoords);
+		*asset = Asset(points, normals, texCoords);
+		asset->buildMesh();
+		asset->generateLODs(LODPolicy::MAX_LEVEL, LOD_RESOLUTION);
+		AssetCache::save(filename, LODPolicy::MAX_LEVEL, LOD_RESOLUTION, *asset);
 	}
 
+	// if another thread has loaded the same asset in the meantime, its asset is used
+	std::lock_guard<std::mutex> lock(assetsMutex);
+	if (assets.find(filename) == assets.end()) {
+		assets[filename] = asset;
+	}
 	return assets[filename];
 }
 
+/**
+ * Load the assets that are not loaded yet on the thread pool.
+ * The errors are ignored here, and they are reported when the derivation inserts the asset.
+ */
+void Shape::preloadAssets(const std::set<std::string>& filenames, ThreadPool& pool) {
+	for (auto it = filenames.begin(); it != filenames.end(); ++it) {
+		{
+			std::lock_guard<std::mutex> lock(assetsMutex);
+			if (assets.find(*it) != assets.end()) continue;
+		}
+
+		std::string filename = *it;
+		pool.enqueue([filename]() {
+			try {
+				getAsset(filename);
+			} catch (...) {
+			}
+		});
+	}
+}
+
 }
\ No newline at end of file
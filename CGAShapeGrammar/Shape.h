@@ -3,6 +3,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <boost/shared_ptr.hpp>
@@ -10,6 +11,7 @@
 #include "GLUtils.h"
 
 class RenderManager;
+class ThreadPool;
 
 namespace cga {
 
@@ -27,10 +29,12 @@ public:
 	glm::vec3 _prev_scope;
 	glm::mat4 _pivot;
 	std::string _grammar_type;
+	int _lod;
 
-	static std::map<std::string, Asset> assets;
+	static std::map<std::string, boost::shared_ptr<const Asset> > assets;
 
 public:
+	Shape();
 	void center(int axesSelector);
 	virtual boost::shared_ptr<Shape> clone(const std::string& name) const;
 	virtual void comp(const std::map<std::string, std::string>& name_map, std::vector<boost::shared_ptr<Shape> >& shapes);
@@ -54,10 +58,11 @@ public:
 	void texture(const std::string& tex);
 	void translate(int mode, int coordSystem, float x, float y, float z);
 	virtual void generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const;
+	static void preloadAssets(const std::set<std::string>& filenames, ThreadPool& pool);
 
 protected:
 	//void drawAxes(RenderManager* renderManager, const glm::mat4& modelMat) const;
-	static Asset getAsset(const std::string& filename);
+	static boost::shared_ptr<const Asset> getAsset(const std::string& filename);
 };
 
 }
@@ -0,0 +1,602 @@
+#include "SoftwareRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include "Camera.h"
+#include "VertexTransform.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SOFTWARE_RENDERER_SSE
+#include <emmintrin.h>
+#endif
+
+// gcc/clang need the target attribute to emit the SSE2 instructions without global compiler flags.
+#if defined(SOFTWARE_RENDERER_SSE) && defined(__GNUC__)
+#define SOFTWARE_RENDERER_TARGET_SSE __attribute__((target("sse2")))
+#else
+#define SOFTWARE_RENDERER_TARGET_SSE
+#endif
+
+namespace {
+
+/** the screen coordinates are snapped to 1/16 pixel */
+const int SUBPIXEL_BITS = 4;
+const int SUBPIXEL = 1 << SUBPIXEL_BITS;
+
+/**
+ * The triangles are clipped to this distance in pixels from the center of the viewport, so that
+ * the fixed-point edge functions of a tile fit in 32-bit integers.
+ */
+const double GUARD_BAND = 4096.0;
+
+const glm::vec3 BACKGROUND(0.95f, 0.95f, 0.95f);
+
+struct ClipVertex {
+	glm::vec4 clip;
+	glm::vec3 normal;
+	glm::vec3 pos;
+};
+
+/**
+ * Triangle set up for the rasterization.
+ * The vertices are in counter-clockwise order, and the edge i is the one opposite to the vertex i.
+ */
+struct Triangle {
+	int x[3];			// fixed-point window coordinates
+	int y[3];
+	long long area;		// sum of the edge functions, i.e., twice the area in fixed point
+	int bias[3];		// -1 for the edges that are not top-left, so that the pixels on them belong to only one triangle
+	int minX;			// range of the pixels whose centers may be covered
+	int minY;
+	int maxX;
+	int maxY;
+	double zA;			// window depth = zC + zA * px + zB * py at the center of the pixel (px, py)
+	double zB;
+	double zC;
+	float invW[3];
+	glm::vec3 normal[3];
+	glm::vec3 pos[3];
+
+	/**
+	 * Return the edge function of the edge i at the center of the pixel (px, py) without the bias.
+	 */
+	long long edge(int i, int px, int py) const {
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		return (long long)(x[k] - x[j]) * (py * SUBPIXEL + SUBPIXEL / 2 - y[j]) - (long long)(y[k] - y[j]) * (px * SUBPIXEL + SUBPIXEL / 2 - x[j]);
+	}
+
+	/** increment of the edge function per pixel in x */
+	int stepX(int i) const { return -(y[(i + 2) % 3] - y[(i + 1) % 3]) * SUBPIXEL; }
+
+	/** increment of the edge function per pixel in y */
+	int stepY(int i) const { return (x[(i + 2) % 3] - x[(i + 1) % 3]) * SUBPIXEL; }
+};
+
+/**
+ * Triangles and their bins of a range of the faces.
+ */
+struct Chunk {
+	std::vector<Triangle> triangles;
+	std::vector<std::vector<int> > bins;
+};
+
+/**
+ * Edge functions of a triangle in a tile, which are stepped in 32-bit integers.
+ * The edges that cover the whole tile are replaced by 0 with no step.
+ */
+struct TileEdges {
+	int start[3];		// at the first pixel of the first row
+	int stepX[3];
+	int stepY[3];
+};
+
+int floorDiv(int a, int b) {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+int ceilDiv(int a, int b) {
+	return -floorDiv(-a, b);
+}
+
+/**
+ * Clip the polygon by the plane dot(plane, clip) >= 0.
+ */
+void clipPolygon(const std::vector<ClipVertex>& input, const glm::vec4& plane, std::vector<ClipVertex>& output) {
+	output.clear();
+	for (int i = 0; i < input.size(); ++i) {
+		const ClipVertex& a = input[i];
+		const ClipVertex& b = input[(i + 1) % input.size()];
+		float da = glm::dot(plane, a.clip);
+		float db = glm::dot(plane, b.clip);
+
+		if (da >= 0) output.push_back(a);
+		if ((da >= 0) != (db >= 0)) {
+			float t = da / (da - db);
+			ClipVertex v;
+			v.clip = a.clip + (b.clip - a.clip) * t;
+			v.normal = a.normal + (b.normal - a.normal) * t;
+			v.pos = a.pos + (b.pos - a.pos) * t;
+			output.push_back(v);
+		}
+	}
+}
+
+/**
+ * Map the clipped triangle to the window, and set it up for the rasterization.
+ * Return false if it is degenerate or does not cover the center of any pixel.
+ */
+bool setupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, int width, int height, Triangle& tri) {
+	const ClipVertex* v[3] = { &v0, &v1, &v2 };
+	float z[3];
+	for (int i = 0; i < 3; ++i) {
+		double invW = 1.0 / v[i]->clip.w;
+		tri.x[i] = (int)floor(((double)v[i]->clip.x * invW * 0.5 + 0.5) * width * SUBPIXEL + 0.5);
+		tri.y[i] = (int)floor(((double)v[i]->clip.y * invW * 0.5 + 0.5) * height * SUBPIXEL + 0.5);
+		z[i] = (float)((double)v[i]->clip.z * invW * 0.5 + 0.5);
+		tri.invW[i] = (float)invW;
+		tri.normal[i] = v[i]->normal;
+		tri.pos[i] = v[i]->pos;
+	}
+
+	// the triangles are not culled, so that the clockwise ones are flipped
+	long long area = (long long)(tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (long long)(tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+	if (area == 0) return false;
+	if (area < 0) {
+		std::swap(tri.x[1], tri.x[2]);
+		std::swap(tri.y[1], tri.y[2]);
+		std::swap(z[1], z[2]);
+		std::swap(tri.invW[1], tri.invW[2]);
+		std::swap(tri.normal[1], tri.normal[2]);
+		std::swap(tri.pos[1], tri.pos[2]);
+		area = -area;
+	}
+	tri.area = area;
+
+	int minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+	int minY = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+	int maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+	int maxY = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+	tri.minX = std::max(0, ceilDiv(minX - SUBPIXEL / 2, SUBPIXEL));
+	tri.minY = std::max(0, ceilDiv(minY - SUBPIXEL / 2, SUBPIXEL));
+	tri.maxX = std::min(width - 1, floorDiv(maxX - SUBPIXEL / 2, SUBPIXEL));
+	tri.maxY = std::min(height - 1, floorDiv(maxY - SUBPIXEL / 2, SUBPIXEL));
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY) return false;
+
+	// top-left fill rule for the counter-clockwise triangles in the y-up window coordinates
+	for (int i = 0; i < 3; ++i) {
+		int dx = tri.x[(i + 2) % 3] - tri.x[(i + 1) % 3];
+		int dy = tri.y[(i + 2) % 3] - tri.y[(i + 1) % 3];
+		bool topLeft = dy < 0 || (dy == 0 && dx < 0);
+		tri.bias[i] = topLeft ? 0 : -1;
+	}
+
+	// the window depth is linear in the window coordinates
+	tri.zA = 0;
+	tri.zB = 0;
+	tri.zC = 0;
+	for (int i = 0; i < 3; ++i) {
+		tri.zA += (double)tri.stepX(i) * z[i];
+		tri.zB += (double)tri.stepY(i) * z[i];
+		tri.zC += (double)tri.edge(i, 0, 0) * z[i];
+	}
+	tri.zA /= area;
+	tri.zB /= area;
+	tri.zC /= area;
+
+	return true;
+}
+
+/**
+ * Transform, clip, set up, and bin the triangles of the faces.
+ * The vertex processing is the same as lc_vert_pass1.glsl, i.e., the instances are transformed by their model
+ * matrices, and the normals are not normalized for the other faces.
+ */
+void processFaces(const std::vector<boost::shared_ptr<glutils::Face> >& faces, int first, int last, const glm::mat4& mvpMatrix, int width, int height, int tilesX, int tilesY, Chunk& chunk) {
+	chunk.bins.resize(tilesX * tilesY);
+
+	float gx = (float)(GUARD_BAND * 2.0 / width);
+	float gy = (float)(GUARD_BAND * 2.0 / height);
+	glm::vec4 planes[6] = {
+		glm::vec4(0, 0, 1, 1), glm::vec4(0, 0, -1, 1),
+		glm::vec4(1, 0, 0, gx), glm::vec4(-1, 0, 0, gx),
+		glm::vec4(0, 1, 0, gy), glm::vec4(0, -1, 0, gy)
+	};
+
+	std::vector<Vertex> instanceVertices;
+	std::vector<ClipVertex> polygon;
+	std::vector<ClipVertex> clipped;
+	for (int fi = first; fi < last; ++fi) {
+		const std::vector<Vertex>* vertices = &faces[fi]->vertices;
+		if (faces[fi]->isInstance()) {
+			instanceVertices.clear();
+			faces[fi]->instantiate(instanceVertices);
+			vertices = &instanceVertices;
+		}
+
+		for (int vi = 0; vi + 2 < vertices->size(); vi += 3) {
+			polygon.resize(3);
+			bool inside = true;
+			for (int k = 0; k < 3; ++k) {
+				const Vertex& vertex = (*vertices)[vi + k];
+				polygon[k].clip = mvpMatrix * glm::vec4(vertex.position, 1);
+				polygon[k].normal = vertex.normal;
+				polygon[k].pos = vertex.position;
+				for (int p = 0; p < 6; ++p) {
+					if (glm::dot(planes[p], polygon[k].clip) < 0) inside = false;
+				}
+			}
+
+			if (!inside) {
+				for (int p = 0; p < 6 && polygon.size() >= 3; ++p) {
+					clipPolygon(polygon, planes[p], clipped);
+					polygon.swap(clipped);
+				}
+			}
+
+			for (int k = 1; k + 1 < polygon.size(); ++k) {
+				Triangle tri;
+				if (!setupTriangle(polygon[0], polygon[k], polygon[k + 1], width, height, tri)) continue;
+
+				int index = chunk.triangles.size();
+				chunk.triangles.push_back(tri);
+				for (int ty = tri.minY / SoftwareRenderer::TILE_SIZE; ty <= tri.maxY / SoftwareRenderer::TILE_SIZE; ++ty) {
+					for (int tx = tri.minX / SoftwareRenderer::TILE_SIZE; tx <= tri.maxX / SoftwareRenderer::TILE_SIZE; ++tx) {
+						chunk.bins[ty * tilesX + tx].push_back(index);
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Rasterize the pixels [x0, x1] x [y0, y1] of the tile, where x0 is aligned to 4 pixels in the tile.
+ * The pixels in [minX, maxX] of each row are written if they pass all the edges and the depth test.
+ */
+void rasterizeScalar(const Triangle& tri, int id, const TileEdges& edges, int tileX, int tileY, int x0, int x1, int y0, int y1, int minX, int maxX, float* tileDepth, int* tileIds) {
+	int rowEdges[3] = { edges.start[0], edges.start[1], edges.start[2] };
+	for (int py = y0; py <= y1; ++py) {
+		float zRow = (float)(tri.zC + tri.zA * x0 + tri.zB * py);
+		float zA = (float)tri.zA;
+		int offset = (py - tileY) * SoftwareRenderer::TILE_SIZE - tileX;
+
+		for (int px = x0; px <= x1; ++px) {
+			int n = px - x0;
+			if (px < minX || px > maxX) continue;
+			if (rowEdges[0] + edges.stepX[0] * n < 0 || rowEdges[1] + edges.stepX[1] * n < 0 || rowEdges[2] + edges.stepX[2] * n < 0) continue;
+
+			float z = zRow + zA * (float)n;
+			if (z <= tileDepth[offset + px]) {
+				tileDepth[offset + px] = z;
+				tileIds[offset + px] = id;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			rowEdges[i] += edges.stepY[i];
+		}
+	}
+}
+
+#ifdef SOFTWARE_RENDERER_SSE
+
+SOFTWARE_RENDERER_TARGET_SSE
+void rasterizeSSE(const Triangle& tri, int id, const TileEdges& edges, int tileX, int tileY, int x0, int x1, int y0, int y1, int minX, int maxX, float* tileDepth, int* tileIds) {
+	__m128i laneEdges[3];
+	__m128i groupSteps[3];
+	int rowEdges[3];
+	for (int i = 0; i < 3; ++i) {
+		laneEdges[i] = _mm_set_epi32(edges.stepX[i] * 3, edges.stepX[i] * 2, edges.stepX[i], 0);
+		groupSteps[i] = _mm_set1_epi32(edges.stepX[i] * 4);
+		rowEdges[i] = edges.start[i];
+	}
+	const __m128 laneOffsets = _mm_set_ps(3, 2, 1, 0);
+	const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+	const __m128i minXs = _mm_set1_epi32(minX - 1);
+	const __m128i maxXs = _mm_set1_epi32(maxX + 1);
+	const __m128i minusOne = _mm_set1_epi32(-1);
+	const __m128 zA = _mm_set1_ps((float)tri.zA);
+	const __m128i ids = _mm_set1_epi32(id);
+
+	for (int py = y0; py <= y1; ++py) {
+		__m128 zRow = _mm_set1_ps((float)(tri.zC + tri.zA * x0 + tri.zB * py));
+		int offset = (py - tileY) * SoftwareRenderer::TILE_SIZE - tileX;
+		__m128i e[3];
+		for (int i = 0; i < 3; ++i) {
+			e[i] = _mm_add_epi32(_mm_set1_epi32(rowEdges[i]), laneEdges[i]);
+		}
+
+		for (int px = x0; px <= x1; px += 4) {
+			__m128i xs = _mm_add_epi32(_mm_set1_epi32(px), lanes);
+			__m128i mask = _mm_and_si128(_mm_cmpgt_epi32(xs, minXs), _mm_cmplt_epi32(xs, maxXs));
+			for (int i = 0; i < 3; ++i) {
+				mask = _mm_and_si128(mask, _mm_cmpgt_epi32(e[i], minusOne));
+				e[i] = _mm_add_epi32(e[i], groupSteps[i]);
+			}
+
+			if (_mm_movemask_epi8(mask) != 0) {
+				// the same operations as the scalar version, i.e., zRow + zA * n
+				__m128 z = _mm_add_ps(zRow, _mm_mul_ps(zA, _mm_add_ps(_mm_set1_ps((float)(px - x0)), laneOffsets)));
+				__m128 d = _mm_loadu_ps(tileDepth + offset + px);
+				__m128i pass = _mm_and_si128(mask, _mm_castps_si128(_mm_cmple_ps(z, d)));
+				__m128 passF = _mm_castsi128_ps(pass);
+				_mm_storeu_ps(tileDepth + offset + px, _mm_or_ps(_mm_and_ps(passF, z), _mm_andnot_ps(passF, d)));
+
+				__m128i oldIds = _mm_loadu_si128((const __m128i*)(tileIds + offset + px));
+				_mm_storeu_si128((__m128i*)(tileIds + offset + px), _mm_or_si128(_mm_and_si128(pass, ids), _mm_andnot_si128(pass, oldIds)));
+			}
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			rowEdges[i] += edges.stepY[i];
+		}
+	}
+}
+
+#endif
+
+/**
+ * Rasterize the triangle into the depth and the triangle ids of the tile.
+ * The edges are classified at the corners of the covered rectangle first, so that the triangles outside the
+ * rectangle are rejected, and only the edges that cross it are evaluated per pixel.
+ */
+void rasterizeTriangle(const Triangle& tri, int id, int tileX, int tileY, int tileWidth, int tileHeight, bool useSSE, float* tileDepth, int* tileIds) {
+	int minX = std::max(tri.minX, tileX);
+	int maxX = std::min(tri.maxX, tileX + tileWidth - 1);
+	int y0 = std::max(tri.minY, tileY);
+	int y1 = std::min(tri.maxY, tileY + tileHeight - 1);
+	if (minX > maxX || y0 > y1) return;
+
+	int x0 = tileX + ((minX - tileX) & ~3);
+	int x1 = tileX + ((maxX - tileX) | 3);
+
+	TileEdges edges;
+	for (int i = 0; i < 3; ++i) {
+		long long corners[4] = { tri.edge(i, minX, y0), tri.edge(i, maxX, y0), tri.edge(i, minX, y1), tri.edge(i, maxX, y1) };
+		long long minEdge = *std::min_element(corners, corners + 4) + tri.bias[i];
+		long long maxEdge = *std::max_element(corners, corners + 4) + tri.bias[i];
+		if (maxEdge < 0) return;
+
+		if (minEdge >= 0) {
+			edges.start[i] = 0;
+			edges.stepX[i] = 0;
+			edges.stepY[i] = 0;
+		}
+		else {
+			edges.start[i] = (int)(tri.edge(i, x0, y0) + tri.bias[i]);
+			edges.stepX[i] = tri.stepX(i);
+			edges.stepY[i] = tri.stepY(i);
+		}
+	}
+
+#ifdef SOFTWARE_RENDERER_SSE
+	if (useSSE) {
+		rasterizeSSE(tri, id, edges, tileX, tileY, x0, x1, y0, y1, minX, maxX, tileDepth, tileIds);
+		return;
+	}
+#endif
+	rasterizeScalar(tri, id, edges, tileX, tileY, x0, x1, y0, y1, minX, maxX, tileDepth, tileIds);
+}
+
+/**
+ * Rasterize the binned triangles of a tile in the order of the faces, and resolve the normals and the positions
+ * of the visible triangles with the perspective-correct interpolation.
+ */
+void renderTile(const std::vector<Chunk>& chunks, const std::vector<int>& chunkOffsets, int tileIndex, int tileX, int tileY, int tileWidth, int tileHeight, int width, bool useSSE, SoftwareRenderer& renderer) {
+	const int T = SoftwareRenderer::TILE_SIZE;
+	float tileDepth[T * T];
+	int tileIds[T * T];
+	std::fill(tileDepth, tileDepth + T * T, 1.0f);
+	std::fill(tileIds, tileIds + T * T, -1);
+
+	for (int c = 0; c < chunks.size(); ++c) {
+		const std::vector<int>& bin = chunks[c].bins[tileIndex];
+		for (int i = 0; i < bin.size(); ++i) {
+			rasterizeTriangle(chunks[c].triangles[bin[i]], chunkOffsets[c] + bin[i], tileX, tileY, tileWidth, tileHeight, useSSE, tileDepth, tileIds);
+		}
+	}
+
+	for (int ly = 0; ly < tileHeight; ++ly) {
+		for (int lx = 0; lx < tileWidth; ++lx) {
+			int px = tileX + lx;
+			int py = tileY + ly;
+			int index = py * width + px;
+			int id = tileIds[ly * T + lx];
+			if (id < 0) continue;
+
+			int c = std::upper_bound(chunkOffsets.begin(), chunkOffsets.end(), id) - chunkOffsets.begin() - 1;
+			const Triangle& tri = chunks[c].triangles[id - chunkOffsets[c]];
+
+			double w[3];
+			double total = 0;
+			for (int k = 0; k < 3; ++k) {
+				w[k] = (double)tri.edge(k, px, py) / tri.area * tri.invW[k];
+				total += w[k];
+			}
+			glm::vec3 normal(0.0f);
+			glm::vec3 pos(0.0f);
+			for (int k = 0; k < 3; ++k) {
+				float t = (float)(w[k] / total);
+				normal += tri.normal[k] * t;
+				pos += tri.pos[k] * t;
+			}
+
+			renderer.depth[index] = tileDepth[ly * T + lx];
+			renderer.normals[index] = normal;
+			renderer.originPos[index] = pos;
+		}
+	}
+}
+
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, int numThreads) {
+	if (width <= 0 || height <= 0 || width > MAX_SIZE || height > MAX_SIZE) throw "Invalid size of the software renderer.";
+
+	this->width = width;
+	this->height = height;
+	useSSE = glutils::simdLevel() >= glutils::SIMD_SSE;
+	pool = boost::shared_ptr<ThreadPool>(new ThreadPool(numThreads));
+}
+
+/**
+ * Render the faces by the model view projection matrix into the depth, the normals, and the original positions.
+ * The result is the same for any number of threads.
+ */
+void SoftwareRenderer::render(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const glm::mat4& mvpMatrix) {
+	depth.assign(width * height, 1.0f);
+	normals.assign(width * height, BACKGROUND);
+	originPos.assign(width * height, BACKGROUND);
+
+	int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	// transform, clip, and bin the triangles of a few chunks per thread
+	int numChunks = std::max(1, std::min((int)faces.size(), pool->size() * 4));
+	std::vector<Chunk> chunks(numChunks);
+	for (int c = 0; c < numChunks; ++c) {
+		int first = faces.size() * c / numChunks;
+		int last = faces.size() * (c + 1) / numChunks;
+		Chunk* chunk = &chunks[c];
+		pool->enqueue([&faces, first, last, &mvpMatrix, this, tilesX, tilesY, chunk]() {
+			processFaces(faces, first, last, mvpMatrix, width, height, tilesX, tilesY, *chunk);
+		});
+	}
+	pool->wait();
+
+	std::vector<int> chunkOffsets(numChunks);
+	for (int c = 1; c < numChunks; ++c) {
+		chunkOffsets[c] = chunkOffsets[c - 1] + chunks[c - 1].triangles.size();
+	}
+
+	// the tiles are taken by the idle workers one by one, so that the crowded tiles do not stall the others
+	for (int ty = 0; ty < tilesY; ++ty) {
+		for (int tx = 0; tx < tilesX; ++tx) {
+			int tileX = tx * TILE_SIZE;
+			int tileY = ty * TILE_SIZE;
+			int tileWidth = std::min(TILE_SIZE, width - tileX);
+			int tileHeight = std::min(TILE_SIZE, height - tileY);
+			int tileIndex = ty * tilesX + tx;
+			pool->enqueue([&chunks, &chunkOffsets, tileIndex, tileX, tileY, tileWidth, tileHeight, this]() {
+				renderTile(chunks, chunkOffsets, tileIndex, tileX, tileY, tileWidth, tileHeight, width, useSSE, *this);
+			});
+		}
+	}
+	pool->wait();
+}
+
+/**
+ * Draw the lines at the discontinuities of the normals and the depth in the same way as lc_frag_line.glsl without hatching.
+ * The image is top-down as the one grabbed from the frame buffer.
+ */
+void SoftwareRenderer::drawLines(const glm::mat4& pMatrix, QImage& image) const {
+	const float normalSensitivity = 1.0f;
+	const float depthSensitivity = 10.0f;
+
+	image = QImage(width, height, QImage::Format_RGB32);
+	uchar* bits = image.bits();
+	int bytesPerLine = image.bytesPerLine();
+
+	int rowsPerTask = std::max(1, height / (pool->size() * 4));
+	for (int y0 = 0; y0 < height; y0 += rowsPerTask) {
+		int y1 = std::min(height, y0 + rowsPerTask);
+		pool->enqueue([this, &pMatrix, bits, bytesPerLine, y0, y1, normalSensitivity, depthSensitivity]() {
+			for (int y = y0; y < y1; ++y) {
+				QRgb* line = (QRgb*)(bits + (height - 1 - y) * bytesPerLine);
+				for (int x = 0; x < width; ++x) {
+					int index = y * width + x;
+					float d = depth[index];
+
+					// background
+					if (d == 1.0f) {
+						line[x] = qRgb(255, 255, 255);
+						continue;
+					}
+
+					glm::vec3 normal = glm::normalize(normals[index]);
+					float origDepth = pMatrix[3][2] / (d + pMatrix[2][2]);
+					const glm::vec3& pos = originPos[index];
+
+					// the neighbors outside the image are clamped to the edge as the texture lookups
+					float normalDiff = 0.0f;
+					float depthDiff = 0.0f;
+					for (int xx = -1; xx <= 1; ++xx) {
+						for (int yy = -1; yy <= 1; ++yy) {
+							if (xx == 0 && yy == 0) continue;
+
+							int neighbor = std::min(std::max(y + yy, 0), height - 1) * width + std::min(std::max(x + xx, 0), width - 1);
+							const glm::vec3& nn = normals[neighbor];
+							float dd = pMatrix[3][2] / (depth[neighbor] + pMatrix[2][2]);
+							const glm::vec3& pp = originPos[neighbor];
+
+							if (glm::length(pp - BACKGROUND) > 0.1f && std::abs(glm::dot(glm::normalize(pp - pos), normal)) < 0.4f) continue;
+
+							normalDiff = std::max(normalDiff, glm::length(normal - nn));
+							depthDiff = std::max(depthDiff, std::abs(origDepth - dd));
+						}
+					}
+
+					float diff = std::min(1.0f, std::max(depthDiff * depthSensitivity, normalDiff * normalSensitivity));
+					line[x] = diff > 0.3f ? qRgb(0, 0, 0) : qRgb(255, 255, 255);
+				}
+			}
+		});
+	}
+	pool->wait();
+}
+
+/**
+ * Make the fixed scene of the checks and its camera for the images of the given size.
+ * The ground crosses the near plane, so that the clipping is also checked.
+ */
+void SoftwareRenderer::checkScene(std::vector<boost::shared_ptr<glutils::Face> >& faces, Camera& camera, int width, int height) {
+	faces.clear();
+	glm::vec4 color(1, 1, 1, 1);
+	std::vector<Vertex> vertices;
+	glutils::drawQuad(1000, 1000, color, glm::rotate(glm::mat4(), -3.141592f * 0.5f, glm::vec3(1, 0, 0)), vertices);
+	faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face("ground", "", vertices)));
+	vertices.clear();
+	glutils::drawBox(20, 30, 15, color, glm::translate(glm::mat4(), glm::vec3(-5, 15, 0)), vertices);
+	faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face("box", "", vertices)));
+	vertices.clear();
+	glutils::drawSphere(8, color, glm::translate(glm::mat4(), glm::vec3(10, 20, 5)), vertices);
+	faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face("sphere", "", vertices)));
+	vertices.clear();
+	glutils::drawCylinderY(3, 3, 40, color, glm::translate(glm::mat4(), glm::vec3(-15, 0, 10)), vertices);
+	faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face("cylinder", "", vertices)));
+
+	camera = Camera();
+	camera.yrot = -40.0f;
+	camera.updatePMatrix(width, height);
+}
+
+/**
+ * Render the scene of checkScene() by the scalar and the SSE rasterization with one and all the threads,
+ * and return true if all of them produce the same buffers and lines.
+ */
+bool SoftwareRenderer::checkConsistency(int width, int height) {
+	std::vector<boost::shared_ptr<glutils::Face> > faces;
+	Camera camera;
+	checkScene(faces, camera, width, height);
+
+	SoftwareRenderer reference(width, height, 1);
+	reference.useSSE = false;
+	reference.render(faces, camera.mvpMatrix);
+	QImage referenceImage;
+	reference.drawLines(camera.pMatrix, referenceImage);
+
+	for (int threads = 0; threads < 2; ++threads) {
+		for (int sse = 0; sse < 2; ++sse) {
+			SoftwareRenderer renderer(width, height, threads == 0 ? 1 : 0);
+			renderer.useSSE = renderer.useSSE && sse == 1;
+			renderer.render(faces, camera.mvpMatrix);
+			QImage image;
+			renderer.drawLines(camera.pMatrix, image);
+
+			if (renderer.depth != reference.depth || renderer.normals != reference.normals || renderer.originPos != reference.originPos) return false;
+			if (image != referenceImage) return false;
+		}
+	}
+
+	return true;
+}
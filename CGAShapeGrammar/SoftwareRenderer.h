@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <QImage>
+#include <boost/shared_ptr.hpp>
+#include <glm/glm.hpp>
+#include "GLUtils.h"
+#include "ThreadPool.h"
+
+class Camera;
+
+/**
+ * CPU rasterizer that produces the same G-buffer as the first pass of the line rendering, i.e., the window depth,
+ * the normal, and the original position of each pixel, and draws the lines from it by the same edge filter as
+ * lc_frag_line.glsl. It does not need an OpenGL context, so that the line drawings can be generated on the machines
+ * without GPU, and the result does not depend on the driver or the number of threads.
+ *
+ * The triangles are clipped, set up, and binned into tiles of TILE_SIZE x TILE_SIZE pixels in parallel, and then
+ * each tile is rasterized by a worker of the thread pool. The edge functions are evaluated in fixed point with the
+ * top-left fill rule, four pixels at a time when SSE is available. The buffers are stored bottom-up as in OpenGL.
+ * The workers are created once with the renderer, so that a renderer should be reused for all the images.
+ */
+class SoftwareRenderer {
+public:
+	static const int TILE_SIZE = 32;
+	static const int MAX_SIZE = 4096;
+
+public:
+	int width;
+	int height;
+	bool useSSE;						// false to use the scalar rasterization even if SSE is available
+	std::vector<float> depth;			// window depth in [0, 1], 1 for the background
+	std::vector<glm::vec3> normals;		// interpolated normal, (0.95, 0.95, 0.95) for the background
+	std::vector<glm::vec3> originPos;	// position in the world, (0.95, 0.95, 0.95) for the background
+
+private:
+	boost::shared_ptr<ThreadPool> pool;
+
+public:
+	SoftwareRenderer(int width, int height, int numThreads = 0);
+
+	void render(const std::vector<boost::shared_ptr<glutils::Face> >& faces, const glm::mat4& mvpMatrix);
+	void drawLines(const glm::mat4& pMatrix, QImage& image) const;
+	static void checkScene(std::vector<boost::shared_ptr<glutils::Face> >& faces, Camera& camera, int width, int height);
+	static bool checkConsistency(int width = 128, int height = 128);
+};
@@ -14,4 +14,8 @@ boost::shared_ptr<Shape> TextureOperator::apply(boost::shared_ptr<Shape>& shape,
 	return shape;
 }
 
+void TextureOperator::getResources(const Grammar& grammar, std::set<std::string>& geometryPaths, std::set<std::string>& texturePaths) const {
+	texturePaths.insert(grammar.evalString(texture, boost::shared_ptr<Shape>()));
+}
+
 }
@@ -11,6 +11,7 @@ private:
 public:
 	TextureOperator(const std::string& texture);
 	boost::shared_ptr<Shape> apply(boost::shared_ptr<Shape>& shape, const Grammar& grammar, std::list<boost::shared_ptr<Shape> >& stack);
+	void getResources(const Grammar& grammar, std::set<std::string>& geometryPaths, std::set<std::string>& texturePaths) const;
 };
 
 }
@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+/**
+ * Start the workers. If numThreads is 0, the number of the hardware threads is used.
+ */
+ThreadPool::ThreadPool(int numThreads) {
+	numBusy = 0;
+	stopping = false;
+
+	if (numThreads <= 0) numThreads = defaultSize();
+	for (int i = 0; i < numThreads; ++i) {
+		workers.push_back(std::thread(&ThreadPool::run, this));
+	}
+}
+
+/**
+ * Finish the queued tasks, and join the workers.
+ */
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAdded.notify_all();
+
+	for (int i = 0; i < workers.size(); ++i) {
+		workers[i].join();
+	}
+}
+
+void ThreadPool::enqueue(const std::function<void()>& task) {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		tasks.push(task);
+	}
+	taskAdded.notify_one();
+}
+
+/**
+ * Block until all the queued tasks are finished, and rethrow the first exception thrown by them.
+ */
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!tasks.empty() || numBusy > 0) {
+		allDone.wait(lock);
+	}
+
+	if (error) {
+		std::exception_ptr e = error;
+		error = std::exception_ptr();
+		std::rethrow_exception(e);
+	}
+}
+
+int ThreadPool::defaultSize() {
+	return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void ThreadPool::run() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (tasks.empty() && !stopping) {
+				taskAdded.wait(lock);
+			}
+			if (tasks.empty()) return;
+
+			task = tasks.front();
+			tasks.pop();
+			numBusy++;
+		}
+
+		std::exception_ptr e;
+		try {
+			task();
+		} catch (...) {
+			e = std::current_exception();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (e && !error) error = e;
+			numBusy--;
+			if (tasks.empty() && numBusy == 0) allDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed number of worker threads that execute the queued tasks in FIFO order.
+ * The workers are joined when the pool is destroyed, so that a long-lived pool is reused by many
+ * batches of work, each of which is finished by wait(). The first exception thrown by the tasks of a batch
+ * is rethrown by wait(), and the others are discarded.
+ */
+class ThreadPool {
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()> > tasks;
+	std::mutex mutex;
+	std::condition_variable taskAdded;
+	std::condition_variable allDone;
+	int numBusy;
+	bool stopping;
+	std::exception_ptr error;
+
+public:
+	ThreadPool(int numThreads = 0);
+	~ThreadPool();
+
+	int size() const { return workers.size(); }
+	void enqueue(const std::function<void()>& task);
+	void wait();
+	static int defaultSize();
+
+private:
+	void run();
+};
@@ -164,21 +164,23 @@ void UShapePrism::split(int splitAxis, const std::vector<float>& sizes, const st
 void UShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	// top
 	{
 		std::vector<Vertex> vertices;
-		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::translate(_pivot * _modelMat, glm::vec3(_front_width * 0.5, (_scope.y - _back_depth) * 0.5, _scope.z)), vertices);
-		glutils::drawQuad(_scope.x, _back_depth, glm::vec4(_color, opacity), glm::translate(_pivot * _modelMat, glm::vec3(_scope.x * 0.5, _scope.y - _back_depth * 0.5, _scope.z)), vertices);
-		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::translate(_pivot * _modelMat, glm::vec3(_scope.x - _front_width * 0.5, (_scope.y - _back_depth) * 0.5, _scope.z)), vertices);
+		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::translate(shapeMat, glm::vec3(_front_width * 0.5, (_scope.y - _back_depth) * 0.5, _scope.z)), vertices);
+		glutils::drawQuad(_scope.x, _back_depth, glm::vec4(_color, opacity), glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y - _back_depth * 0.5, _scope.z)), vertices);
+		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::translate(shapeMat, glm::vec3(_scope.x - _front_width * 0.5, (_scope.y - _back_depth) * 0.5, _scope.z)), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 
 	// base
 	if (_scope.z >= 0) {
 		std::vector<Vertex> vertices;
-		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::rotate(glm::translate(_pivot * _modelMat, glm::vec3(_front_width * 0.5, (_scope.y - _back_depth) * 0.5, 0)), M_PI, glm::vec3(1, 0, 0)), vertices);
-		glutils::drawQuad(_scope.x, _back_depth, glm::vec4(_color, opacity), glm::rotate(glm::translate(_pivot * _modelMat, glm::vec3(_scope.x * 0.5, _scope.y - _back_depth * 0.5, 0)), M_PI, glm::vec3(1, 0, 0)), vertices);
-		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::rotate(glm::translate(_pivot * _modelMat, glm::vec3(_scope.x - _front_width * 0.5, (_scope.y - _back_depth) * 0.5, 0)), M_PI, glm::vec3(1, 0, 0)), vertices);
+		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width * 0.5, (_scope.y - _back_depth) * 0.5, 0)), M_PI, glm::vec3(1, 0, 0)), vertices);
+		glutils::drawQuad(_scope.x, _back_depth, glm::vec4(_color, opacity), glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y - _back_depth * 0.5, 0)), M_PI, glm::vec3(1, 0, 0)), vertices);
+		glutils::drawQuad(_front_width, _scope.y - _back_depth, glm::vec4(_color, opacity), glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x - _front_width * 0.5, (_scope.y - _back_depth) * 0.5, 0)), M_PI, glm::vec3(1, 0, 0)), vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 
@@ -189,27 +191,27 @@ void UShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_front_width, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, _scope.y - _back_depth, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
+		mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, _scope.y - _back_depth, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x - _front_width * 2, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x - _front_width * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
+		mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x - _front_width * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_front_width, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width, (_scope.y - _back_depth) * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width, (_scope.y - _back_depth) * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y - _back_depth, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x - _front_width, (_scope.y - _back_depth) * 0.5, _scope.z * 0.5)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x - _front_width, (_scope.y - _back_depth) * 0.5, _scope.z * 0.5)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y - _back_depth, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -221,7 +223,7 @@ void UShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x * 0.5, 0, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), glm::vec3(0, -_scope.y, 0)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x * 0.5, 0, _scope.z * 0.5)), M_PI, glm::vec3(0, 0, 1)), glm::vec3(0, -_scope.y, 0)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.x, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -233,7 +235,7 @@ void UShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y * 0.5, _scope.z * 0.5)), M_PI * 0.5f, glm::vec3(0, 0, 1)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -245,7 +247,7 @@ void UShapePrism::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		if (_scope.z < 0) {
 			rot_angle = -rot_angle;
 		}
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(glm::rotate(_modelMat, -M_PI * 0.5f, glm::vec3(0, 0, 1)), glm::vec3(-_scope.y * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(glm::rotate(shapeMat, -M_PI * 0.5f, glm::vec3(0, 0, 1)), glm::vec3(-_scope.y * 0.5, 0, _scope.z * 0.5)), rot_angle, glm::vec3(1, 0, 0));
 		glutils::drawQuad(_scope.y, _scope.z, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
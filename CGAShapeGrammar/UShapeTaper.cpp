@@ -139,6 +139,8 @@ void UShapeTaper::size(float xSize, float ySize, float zSize, bool centered) {
 void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face> >& faces, float opacity) const {
 	if (!_active) return;
 
+	glm::mat4 shapeMat = _pivot * _modelMat;
+
 	float offset = _scope.z / tanf(_slope / 180.0f * M_PI);
 
 	// top face
@@ -154,24 +156,24 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 		points.push_back(glm::vec2(_scope.x - offset * 2, 0));
 		points.push_back(glm::vec2(_scope.x - offset * 2, _scope.y - offset * 2));
 		points.push_back(glm::vec2(0, _scope.y - offset * 2));
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(offset, offset, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(offset, offset, _scope.z));
 		glutils::drawPolygon(points, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 	else if (_front_width * 0.5f > offset) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_front_width * 0.5f, _scope.y * 0.5f, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_front_width * 0.5f, _scope.y * 0.5f, _scope.z));
 		glutils::drawQuad(_front_width - offset * 2, _scope.y - offset * 2,glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 
 		vertices.clear();
-		mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x - _front_width * 0.5f, _scope.y * 0.5f, _scope.z));
+		mat = glm::translate(shapeMat, glm::vec3(_scope.x - _front_width * 0.5f, _scope.y * 0.5f, _scope.z));
 		glutils::drawQuad(_front_width - offset * 2, _scope.y - offset * 2, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
 	else if (_back_height * 0.5f > offset) {
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::translate(_modelMat, glm::vec3(_scope.x * 0.5f, _scope.y - _back_height * 0.5f, _scope.z));
+		glm::mat4 mat = glm::translate(shapeMat, glm::vec3(_scope.x * 0.5f, _scope.y - _back_height * 0.5f, _scope.z));
 		glutils::drawQuad(_scope.x - offset * 2, _back_height - offset * 2, glm::vec4(_color, opacity), mat, vertices);
 		faces.push_back(boost::shared_ptr<glutils::Face>(new glutils::Face(_name, _grammar_type, vertices)));
 	}
@@ -180,7 +182,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 	// side faces
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(_modelMat, _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(shapeMat, _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_front_width, 0));
@@ -192,7 +194,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y - _back_height, 0));
@@ -204,7 +206,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_front_width, _scope.y - _back_height, 0)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_front_width, _scope.y - _back_height, 0)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.x - _front_width * 2, 0));
@@ -216,7 +218,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x - _front_width, _scope.y - _back_height, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x - _front_width, _scope.y - _back_height, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y - _back_height, 0));
@@ -228,7 +230,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 	
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x - _front_width, 0, 0)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x - _front_width, 0, 0)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_front_width, 0));
@@ -240,7 +242,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, 0, 0)), M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y, 0));
@@ -252,7 +254,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 	
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(_scope.x, _scope.y, 0)), M_PI, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(_scope.x, _scope.y, 0)), M_PI, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.x, 0));
@@ -264,7 +266,7 @@ void UShapeTaper::generateGeometry(std::vector<boost::shared_ptr<glutils::Face>
 
 	{
 		std::vector<Vertex> vertices;
-		glm::mat4 mat = _pivot * glm::rotate(glm::rotate(glm::translate(_modelMat, glm::vec3(0, _scope.y, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
+		glm::mat4 mat = glm::rotate(glm::rotate(glm::translate(shapeMat, glm::vec3(0, _scope.y, 0)), -M_PI * 0.5f, glm::vec3(0, 0, 1)), _slope / 180.0f * M_PI, glm::vec3(1, 0, 0));
 		std::vector<glm::vec2> points;
 		points.push_back(glm::vec2(0, 0));
 		points.push_back(glm::vec2(_scope.y, 0));
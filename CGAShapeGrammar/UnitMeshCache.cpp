@@ -0,0 +1,291 @@
+#include "UnitMeshCache.h"
+#include <map>
+#include <mutex>
+#include "CGA.h"
+#include "VertexTransform.h"
+
+namespace cga {
+
+namespace {
+
+struct UnitMeshKey {
+	int type;
+	int slices;
+	int stacks;
+	float param;
+
+	UnitMeshKey(int type, int slices, int stacks, float param) : type(type), slices(slices), stacks(stacks), param(param) {}
+
+	bool operator<(const UnitMeshKey& other) const {
+		if (type != other.type) return type < other.type;
+		if (slices != other.slices) return slices < other.slices;
+		if (stacks != other.stacks) return stacks < other.stacks;
+		return param < other.param;
+	}
+};
+
+// namespace scope, so that they are constructed before any shape is generated
+std::mutex cacheMutex;
+std::map<UnitMeshKey, boost::shared_ptr<const UnitMesh> > cache;
+
+}
+
+/**
+ * Copy the positions and normals into the SoA arrays.
+ * This has to be called once the vertices are built.
+ */
+void UnitMesh::buildSoA() {
+	int n = vertices.size();
+	soa.resize(n * 6);
+	for (int i = 0; i < n; ++i) {
+		soa[i] = vertices[i].position.x;
+		soa[n + i] = vertices[i].position.y;
+		soa[n * 2 + i] = vertices[i].position.z;
+		soa[n * 3 + i] = vertices[i].normal.x;
+		soa[n * 4 + i] = vertices[i].normal.y;
+		soa[n * 5 + i] = vertices[i].normal.z;
+	}
+}
+
+void UnitMesh::instantiate(const glm::mat4& mat, const glm::vec3& scale, const glm::vec4& color, std::vector<Vertex>& vertices) const {
+	int n = this->vertices.size();
+	if (n == 0) return;
+
+	int first = vertices.size();
+	vertices.insert(vertices.end(), this->vertices.begin(), this->vertices.end());
+	for (int i = first; i < vertices.size(); ++i) {
+		vertices[i].color = color;
+	}
+
+	const float* soa[6] = { &this->soa[0], &this->soa[n], &this->soa[n * 2], &this->soa[n * 3], &this->soa[n * 4], &this->soa[n * 5] };
+	glutils::transformVertices(glm::scale(mat, scale), mat, soa, &vertices[first], n);
+}
+
+void UnitMesh::instantiate(const glm::mat4& mat, const glm::vec3& scale, const glm::vec4& color, const glm::vec2& uvScale, const glm::vec2& uvOffset, std::vector<Vertex>& vertices) const {
+	int n = this->vertices.size();
+	if (n == 0) return;
+
+	int first = vertices.size();
+	vertices.insert(vertices.end(), this->vertices.begin(), this->vertices.end());
+	for (int i = first; i < vertices.size(); ++i) {
+		vertices[i].color = color;
+		vertices[i].texCoord = vertices[i].texCoord * uvScale + uvOffset;
+	}
+
+	const float* soa[6] = { &this->soa[0], &this->soa[n], &this->soa[n * 2], &this->soa[n * 3], &this->soa[n * 4], &this->soa[n * 5] };
+	glutils::transformVertices(glm::scale(mat, scale), mat, soa, &vertices[first], n);
+}
+
+/**
+ * Unit circle of radius 1 centered at the origin on the XY plane.
+ * The texture coordinates are (cos + 1, sin + 1), which are scaled by (r / texWidth, r / texHeight).
+ */
+boost::shared_ptr<const UnitMesh> UnitMeshCache::circle(int slices) {
+	return get(TYPE_CIRCLE, slices, 0, 0.0f);
+}
+
+/**
+ * Unit semicircle inscribed in [0, 1] x [0, 1] on the XY plane.
+ */
+boost::shared_ptr<const UnitMesh> UnitMeshCache::semiCircle(int slices) {
+	return get(TYPE_SEMICIRCLE, slices, 0, 0.0f);
+}
+
+/**
+ * Unit hemisphere inscribed in [0, 2] x [0, 2] x [0, 1].
+ * The texture coordinates are (j / slices, i / stacks).
+ */
+boost::shared_ptr<const UnitMesh> UnitMeshCache::hemisphere(int slices, int stacks) {
+	return get(TYPE_HEMISPHERE, slices, stacks, 0.0f);
+}
+
+/**
+ * Side of the unit cylinder along Z axis, whose height is 1.
+ * If flipped is true, the normals face inside as drawCylinderZ() does for a negative height.
+ */
+boost::shared_ptr<const UnitMesh> UnitMeshCache::cylinderZ(int slices, bool flipped) {
+	return get(TYPE_CYLINDER_Z, slices, 0, flipped ? 1.0f : 0.0f);
+}
+
+/**
+ * Side of the unit cylinder along Y axis, which starts at the origin and sweeps the specified angle.
+ * The texture coordinates are (i / slices, 0 or 1).
+ */
+boost::shared_ptr<const UnitMesh> UnitMeshCache::cylinderSide(int slices, float angle) {
+	return get(TYPE_CYLINDER_SIDE, slices, 0, angle);
+}
+
+void UnitMeshCache::clear() {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.clear();
+}
+
+boost::shared_ptr<const UnitMesh> UnitMeshCache::get(int type, int slices, int stacks, float param) {
+	UnitMeshKey key(type, slices, stacks, param);
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		std::map<UnitMeshKey, boost::shared_ptr<const UnitMesh> >::const_iterator it = cache.find(key);
+		if (it != cache.end()) return it->second;
+	}
+
+	// build the mesh outside the lock
+	boost::shared_ptr<UnitMesh> mesh(new UnitMesh());
+	switch (type) {
+	case TYPE_CIRCLE:
+		buildCircle(slices, *mesh);
+		break;
+	case TYPE_SEMICIRCLE:
+		buildSemiCircle(slices, *mesh);
+		break;
+	case TYPE_HEMISPHERE:
+		buildHemisphere(slices, stacks, *mesh);
+		break;
+	case TYPE_CYLINDER_Z:
+		buildCylinderZ(slices, param != 0.0f, *mesh);
+		break;
+	case TYPE_CYLINDER_SIDE:
+		buildCylinderSide(slices, param, *mesh);
+		break;
+	default:
+		throw "Unknown unit mesh type.";
+	}
+	mesh->buildSoA();
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::map<UnitMeshKey, boost::shared_ptr<const UnitMesh> >::const_iterator it = cache.find(key);
+	if (it != cache.end()) return it->second;
+
+	// the angle of the cylinder side is continuous, so do not let the cache grow unbounded
+	if (cache.size() < MAX_ENTRIES) {
+		cache[key] = mesh;
+	}
+	return mesh;
+}
+
+void UnitMeshCache::buildCircle(int slices, UnitMesh& mesh) {
+	glm::vec3 n(0, 0, 1);
+
+	mesh.vertices.reserve(slices * 3);
+	for (int i = 0; i < slices; ++i) {
+		float theta1 = (float)i / slices * M_PI * 2.0f;
+		float theta2 = (float)(i + 1) / slices * M_PI * 2.0f;
+
+		glm::vec3 p2(cosf(theta1), sinf(theta1), 0);
+		glm::vec3 p3(cosf(theta2), sinf(theta2), 0);
+
+		mesh.vertices.push_back(Vertex(glm::vec3(0, 0, 0), n, glm::vec4(1, 1, 1, 1), glm::vec2(1, 1)));
+		mesh.vertices.push_back(Vertex(p2, n, glm::vec4(1, 1, 1, 1), glm::vec2(p2.x + 1, p2.y + 1), 1));
+		mesh.vertices.push_back(Vertex(p3, n, glm::vec4(1, 1, 1, 1), glm::vec2(p3.x + 1, p3.y + 1), 1));
+	}
+}
+
+void UnitMeshCache::buildSemiCircle(int slices, UnitMesh& mesh) {
+	glm::vec3 p0(0.5f, 0, 0);
+	glm::vec3 n(0, 0, 1);
+
+	mesh.vertices.reserve(slices * 3);
+	for (int i = 0; i < slices; ++i) {
+		float theta1 = (float)i / slices * M_PI;
+		float theta2 = (float)(i + 1) / slices * M_PI;
+
+		glm::vec3 p1(0.5f * cosf(theta1) + 0.5f, sinf(theta1), 0.0f);
+		glm::vec3 p2(0.5f * cosf(theta2) + 0.5f, sinf(theta2), 0.0f);
+
+		mesh.vertices.push_back(Vertex(p0, n, glm::vec4(1, 1, 1, 1), glm::vec2(p0)));
+		mesh.vertices.push_back(Vertex(p1, n, glm::vec4(1, 1, 1, 1), glm::vec2(p1), 1));
+		mesh.vertices.push_back(Vertex(p2, n, glm::vec4(1, 1, 1, 1), glm::vec2(p2), i > 0 ? 1 : 0));
+	}
+}
+
+void UnitMeshCache::buildHemisphere(int slices, int stacks, UnitMesh& mesh) {
+	mesh.vertices.reserve(slices * stacks * 6);
+	for (int i = 0; i < stacks; ++i) {
+		float theta1 = (float)i / stacks * M_PI * 0.5f;
+		float theta2 = (float)(i + 1) / stacks * M_PI * 0.5f;
+
+		for (int j = 0; j < slices; ++j) {
+			float phi1 = (float)j / slices * M_PI * 2.0f;
+			float phi2 = (float)(j + 1) / slices * M_PI * 2.0f;
+
+			glm::vec3 p1(cosf(theta1) * cosf(phi1) + 1, cosf(theta1) * sinf(phi1) + 1, sinf(theta1));
+			glm::vec3 p2(cosf(theta1) * cosf(phi2) + 1, cosf(theta1) * sinf(phi2) + 1, sinf(theta1));
+			glm::vec3 p3(cosf(theta2) * cosf(phi2) + 1, cosf(theta2) * sinf(phi2) + 1, sinf(theta2));
+			glm::vec3 p4(cosf(theta2) * cosf(phi1) + 1, cosf(theta2) * sinf(phi1) + 1, sinf(theta2));
+
+			// keep the normals of the upper ring identical to the original tessellation
+			glm::vec3 n1(cosf(theta1) * cosf(phi1), cosf(theta1) * sinf(phi1), sinf(theta1));
+			glm::vec3 n2(cosf(theta1) * cosf(phi2), cosf(theta1) * sinf(phi2), sinf(theta1));
+			glm::vec3 n3(cosf(theta2) * cosf(phi2), cosf(theta2) * sinf(phi2), sinf(theta1));
+			glm::vec3 n4(cosf(theta2) * cosf(phi1), cosf(theta2) * sinf(phi1), sinf(theta1));
+
+			glm::vec2 t1((float)j / slices, (float)i / stacks);
+			glm::vec2 t2((float)(j + 1) / slices, (float)i / stacks);
+			glm::vec2 t3((float)(j + 1) / slices, (float)(i + 1) / stacks);
+			glm::vec2 t4((float)j / slices, (float)(i + 1) / stacks);
+
+			mesh.vertices.push_back(Vertex(p1, n1, glm::vec4(1, 1, 1, 1), t1));
+			mesh.vertices.push_back(Vertex(p2, n2, glm::vec4(1, 1, 1, 1), t2));
+			mesh.vertices.push_back(Vertex(p3, n3, glm::vec4(1, 1, 1, 1), t3));
+
+			mesh.vertices.push_back(Vertex(p1, n1, glm::vec4(1, 1, 1, 1), t1));
+			mesh.vertices.push_back(Vertex(p3, n3, glm::vec4(1, 1, 1, 1), t3));
+			mesh.vertices.push_back(Vertex(p4, n4, glm::vec4(1, 1, 1, 1), t4));
+		}
+	}
+}
+
+void UnitMeshCache::buildCylinderZ(int slices, bool flipped, UnitMesh& mesh) {
+	float phi = atan2(0.0f, flipped ? -1.0f : 1.0f);
+
+	mesh.vertices.reserve(slices * 6);
+	for (int i = 0; i < slices; ++i) {
+		float theta1 = M_PI * 2.0 * (float)i / slices;
+		float theta2 = M_PI * 2.0 * (float)(i + 1) / slices;
+
+		glm::vec3 p1(cosf(theta1), sinf(theta1), 0);
+		glm::vec3 p2(cosf(theta2), sinf(theta2), 0);
+		glm::vec3 p3(cosf(theta2), sinf(theta2), 1);
+		glm::vec3 p4(cosf(theta1), sinf(theta1), 1);
+		glm::vec3 n1(cosf(theta1) * cosf(phi), sinf(theta1) * cosf(phi), sinf(phi));
+		glm::vec3 n2(cosf(theta2) * cosf(phi), sinf(theta2) * cosf(phi), sinf(phi));
+
+		mesh.vertices.push_back(Vertex(p1, n1, glm::vec4(1, 1, 1, 1)));
+		mesh.vertices.push_back(Vertex(p2, n2, glm::vec4(1, 1, 1, 1), 1));
+		mesh.vertices.push_back(Vertex(p3, n2, glm::vec4(1, 1, 1, 1)));
+
+		mesh.vertices.push_back(Vertex(p1, n1, glm::vec4(1, 1, 1, 1)));
+		mesh.vertices.push_back(Vertex(p3, n2, glm::vec4(1, 1, 1, 1)));
+		mesh.vertices.push_back(Vertex(p4, n1, glm::vec4(1, 1, 1, 1), 1));
+	}
+}
+
+void UnitMeshCache::buildCylinderSide(int slices, float angle, UnitMesh& mesh) {
+	mesh.vertices.reserve(slices * 6);
+	for (int i = 0; i < slices; ++i) {
+		float theta1 = (float)i / slices * angle;
+		float theta2 = (float)(i + 1) / slices * angle;
+
+		glm::vec3 p1(sinf(theta1), 0, cosf(theta1) - 1);
+		glm::vec3 p2(sinf(theta2), 0, cosf(theta2) - 1);
+		glm::vec3 p3(sinf(theta2), 1, cosf(theta2) - 1);
+		glm::vec3 p4(sinf(theta1), 1, cosf(theta1) - 1);
+		glm::vec3 n1(sinf(theta1), 0, cosf(theta1));
+		glm::vec3 n2(sinf(theta2), 0, cosf(theta2));
+
+		glm::vec2 t1((float)i / slices, 0);
+		glm::vec2 t2((float)(i + 1) / slices, 0);
+		glm::vec2 t3((float)(i + 1) / slices, 1);
+		glm::vec2 t4((float)i / slices, 1);
+
+		mesh.vertices.push_back(Vertex(p1, n1, glm::vec4(1, 1, 1, 1), t1));
+		mesh.vertices.push_back(Vertex(p2, n2, glm::vec4(1, 1, 1, 1), t2));
+		mesh.vertices.push_back(Vertex(p3, n2, glm::vec4(1, 1, 1, 1), t3));
+
+		mesh.vertices.push_back(Vertex(p1, n1, glm::vec4(1, 1, 1, 1), t1));
+		mesh.vertices.push_back(Vertex(p3, n2, glm::vec4(1, 1, 1, 1), t3));
+		mesh.vertices.push_back(Vertex(p4, n1, glm::vec4(1, 1, 1, 1), t4));
+	}
+}
+
+}
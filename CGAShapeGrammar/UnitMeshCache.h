@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "Vertex.h"
+
+namespace cga {
+
+/**
+ * Tessellation of a curved primitive in its unit space.
+ * Positions are normalized to the scope of the shape, so that a shape only has to
+ * apply (mat * scale) to the positions and mat to the normals.
+ */
+class UnitMesh {
+public:
+	std::vector<Vertex> vertices;
+	/** positions and normals in SoA layout (x[], y[], z[], nx[], ny[], nz[]) for the batched transformation */
+	std::vector<float> soa;
+
+public:
+	UnitMesh() {}
+	void buildSoA();
+	void instantiate(const glm::mat4& mat, const glm::vec3& scale, const glm::vec4& color, std::vector<Vertex>& vertices) const;
+	void instantiate(const glm::mat4& mat, const glm::vec3& scale, const glm::vec4& color, const glm::vec2& uvScale, const glm::vec2& uvOffset, std::vector<Vertex>& vertices) const;
+};
+
+/**
+ * Process-wide cache of the unit meshes of the curved primitives.
+ * A unit mesh is built once per (primitive type, slices, stacks, parameter), and is never
+ * modified afterwards, so that it can be shared by all the shapes.
+ */
+class UnitMeshCache {
+public:
+	enum { TYPE_CIRCLE = 0, TYPE_SEMICIRCLE, TYPE_HEMISPHERE, TYPE_CYLINDER_Z, TYPE_CYLINDER_SIDE };
+
+	/** the maximum number of the cached meshes per process */
+	static const int MAX_ENTRIES = 4096;
+
+protected:
+	UnitMeshCache() {}
+
+public:
+	static boost::shared_ptr<const UnitMesh> circle(int slices);
+	static boost::shared_ptr<const UnitMesh> semiCircle(int slices);
+	static boost::shared_ptr<const UnitMesh> hemisphere(int slices, int stacks);
+	static boost::shared_ptr<const UnitMesh> cylinderZ(int slices, bool flipped);
+	static boost::shared_ptr<const UnitMesh> cylinderSide(int slices, float angle);
+	static void clear();
+
+private:
+	static boost::shared_ptr<const UnitMesh> get(int type, int slices, int stacks, float param);
+	static void buildCircle(int slices, UnitMesh& mesh);
+	static void buildSemiCircle(int slices, UnitMesh& mesh);
+	static void buildHemisphere(int slices, int stacks, UnitMesh& mesh);
+	static void buildCylinderZ(int slices, bool flipped, UnitMesh& mesh);
+	static void buildCylinderSide(int slices, float angle, UnitMesh& mesh);
+};
+
+}
@@ -0,0 +1,381 @@
+#include "VertexTransform.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define GLUTILS_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// gcc/clang need the target attributes to emit the wider instructions without global compiler flags.
+#if defined(GLUTILS_SIMD_X86) && defined(__GNUC__)
+#define GLUTILS_TARGET_SSE __attribute__((target("sse2")))
+#define GLUTILS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GLUTILS_TARGET_SSE
+#define GLUTILS_TARGET_AVX2
+#endif
+
+namespace glutils {
+
+namespace {
+
+/** the number of vertices gathered into the SoA buffers at once */
+const int BLOCK_SIZE = 256;
+
+/**
+ * The first three rows of the affine matrix.
+ * The translation is replaced by 0 for directions.
+ */
+struct AffineRows {
+	float m[3][4];
+
+	AffineRows(const glm::mat4& mat, bool point) {
+		for (int r = 0; r < 3; ++r) {
+			m[r][0] = mat[0][r];
+			m[r][1] = mat[1][r];
+			m[r][2] = mat[2][r];
+			m[r][3] = point ? mat[3][r] : 0.0f;
+		}
+	}
+};
+
+typedef void (*TransformKernel)(const AffineRows& rows, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n);
+
+/**
+ * The order of the operations follows glm's mat4 * vec4, i.e., (m0 * x + m1 * y) + (m2 * z + m3).
+ */
+void transformScalar(const AffineRows& rows, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n) {
+	for (int i = 0; i < n; ++i) {
+		float px = x[i];
+		float py = y[i];
+		float pz = z[i];
+		outX[i] = (rows.m[0][0] * px + rows.m[0][1] * py) + (rows.m[0][2] * pz + rows.m[0][3]);
+		outY[i] = (rows.m[1][0] * px + rows.m[1][1] * py) + (rows.m[1][2] * pz + rows.m[1][3]);
+		outZ[i] = (rows.m[2][0] * px + rows.m[2][1] * py) + (rows.m[2][2] * pz + rows.m[2][3]);
+	}
+}
+
+#ifdef GLUTILS_SIMD_X86
+
+GLUTILS_TARGET_SSE
+void transformSSE(const AffineRows& rows, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n) {
+	__m128 m[3][4];
+	for (int r = 0; r < 3; ++r) {
+		for (int c = 0; c < 4; ++c) {
+			m[r][c] = _mm_set1_ps(rows.m[r][c]);
+		}
+	}
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		__m128 r[3];
+		for (int k = 0; k < 3; ++k) {
+			__m128 a = _mm_add_ps(_mm_mul_ps(m[k][0], px), _mm_mul_ps(m[k][1], py));
+			__m128 b = _mm_add_ps(_mm_mul_ps(m[k][2], pz), m[k][3]);
+			r[k] = _mm_add_ps(a, b);
+		}
+		_mm_storeu_ps(outX + i, r[0]);
+		_mm_storeu_ps(outY + i, r[1]);
+		_mm_storeu_ps(outZ + i, r[2]);
+	}
+
+	transformScalar(rows, x + i, y + i, z + i, outX + i, outY + i, outZ + i, n - i);
+}
+
+GLUTILS_TARGET_AVX2
+void transformAVX2(const AffineRows& rows, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n) {
+	__m256 m[3][4];
+	for (int r = 0; r < 3; ++r) {
+		for (int c = 0; c < 4; ++c) {
+			m[r][c] = _mm256_set1_ps(rows.m[r][c]);
+		}
+	}
+
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 px = _mm256_loadu_ps(x + i);
+		__m256 py = _mm256_loadu_ps(y + i);
+		__m256 pz = _mm256_loadu_ps(z + i);
+		__m256 r[3];
+		for (int k = 0; k < 3; ++k) {
+			// no FMA, so that the results match the scalar kernel
+			__m256 a = _mm256_add_ps(_mm256_mul_ps(m[k][0], px), _mm256_mul_ps(m[k][1], py));
+			__m256 b = _mm256_add_ps(_mm256_mul_ps(m[k][2], pz), m[k][3]);
+			r[k] = _mm256_add_ps(a, b);
+		}
+		_mm256_storeu_ps(outX + i, r[0]);
+		_mm256_storeu_ps(outY + i, r[1]);
+		_mm256_storeu_ps(outZ + i, r[2]);
+	}
+	_mm256_zeroupper();
+
+	transformSSE(rows, x + i, y + i, z + i, outX + i, outY + i, outZ + i, n - i);
+}
+
+#endif
+
+TransformKernel kernelForLevel(int level) {
+#ifdef GLUTILS_SIMD_X86
+	if (level >= SIMD_AVX2) return transformAVX2;
+	if (level >= SIMD_SSE) return transformSSE;
+#endif
+	return transformScalar;
+}
+
+// selected once at startup, and can be overridden by setSimdLevel()
+int currentLevel = detectSimdLevel();
+TransformKernel kernel = kernelForLevel(currentLevel);
+
+/**
+ * Gather the positions and normals into the SoA buffers, transform them, and scatter them back.
+ * Both are gathered in a single pass, so that each vertex is touched only twice.
+ */
+void transformBlock(const AffineRows& pointRows, const AffineRows& normalRows, Vertex* vertices, int n) {
+	float soa[6][BLOCK_SIZE];
+
+	for (int i = 0; i < n; ++i) {
+		soa[0][i] = vertices[i].position.x;
+		soa[1][i] = vertices[i].position.y;
+		soa[2][i] = vertices[i].position.z;
+		soa[3][i] = vertices[i].normal.x;
+		soa[4][i] = vertices[i].normal.y;
+		soa[5][i] = vertices[i].normal.z;
+	}
+
+	kernel(pointRows, soa[0], soa[1], soa[2], soa[0], soa[1], soa[2], n);
+	kernel(normalRows, soa[3], soa[4], soa[5], soa[3], soa[4], soa[5], n);
+
+	for (int i = 0; i < n; ++i) {
+		vertices[i].position.x = soa[0][i];
+		vertices[i].position.y = soa[1][i];
+		vertices[i].position.z = soa[2][i];
+		vertices[i].normal.x = soa[3][i];
+		vertices[i].normal.y = soa[4][i];
+		vertices[i].normal.z = soa[5][i];
+	}
+}
+
+}
+
+/**
+ * Return the instruction set used by the transformation kernels.
+ */
+int simdLevel() {
+	return currentLevel;
+}
+
+/**
+ * Return the widest instruction set supported by both the CPU and the OS.
+ */
+int detectSimdLevel() {
+#if defined(GLUTILS_SIMD_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxId = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	bool avx2 = false;
+	if (maxId >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2) return SIMD_AVX2;
+	if (sse2) return SIMD_SSE;
+	return SIMD_SCALAR;
+#elif defined(GLUTILS_SIMD_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2")) return SIMD_SSE;
+	return SIMD_SCALAR;
+#else
+	return SIMD_SCALAR;
+#endif
+}
+
+/**
+ * Override the instruction set. The level is clamped to the one supported by the CPU.
+ */
+void setSimdLevel(int level) {
+	currentLevel = std::max((int)SIMD_SCALAR, std::min(level, detectSimdLevel()));
+	kernel = kernelForLevel(currentLevel);
+}
+
+const char* simdLevelName(int level) {
+	if (level == SIMD_AVX2) return "AVX2";
+	else if (level == SIMD_SSE) return "SSE";
+	else return "scalar";
+}
+
+void transformPoints(const glm::mat4& mat, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n) {
+	kernel(AffineRows(mat, true), x, y, z, outX, outY, outZ, n);
+}
+
+void transformDirections(const glm::mat4& mat, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n) {
+	kernel(AffineRows(mat, false), x, y, z, outX, outY, outZ, n);
+}
+
+/**
+ * Transform the AoS points. points and outPoints can be the same array.
+ */
+void transformPoints(const glm::mat4& mat, const glm::vec3* points, glm::vec3* outPoints, int n) {
+	AffineRows rows(mat, true);
+	float x[BLOCK_SIZE];
+	float y[BLOCK_SIZE];
+	float z[BLOCK_SIZE];
+
+	for (int start = 0; start < n; start += BLOCK_SIZE) {
+		int count = std::min(BLOCK_SIZE, n - start);
+		for (int i = 0; i < count; ++i) {
+			x[i] = points[start + i].x;
+			y[i] = points[start + i].y;
+			z[i] = points[start + i].z;
+		}
+		kernel(rows, x, y, z, x, y, z, count);
+		for (int i = 0; i < count; ++i) {
+			outPoints[start + i] = glm::vec3(x[i], y[i], z[i]);
+		}
+	}
+}
+
+/**
+ * Transform the positions by pointMat and the normals by normalMat in place.
+ */
+void transformVertices(const glm::mat4& pointMat, const glm::mat4& normalMat, Vertex* vertices, int n) {
+	AffineRows pointRows(pointMat, true);
+	AffineRows normalRows(normalMat, false);
+
+	for (int start = 0; start < n; start += BLOCK_SIZE) {
+		transformBlock(pointRows, normalRows, vertices + start, std::min(BLOCK_SIZE, n - start));
+	}
+}
+
+void transformVertices(const glm::mat4& pointMat, const glm::mat4& normalMat, std::vector<Vertex>& vertices, int first) {
+	if (first >= vertices.size()) return;
+	transformVertices(pointMat, normalMat, &vertices[first], vertices.size() - first);
+}
+
+/**
+ * Transform the SoA positions (soa[0..2]) and normals (soa[3..5]), and write them to the vertices.
+ * The other attributes of the vertices are not changed. This avoids the gather step of the AoS version,
+ * so use this for the geometry that is stored in SoA form in advance.
+ */
+void transformVertices(const glm::mat4& pointMat, const glm::mat4& normalMat, const float* const soa[6], Vertex* outVertices, int n) {
+	AffineRows pointRows(pointMat, true);
+	AffineRows normalRows(normalMat, false);
+	float out[6][BLOCK_SIZE];
+
+	for (int start = 0; start < n; start += BLOCK_SIZE) {
+		int count = std::min(BLOCK_SIZE, n - start);
+		kernel(pointRows, soa[0] + start, soa[1] + start, soa[2] + start, out[0], out[1], out[2], count);
+		kernel(normalRows, soa[3] + start, soa[4] + start, soa[5] + start, out[3], out[4], out[5], count);
+
+		Vertex* v = outVertices + start;
+		for (int i = 0; i < count; ++i) {
+			v[i].position.x = out[0][i];
+			v[i].position.y = out[1][i];
+			v[i].position.z = out[2][i];
+			v[i].normal.x = out[3][i];
+			v[i].normal.y = out[4][i];
+			v[i].normal.z = out[5][i];
+		}
+	}
+}
+
+
+/**
+ * Compare the per-vertex glm transformation with the batched kernels, and print the results.
+ * The buffer is transformed in place repeatedly, so that only the transformation is measured.
+ */
+void benchmarkVertexTransform(int numVertices, int numIterations) {
+	std::vector<Vertex> source(numVertices);
+	for (int i = 0; i < numVertices; ++i) {
+		source[i] = Vertex(glm::vec3(i % 97, i % 89, i % 83) * 0.1f, glm::normalize(glm::vec3(1 + i % 7, 1 + i % 5, 1 + i % 3)));
+	}
+	// rotation and translation, which keeps the length of the normals through the iterations so that they do not become denormal
+	float c = cosf(0.1f);
+	float s = sinf(0.1f);
+	glm::mat4 mat = glm::mat4(c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 3.0f, -2.0f, 5.0f, 1.0f);
+
+	std::cout << "Vertex transform benchmark: " << numVertices << " vertices x " << numIterations << " iterations" << std::endl;
+
+	// per-vertex glm
+	std::vector<Vertex> expected = source;
+	for (int i = 0; i < numVertices; ++i) {
+		expected[i].position = glm::vec3(mat * glm::vec4(expected[i].position, 1));
+		expected[i].normal = glm::vec3(mat * glm::vec4(expected[i].normal, 0));
+	}
+	{
+		std::vector<Vertex> vertices = source;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int iter = 0; iter < numIterations; ++iter) {
+			for (int i = 0; i < numVertices; ++i) {
+				vertices[i].position = glm::vec3(mat * glm::vec4(vertices[i].position, 1));
+				vertices[i].normal = glm::vec3(mat * glm::vec4(vertices[i].normal, 0));
+			}
+		}
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  glm per vertex: " << elapsed / numIterations << " ms" << std::endl;
+	}
+
+	int origLevel = currentLevel;
+	for (int level = SIMD_SCALAR; level <= detectSimdLevel(); ++level) {
+		setSimdLevel(level);
+
+		// check the results against glm
+		std::vector<Vertex> vertices = source;
+		transformVertices(mat, mat, vertices);
+		int mismatches = 0;
+		for (int i = 0; i < numVertices; ++i) {
+			if (vertices[i].position != expected[i].position || vertices[i].normal != expected[i].normal) mismatches++;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int iter = 0; iter < numIterations; ++iter) {
+			transformVertices(mat, mat, vertices);
+		}
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  batched " << simdLevelName(level) << " (AoS in place): " << elapsed / numIterations << " ms (" << mismatches << " mismatches)" << std::endl;
+	}
+
+	// SoA source to AoS output, which is the case of the cached unit meshes
+	std::vector<std::vector<float> > soa(6, std::vector<float>(numVertices));
+	for (int i = 0; i < numVertices; ++i) {
+		for (int k = 0; k < 3; ++k) {
+			soa[k][i] = source[i].position[k];
+			soa[k + 3][i] = source[i].normal[k];
+		}
+	}
+	const float* soaPtrs[6] = { &soa[0][0], &soa[1][0], &soa[2][0], &soa[3][0], &soa[4][0], &soa[5][0] };
+	for (int level = SIMD_SCALAR; level <= detectSimdLevel(); ++level) {
+		setSimdLevel(level);
+
+		std::vector<Vertex> vertices = source;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int iter = 0; iter < numIterations; ++iter) {
+			transformVertices(mat, mat, soaPtrs, &vertices[0], numVertices);
+		}
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		int mismatches = 0;
+		for (int i = 0; i < numVertices; ++i) {
+			if (vertices[i].position != expected[i].position || vertices[i].normal != expected[i].normal) mismatches++;
+		}
+		std::cout << "  batched " << simdLevelName(level) << " (SoA to AoS): " << elapsed / numIterations << " ms (" << mismatches << " mismatches)" << std::endl;
+	}
+	setSimdLevel(origLevel);
+}
+
+}
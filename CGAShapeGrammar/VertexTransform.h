@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Vertex.h"
+
+namespace glutils {
+
+enum { SIMD_SCALAR = 0, SIMD_SSE, SIMD_AVX2 };
+
+/**
+ * Batched affine transformation of positions and normals.
+ * The kernels work on SoA arrays (x[], y[], z[]), and the widest instruction set supported
+ * by the CPU is selected at runtime. All the kernels perform the same multiplications and
+ * additions in the same order as glm's mat4 * vec4 without FMA, so that the results are
+ * bit-identical regardless of the selected instruction set.
+ */
+int simdLevel();
+int detectSimdLevel();
+void setSimdLevel(int level);
+const char* simdLevelName(int level);
+
+void transformPoints(const glm::mat4& mat, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n);
+void transformDirections(const glm::mat4& mat, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, int n);
+void transformPoints(const glm::mat4& mat, const glm::vec3* points, glm::vec3* outPoints, int n);
+void transformVertices(const glm::mat4& pointMat, const glm::mat4& normalMat, Vertex* vertices, int n);
+void transformVertices(const glm::mat4& pointMat, const glm::mat4& normalMat, std::vector<Vertex>& vertices, int first = 0);
+void transformVertices(const glm::mat4& pointMat, const glm::mat4& normalMat, const float* const soa[6], Vertex* outVertices, int n);
+
+void benchmarkVertexTransform(int numVertices, int numIterations);
+
+}
@@ -1,8 +1,24 @@
 #include "MainWindow.h"
 #include <QtWidgets/QApplication>
+#include <cstdlib>
+#include "VertexTransform.h"
 
 int main(int argc, char *argv[])
 {
+	// worker process of GLWidget3D::generateBuildingImages(), which needs no window
+	if (argc == 8 && QString(argv[1]) == "--ring-worker") {
+		QCoreApplication a(argc, argv);
+		return GLWidget3D::runRingWorker(argv[2], atoi(argv[3]), atoi(argv[4]), atoi(argv[5]), atoi(argv[6]), atoi(argv[7]));
+	}
+
+	// microbenchmark of the batched vertex transformation for each instruction set
+	if (argc >= 2 && QString(argv[1]) == "--benchmark-vertex-transform") {
+		int numVertices = argc >= 3 ? atoi(argv[2]) : 1000000;
+		int numIterations = argc >= 4 ? atoi(argv[3]) : 20;
+		glutils::benchmarkVertexTransform(numVertices, numIterations);
+		return 0;
+	}
+
 	QApplication a(argc, argv);
 	MainWindow w;
 	w.show();
@@ -5,18 +5,36 @@ layout(location = 1)in vec3 normal;
 layout(location = 2)in vec4 color;
 layout(location = 3)in vec2 uv;
 
+// per-instance attributes for the instanced draw
+layout(location = 5)in mat4 instanceModelMat;
+layout(location = 9)in vec4 instanceColor;
+layout(location = 10)in vec4 instanceUVTransform;
+layout(location = 11)in float instanceUVFromPosition;
+
 out vec4 outColor;
 out vec2 outUV;
 out vec3 origVertex;
 out vec3 varyingNormal;
 
 uniform mat4 mvpMatrix;
+uniform int instanced;
 
 void main(){
-	outColor=color;
-	outUV=uv;
-	origVertex=vertex;
-	varyingNormal=normal;
+	if (instanced == 1) {
+		// the normals keep facing the same side of the triangles even if the instance is mirrored
+		mat3 normalMat = transpose(inverse(mat3(instanceModelMat)));
+		if (determinant(mat3(instanceModelMat)) < 0.0) normalMat = -normalMat;
+
+		outColor=instanceColor;
+		outUV=(instanceUVFromPosition > 0.5 ? vertex.xy : uv) * instanceUVTransform.xy + instanceUVTransform.zw;
+		origVertex=(instanceModelMat * vec4(vertex, 1.0)).xyz;
+		varyingNormal=normalize(normalMat * normal);
+	} else {
+		outColor=color;
+		outUV=uv;
+		origVertex=vertex;
+		varyingNormal=normal;
+	}
 
 	gl_Position = mvpMatrix * vec4(origVertex,1.0);
 